@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include "src/render/mesh/culling.hpp"
+
+/**
+ * Times `BoundingSpheres::test` on 100k random instances and checks its results against a double precision
+ * reference. The kernel is picked at compile time, so each of its paths is built into a separate executable.
+ */
+
+using namespace zrx;
+
+static constexpr size_t SPHERE_COUNT = 100'000;
+static constexpr size_t WARMUP_RUNS = 10;
+static constexpr size_t TIMED_RUNS = 1000;
+
+// spheres this close to touching a plane might be classified either way, due to the kernels' rounding
+static constexpr double BOUNDARY_EPSILON = 1e-3;
+
+static const char *get_kernel_name() {
+#if defined(ZRX_CULLING_NO_SIMD)
+    return "scalar";
+#elif defined(__AVX__)
+    return "avx";
+#else
+    return "sse";
+#endif
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord_dist(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> radius_dist(0.1f, 2.0f);
+
+    BoundingSpheres spheres;
+    vector<glm::vec4> reference_spheres;
+
+    for (size_t i = 0; i < SPHERE_COUNT; i++) {
+        const glm::vec4 sphere{coord_dist(rng), coord_dist(rng), coord_dist(rng), radius_dist(rng)};
+        spheres.push_back(sphere);
+        reference_spheres.push_back(sphere);
+    }
+
+    const glm::mat4 view = glm::lookAt(glm::vec3(0, 0, -50), glm::vec3(0), glm::vec3(0, 1, 0));
+    const glm::mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    const Frustum frustum = Frustum::from_matrix(proj * view);
+
+    vector<uint8_t> visible;
+
+    for (size_t i = 0; i < WARMUP_RUNS; i++) {
+        spheres.test(frustum, visible);
+    }
+
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < TIMED_RUNS; i++) {
+        spheres.test(frustum, visible);
+    }
+
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+
+    size_t visible_count = 0;
+    size_t mismatch_count = 0;
+
+    for (size_t i = 0; i < SPHERE_COUNT; i++) {
+        const auto &sphere = reference_spheres[i];
+        bool is_visible = true;
+        double min_margin = std::numeric_limits<double>::max();
+
+        for (const auto &plane: frustum.planes) {
+            const double distance = static_cast<double>(plane.x) * sphere.x + static_cast<double>(plane.y) * sphere.y
+                                    + static_cast<double>(plane.z) * sphere.z + plane.w;
+
+            is_visible = is_visible && distance >= -sphere.w;
+            min_margin = std::min(min_margin, std::abs(distance + sphere.w));
+        }
+
+        visible_count += is_visible;
+
+        if (static_cast<bool>(visible[i]) != is_visible && min_margin > BOUNDARY_EPSILON) {
+            mismatch_count++;
+        }
+    }
+
+    std::cout << get_kernel_name() << ": " << SPHERE_COUNT << " spheres in "
+            << static_cast<double>(nanos) / TIMED_RUNS / 1e6 << " ms per test, "
+            << visible_count << " visible, " << mismatch_count << " mismatches against the reference" << std::endl;
+
+    return mismatch_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "src/render/graph.hpp"
+#include "src/render/graph-plan.hpp"
+
+/**
+ * Times `RenderGraph::compile` on synthetic graphs of increasing size, which doesn't need a device. Every node
+ * renders to a texture of its own while sampling the textures of the previous node and of a random earlier one,
+ * so that the graph is a single chain ending in the final image, with extra edges skipping over parts of it.
+ *
+ * Startup with and without a cached plan is compared too, covering the plan key, loading or saving the plan
+ * and compiling. The parts of the plan which need a device, i.e. reflected pipeline layouts, memory aliasing
+ * blocks and barrier schedules, are left out, so the difference is a lower bound of what the cache saves.
+ */
+
+using namespace zrx;
+
+static constexpr size_t GRAPH_SIZES[] = {10, 100, 1000, 5000};
+static constexpr size_t RUNS_PER_SIZE = 5;
+
+// the plan key hashes the contents of every pipeline's shaders, which are about this large in practice
+static constexpr size_t SHADER_SIZE = 16 * 1024;
+
+static RenderGraph build_graph(const size_t node_count, const std::filesystem::path &shader_path, std::mt19937 &rng) {
+    RenderGraph graph;
+    vector<ResourceHandle> textures;
+
+    for (size_t i = 0; i < node_count; i++) {
+        ShaderPack::DescriptorSetDescription sampled_textures;
+
+        if (i > 0) {
+            sampled_textures.emplace_back(textures[i - 1]);
+            sampled_textures.emplace_back(textures[std::uniform_int_distribution<size_t>(0, i - 1)(rng)]);
+        }
+
+        // the shader is never loaded, since compiling the graph only looks at its bindings
+        const auto pipeline = graph.add_pipeline({
+            std::filesystem::path(shader_path),
+            std::filesystem::path(shader_path),
+            {sampled_textures},
+            ScreenSpaceQuadVertex(),
+            {vk::Format::eR8G8B8A8Unorm}
+        });
+
+        const bool is_last = i + 1 == node_count;
+
+        if (!is_last) {
+            textures.push_back(graph.add_resource(TransientTextureResource{
+                "texture-" + std::to_string(i),
+                vk::Format::eR8G8B8A8Unorm
+            }));
+        }
+
+        // the body only reveals the pipeline to the graph, and records nothing otherwise
+        graph.add_node({
+            .name = "node-" + std::to_string(i),
+            .color_targets = {is_last ? FINAL_IMAGE_RESOURCE_HANDLE : textures.back()},
+            .body = [pipeline](IRenderPassContext &ctx) {
+                ctx.bind_pipeline(pipeline);
+            },
+        });
+    }
+
+    return graph;
+}
+
+static double get_millis_since(const std::chrono::high_resolution_clock::time_point start_time) {
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() / 1000.0;
+}
+
+int main() {
+    const auto bench_dir = std::filesystem::temp_directory_path() / "rayzor-graph-bench";
+    const auto shader_path = bench_dir / "synthetic.spv";
+    const auto plan_path = bench_dir / "render-graph-plan.bin";
+
+    std::filesystem::create_directories(bench_dir);
+    std::ofstream(shader_path, std::ios::binary) << std::string(SHADER_SIZE, '\0');
+
+    std::mt19937 rng(42);
+
+    for (const size_t node_count: GRAPH_SIZES) {
+        double compile_millis = std::numeric_limits<double>::max();
+        double cold_millis = std::numeric_limits<double>::max();
+        double cached_millis = std::numeric_limits<double>::max();
+        double key_millis = std::numeric_limits<double>::max();
+
+        for (size_t run = 0; run < RUNS_PER_SIZE; run++) {
+            // copies share their handles, and thus their plan keys
+            const RenderGraph graph = build_graph(node_count, shader_path, rng);
+
+            {
+                RenderGraph compiled_graph = graph;
+
+                const auto start_time = std::chrono::high_resolution_clock::now();
+                compiled_graph.compile();
+                compile_millis = std::min(compile_millis, get_millis_since(start_time));
+            }
+
+            {
+                std::filesystem::remove(plan_path);
+                RenderGraph compiled_graph = graph;
+
+                const auto start_time = std::chrono::high_resolution_clock::now();
+                const auto key = compiled_graph.hash_description();
+
+                if (RenderGraphPlan::load(plan_path, key)) {
+                    std::cerr << "unexpectedly found a cached plan" << std::endl;
+                    return 1;
+                }
+
+                compiled_graph.compile();
+                RenderGraphPlan::from_compiled_graph(compiled_graph, key).save(plan_path);
+                cold_millis = std::min(cold_millis, get_millis_since(start_time));
+            }
+
+            {
+                RenderGraph compiled_graph = graph;
+
+                const auto start_time = std::chrono::high_resolution_clock::now();
+                const auto key = compiled_graph.hash_description();
+                key_millis = std::min(key_millis, get_millis_since(start_time));
+
+                const auto plan = RenderGraphPlan::load(plan_path, key);
+
+                if (!plan) {
+                    std::cerr << "failed to load the cached plan" << std::endl;
+                    return 1;
+                }
+
+                compiled_graph.compile(&*plan);
+                cached_millis = std::min(cached_millis, get_millis_since(start_time));
+            }
+        }
+
+        std::cout << node_count << " nodes (best of " << RUNS_PER_SIZE << "): compiled in " << compile_millis
+                << " ms, " << compile_millis * 1000.0 / static_cast<double>(node_count) << " us per node; startup "
+                << cold_millis << " ms cold, " << cached_millis << " ms with the cached plan, both including "
+                << key_millis << " ms for the plan key" << std::endl;
+    }
+
+    std::filesystem::remove_all(bench_dir);
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "src/render/mesh/mesh-optimizer.hpp"
+
+/**
+ * Compares the vertex cache behaviour of the in-tree mesh optimization against that of Assimp's
+ * `aiProcess_ImproveCacheLocality`, on the bundled example models or on the models given as arguments.
+ * Both are measured with the same simulated cache, along with the order in which meshes are imported
+ * without any optimization, and the in-tree optimization without the overdraw pass, which trades some of the
+ * cache reuse for drawing occluders first.
+ */
+
+using namespace zrx;
+
+// the same flags as used by `Model`
+static constexpr unsigned int IMPORT_FLAGS = aiProcess_RemoveRedundantMaterials
+                                             | aiProcess_FindInstances
+                                             | aiProcess_OptimizeMeshes
+                                             | aiProcess_OptimizeGraph
+                                             | aiProcess_FixInfacingNormals
+                                             | aiProcess_Triangulate
+                                             | aiProcess_JoinIdenticalVertices
+                                             | aiProcess_CalcTangentSpace
+                                             | aiProcess_SortByPType
+                                             | aiProcess_ValidateDataStructure;
+
+static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+// the first import also pays for reading the file and for Assimp's lazy initialization
+static constexpr size_t IMPORT_RUNS = 5;
+
+struct ImportedMesh {
+    vector<ModelVertex> vertices;
+    vector<uint32_t> indices;
+};
+
+static double get_millis_since(const std::chrono::high_resolution_clock::time_point start_time) {
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count() / 1000.0;
+}
+
+static vector<ImportedMesh> import_meshes(const std::string &path, const unsigned int flags, double &millis) {
+    Assimp::Importer importer;
+    const aiScene *scene = nullptr;
+    millis = std::numeric_limits<double>::max();
+
+    for (size_t run = 0; run < IMPORT_RUNS; run++) {
+        importer.FreeScene();
+
+        const auto start_time = std::chrono::high_resolution_clock::now();
+        scene = importer.ReadFile(path, flags);
+        millis = std::min(millis, get_millis_since(start_time));
+    }
+
+    if (!scene) {
+        std::cerr << "failed to import " << path << ": " << importer.GetErrorString() << std::endl;
+        return {};
+    }
+
+    vector<ImportedMesh> meshes;
+
+    for (uint32_t i = 0; i < scene->mNumMeshes; i++) {
+        const aiMesh *assimp_mesh = scene->mMeshes[i];
+        auto &mesh = meshes.emplace_back();
+
+        // only the positions matter to the optimizations
+        for (uint32_t v = 0; v < assimp_mesh->mNumVertices; v++) {
+            const auto &pos = assimp_mesh->mVertices[v];
+            mesh.vertices.push_back(ModelVertex{.pos = {pos.x, pos.y, pos.z}});
+        }
+
+        for (uint32_t f = 0; f < assimp_mesh->mNumFaces; f++) {
+            const auto &face = assimp_mesh->mFaces[f];
+            if (face.mNumIndices != 3) continue;
+
+            mesh.indices.insert(mesh.indices.end(), face.mIndices, face.mIndices + 3);
+        }
+    }
+
+    return meshes;
+}
+
+static double optimize_meshes(vector<ImportedMesh> &meshes, const bool optimize_overdraw_order) {
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    // the same steps as in `Mesh::optimize`, which keeps the imported order unless reordering improves on it
+    for (auto &mesh: meshes) {
+        const auto vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+        const float imported_acmr = analyze_vertex_cache(mesh.indices, vertex_count).get_acmr();
+
+        auto cache_indices = mesh.indices;
+        optimize_vertex_cache(cache_indices, vertex_count);
+
+        if (analyze_vertex_cache(cache_indices, vertex_count).get_acmr() < imported_acmr) {
+            if (optimize_overdraw_order) {
+                auto overdraw_indices = cache_indices;
+                optimize_overdraw(overdraw_indices, mesh.vertices, OVERDRAW_THRESHOLD);
+
+                if (analyze_vertex_cache(overdraw_indices, vertex_count).get_acmr() < imported_acmr) {
+                    cache_indices = std::move(overdraw_indices);
+                }
+            }
+
+            mesh.indices = std::move(cache_indices);
+        }
+
+        optimize_vertex_fetch(mesh.vertices, mesh.indices);
+    }
+
+    return get_millis_since(start_time);
+}
+
+static VertexCacheStats analyze(const vector<ImportedMesh> &meshes) {
+    VertexCacheStats stats;
+
+    for (const auto &mesh: meshes) {
+        stats += analyze_vertex_cache(mesh.indices, static_cast<uint32_t>(mesh.vertices.size()));
+    }
+
+    return stats;
+}
+
+static void print_stats(const char *name, const VertexCacheStats &stats) {
+    std::cout << "  " << name << ": ACMR " << stats.get_acmr() << ", ATVR " << stats.get_atvr() << std::endl;
+}
+
+int main(const int argc, char **argv) {
+    vector<std::string> paths(argv + 1, argv + argc);
+
+    if (paths.empty()) {
+        paths = {
+            "../assets/example models/t-60-helmet/helmet.fbx",
+            "../assets/example models/kettle/kettle.obj",
+        };
+    }
+
+    for (const auto &path: paths) {
+        double unoptimized_import_millis = 0;
+        double assimp_import_millis = 0;
+
+        const auto meshes = import_meshes(path, IMPORT_FLAGS, unoptimized_import_millis);
+        const auto assimp_meshes = import_meshes(path, IMPORT_FLAGS | aiProcess_ImproveCacheLocality,
+                                                 assimp_import_millis);
+
+        if (meshes.empty() || assimp_meshes.empty()) return 1;
+
+        auto cache_only_meshes = meshes;
+        auto in_tree_meshes = meshes;
+        optimize_meshes(cache_only_meshes, false);
+        const double in_tree_millis = optimize_meshes(in_tree_meshes, true);
+
+        const auto unoptimized_stats = analyze(meshes);
+
+        std::cout << path << ": " << unoptimized_stats.triangle_count << " triangles, simulated cache of "
+                << VERTEX_CACHE_SIZE << " vertices" << std::endl;
+        print_stats("unoptimized", unoptimized_stats);
+        print_stats("aiProcess_ImproveCacheLocality", analyze(assimp_meshes));
+        print_stats("in-tree, vertex cache only", analyze(cache_only_meshes));
+        print_stats("in-tree", analyze(in_tree_meshes));
+        std::cout << "  imported in " << unoptimized_import_millis << " ms, " << assimp_import_millis
+                << " ms with aiProcess_ImproveCacheLocality (best of " << IMPORT_RUNS
+                << "); the in-tree optimization took " << in_tree_millis << " ms" << std::endl;
+    }
+
+    return 0;
+}
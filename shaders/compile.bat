@@ -4,11 +4,18 @@ set "IS_ERROR=0"
 
 set graphics_shaders="main" "skybox" "prepass" "sphere-cube" "ss-quad" "ssao"
 set rt_shaders="raytrace"
+set packed_vertex_shaders="main" "prepass"
+set mesh_shaders="main"
+set packed_mesh_shaders="main"
+set compute_shaders="cull-prepare" "cull-instances" "hi-z" "cull-occlusion" "cull-meshlets-prepare" "cull-meshlets" "cull-meshlets-compact"
 
 set graphics_exts="vert" "frag"
 set rt_exts="rchit" "rgen" "rmiss"
+set mesh_exts="task" "mesh"
 
 set SPV_FLAGS=-g --target-env=vulkan1.2
+:: mesh shaders need SPIR-V 1.4
+set MESH_SPV_FLAGS=-g --target-env=vulkan1.3
 
 (for %%a in (%graphics_shaders%) do (
     (for %%e in (%graphics_exts%) do (
@@ -19,6 +26,29 @@ set SPV_FLAGS=-g --target-env=vulkan1.2
     ))
 ))
 
+(for %%a in (%packed_vertex_shaders%) do (
+    @echo on
+    %SDK_DIR%/Bin/glslc.exe %%a.vert -o obj/%%a-packed-vert.spv -DPACKED_VERTICES %SPV_FLAGS%
+    @echo off
+    if %ERRORLEVEL% NEQ 0 set "IS_ERROR=1"
+))
+
+(for %%a in (%mesh_shaders%) do (
+    (for %%e in (%mesh_exts%) do (
+        @echo on
+        %SDK_DIR%/Bin/glslc.exe %%a.%%e -o obj/%%a-%%e.spv %MESH_SPV_FLAGS%
+        @echo off
+        if %ERRORLEVEL% NEQ 0 set "IS_ERROR=1"
+    ))
+))
+
+(for %%a in (%packed_mesh_shaders%) do (
+    @echo on
+    %SDK_DIR%/Bin/glslc.exe %%a.mesh -o obj/%%a-packed-mesh.spv -DPACKED_VERTICES %MESH_SPV_FLAGS%
+    @echo off
+    if %ERRORLEVEL% NEQ 0 set "IS_ERROR=1"
+))
+
 (for %%a in (%rt_shaders%) do (
     (for %%e in (%rt_exts%) do (
         @echo on
@@ -28,4 +58,11 @@ set SPV_FLAGS=-g --target-env=vulkan1.2
     ))
 ))
 
+(for %%a in (%compute_shaders%) do (
+    @echo on
+    %SDK_DIR%/Bin/glslc.exe %%a.comp -o obj/%%a-comp.spv %SPV_FLAGS%
+    @echo off
+    if %ERRORLEVEL% NEQ 0 set "IS_ERROR=1"
+))
+
 if %IS_ERROR% NEQ 0 exit 1
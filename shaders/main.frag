@@ -1,20 +1,19 @@
 #version 450
 
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
 
 #include "utils/ubo.glsl"
 
 layout (location = 0) in vec3 worldPosition;
 layout (location = 1) in vec2 fragTexCoord;
 layout (location = 2) in mat3 TBN;
+layout (location = 5) flat in uint fragMaterialId;
 
 layout (location = 0) out vec4 outColor;
 
-//layout (push_constant) uniform PushConstants {
-//    uint material_id;
-//} constants;
-
-#define material_id 0
+// fragments of different meshes can share a subgroup
+#define material_id nonuniformEXT(fragMaterialId)
 
 layout (set = 0, binding = 0) uniform UniformBufferObject {
     WindowRes window;
@@ -32,7 +31,7 @@ layout (set = 1, binding = 1) uniform sampler2D normalSamplers[MATERIAL_TEX_ARRA
 layout (set = 1, binding = 2) uniform sampler2D ormSamplers[MATERIAL_TEX_ARRAY_SIZE];
 
 float getBlurredSsao() {
-    vec2 texCoord = gl_FragCoord.xy / vec2(ubo.window.width, ubo.window.height);
+    vec2 texCoord = gl_FragCoord.xy / vec2(ubo.window.width, ubo.window.height) * ubo.window.ssao_uv_scale;
 
     vec2 texelSize = vec2(1.0) / vec2(textureSize(ssaoSampler, 0));
     float result = 0.0;
@@ -1,17 +1,32 @@
 #version 450
 
-#include "utils/ubo.glsl"
+#extension GL_ARB_shader_draw_parameters : require
+#extension GL_EXT_buffer_reference : require
 
-layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec2 inTexCoord;
-layout (location = 2) in vec3 inNormal;
-layout (location = 3) in vec3 inTangent;
-layout (location = 4) in vec3 inBitangent;
-layout (location = 5) in mat4 inInstanceTransform;
+#include "utils/ubo.glsl"
+#include "utils/vertex.glsl"
 
 layout (location = 0) out vec3 worldPosition;
 layout (location = 1) out vec2 fragTexCoord;
 layout (location = 2) out mat3 TBN;
+layout (location = 5) flat out uint fragMaterialId;
+
+struct MeshDescription {
+    uint material_id;
+    uint vertex_offset;
+    uint index_offset;
+    uint first_meshlet;
+    uint meshlet_count;
+};
+
+layout (buffer_reference, std430) readonly buffer MeshDescriptions {
+    MeshDescription descriptions[];
+};
+
+layout (push_constant) uniform PushConstants {
+    MeshDescriptions mesh_descriptions;
+    uint mesh_offset;
+} constants;
 
 layout(binding = 0) uniform UniformBufferObject {
     WindowRes window;
@@ -30,9 +45,13 @@ void main() {
 
     mat3 normal_matrix = transpose(inverse(mat3(model)));
 
-    vec3 T = normalize(normal_matrix * inTangent);
-    vec3 B = normalize(normal_matrix * inBitangent);
-    vec3 N = normalize(normal_matrix * inNormal);
+    vec3 T = normalize(normal_matrix * getVertexTangent());
+    vec3 B = normalize(normal_matrix * getVertexBitangent());
+    vec3 N = normalize(normal_matrix * getVertexNormal());
 
     TBN = mat3(T, B, N);
+
+    // each mesh of the model is a separate draw of the same indirect call, unless it's drawn on its own
+    const uint mesh = constants.mesh_offset + gl_DrawIDARB;
+    fragMaterialId = constants.mesh_descriptions.descriptions[mesh].material_id;
 }
\ No newline at end of file
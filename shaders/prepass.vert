@@ -1,13 +1,7 @@
 #version 450
 
 #include "utils/ubo.glsl"
-
-layout (location = 0) in vec3 inPosition;
-layout (location = 1) in vec2 inTexCoord;
-layout (location = 2) in vec3 inNormal;
-layout (location = 3) in vec3 inTangent;
-layout (location = 4) in vec3 inBitangent;
-layout (location = 5) in mat4 inInstanceTransform;
+#include "utils/vertex.glsl"
 
 layout (location = 0) out vec2 fragTexCoord;
 layout (location = 1) out vec3 fragPos;
@@ -29,5 +23,5 @@ void main() {
     fragTexCoord = inTexCoord;
 
     mat3 normal_matrix = transpose(inverse(mat3(ubo.matrices.view * model)));
-    normal = normal_matrix * inNormal;
+    normal = normal_matrix * getVertexNormal();
 }
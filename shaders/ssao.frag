@@ -90,8 +90,8 @@ const vec3 ssao_kernel[KERNEL_SIZE] = vec3[KERNEL_SIZE](
 void main() {
     const float radius = 0.2;
 
-    vec3 normal = normalize(texture(gNormalSampler, texCoords).xyz);
-    vec3 frag_pos = texture(gPosSampler, texCoords).xyz;
+    vec3 normal = normalize(texture(gNormalSampler, texCoords * ubo.window.g_buffer_uv_scale).xyz);
+    vec3 frag_pos = texture(gPosSampler, texCoords * ubo.window.g_buffer_uv_scale).xyz;
 
     normal.y *= -1;
     frag_pos.y *= -1;
@@ -113,7 +113,7 @@ void main() {
         sample_clip_pos.xyz /= sample_clip_pos.w;
         sample_clip_pos.xyz = sample_clip_pos.xyz * 0.5 + 0.5;
 
-        float sample_depth = texture(gPosSampler, sample_clip_pos.xy).z;
+        float sample_depth = texture(gPosSampler, sample_clip_pos.xy * ubo.window.g_buffer_uv_scale).z;
 
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(frag_pos.z - sample_depth));
 
@@ -0,0 +1,95 @@
+#extension GL_EXT_buffer_reference : require
+
+// has to match the layout of culled draws buffers in graph.hpp
+#define MAX_CULLED_MESHES 1024
+
+// culled draws are read by the culling shaders from set 0, and by the task and mesh shaders from another set
+#ifndef CULLED_DRAWS_SET
+#define CULLED_DRAWS_SET 0
+#endif
+
+struct DrawCommand {
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int vertex_offset;
+    uint first_instance;
+};
+
+struct Meshlet {
+    vec4 bounding_sphere;
+    vec4 normal_cone;
+    uint mesh_id;
+    uint first_index;
+    uint triangle_count;
+    uint first_vertex;
+    uint vertex_count;
+};
+
+layout (buffer_reference, std430) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+struct MeshDescription {
+    uint material_id;
+    uint vertex_offset;
+    uint index_offset;
+    uint first_meshlet;
+    uint meshlet_count;
+};
+
+layout (buffer_reference, std430) readonly buffer MeshDescriptions {
+    MeshDescription descriptions[];
+};
+
+// draws are indexed by mesh, so that gl_DrawID still identifies the mesh being drawn.
+// the instances of each mesh are compacted at the start of the mesh's original instance range.
+layout (set = CULLED_DRAWS_SET, binding = 0, std430) buffer CulledDraws {
+    uint draw_count;
+    uint _padding[3];
+    DrawCommand draws[MAX_CULLED_MESHES];
+    mat4 transforms[];
+} culled;
+
+bool isSphereInFrustum(vec3 center, float radius, mat4 view_proj) {
+    const mat4 m = transpose(view_proj);
+
+    // frustum planes in world space, extracted from the rows of the view-projection matrix.
+    // clip space depth ranges from 0 to 1, so the near plane is just the third row.
+    const vec4 planes[6] = vec4[](
+        m[3] + m[0],
+        m[3] - m[0],
+        m[3] + m[1],
+        m[3] - m[1],
+        m[2],
+        m[3] - m[2]
+    );
+
+    for (int i = 0; i < 6; i++) {
+        if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isMeshletBackFacing(Meshlet meshlet, mat4 model, vec3 camera_pos) {
+    // mirroring transforms flip the winding of the triangles, and with it which of their faces are culled
+    if (meshlet.normal_cone.w >= 1.0 || determinant(mat3(model)) < 0.0) return false;
+
+    // facing is preserved by affine transforms, so the cone is tested in the mesh's local space
+    const vec3 local_camera_pos = (inverse(model) * vec4(camera_pos, 1.0)).xyz;
+    const vec3 view_dir = meshlet.bounding_sphere.xyz - local_camera_pos;
+
+    return dot(view_dir, meshlet.normal_cone.xyz)
+           >= meshlet.normal_cone.w * length(view_dir) + meshlet.bounding_sphere.w;
+}
+
+bool isMeshletVisible(Meshlet meshlet, mat4 model, mat4 view_proj, vec3 camera_pos) {
+    const vec3 center = (model * vec4(meshlet.bounding_sphere.xyz, 1.0)).xyz;
+    const float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+
+    return isSphereInFrustum(center, meshlet.bounding_sphere.w * scale, view_proj)
+           && !isMeshletBackFacing(meshlet, model, camera_pos);
+}
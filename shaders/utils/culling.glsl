@@ -0,0 +1,64 @@
+// the parts shared with the task and mesh shaders, which read the culled draws too
+#include "culling-common.glsl"
+
+// has to match graph.hpp
+#define CULLING_WORKGROUP_SIZE 64
+
+layout (buffer_reference, std430) readonly buffer InstanceTransforms {
+    mat4 transforms[];
+};
+
+layout (buffer_reference, std430) readonly buffer InstanceMeshIds {
+    uint mesh_ids[];
+};
+
+layout (buffer_reference, std430) readonly buffer MeshBounds {
+    vec4 spheres[];
+};
+
+struct Aabb {
+    vec4 min;
+    vec4 max;
+};
+
+layout (buffer_reference, std430) readonly buffer MeshAabbs {
+    Aabb aabbs[];
+};
+
+layout (buffer_reference, std430) readonly buffer DrawCommands {
+    DrawCommand commands[];
+};
+
+layout (buffer_reference, std430) readonly buffer Indices {
+    uint indices[];
+};
+
+layout (push_constant) uniform PushConstants {
+    InstanceTransforms instance_transforms;
+    InstanceMeshIds instance_mesh_ids;
+    MeshBounds mesh_bounds;
+    MeshAabbs mesh_aabbs;
+    DrawCommands draw_commands;
+    Meshlets meshlets;
+    Indices indices;
+    MeshDescriptions mesh_descriptions;
+    uint instance_count;
+    uint mesh_count;
+    uint meshlet_count;
+} constants;
+
+bool isInstanceInFrustum(uint mesh, mat4 model, mat4 view_proj) {
+    const vec4 sphere = constants.mesh_bounds.spheres[mesh];
+    const vec3 center = (model * vec4(sphere.xyz, 1.0)).xyz;
+    const float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+
+    return isSphereInFrustum(center, sphere.w * scale, view_proj);
+}
+
+void appendVisibleInstance(uint mesh, mat4 instance_transform) {
+    const uint slot = atomicAdd(culled.draws[mesh].instance_count, 1);
+    culled.transforms[culled.draws[mesh].first_instance + slot] = instance_transform;
+
+    // trailing meshes without any visible instances aren't drawn at all
+    atomicMax(culled.draw_count, mesh + 1);
+}
@@ -0,0 +1,19 @@
+// has to match the layout of hierarchical depth buffers in graph.hpp
+#define HI_Z_TILE_SIZE 32
+#define HI_Z_MAX_EXTENT 4096
+#define HI_Z_FIRST_LEVEL 3
+#define HI_Z_LAST_LEVEL 5
+
+uint getHiZLevelExtent(uint level) {
+    return HI_Z_MAX_EXTENT >> level;
+}
+
+uint getHiZTexelIndex(uint level, uvec2 texel) {
+    uint offset = 0;
+
+    for (uint l = HI_Z_FIRST_LEVEL; l < level; l++) {
+        offset += getHiZLevelExtent(l) * getHiZLevelExtent(l);
+    }
+
+    return offset + texel.y * getHiZLevelExtent(level) + texel.x;
+}
@@ -0,0 +1,95 @@
+
+// culled draws are bound after the materials, in the third set
+#define CULLED_DRAWS_SET 2
+
+#include "culling-common.glsl"
+#include "octahedral.glsl"
+
+// have to match graph.hpp and `Meshlet` in model.hpp
+#define MESH_TASK_MESHLETS 32
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+
+// the meshlets of a single mesh instance which survived culling by a task shader workgroup
+struct MeshTaskPayload {
+    uint instance; // index of the instance's transform in the culled draws
+    uint material_id;
+    uint meshlet_ids[MESH_TASK_MESHLETS];
+};
+
+layout (buffer_reference, std430) readonly buffer MeshletVertices {
+    uint vertices[];
+};
+
+// one byte per index, packed into words
+layout (buffer_reference, std430) readonly buffer MeshletTriangles {
+    uint words[];
+};
+
+// vertices are fetched as words, as they're either `ModelVertex` or, if `PACKED_VERTICES` is defined,
+// `PackedModelVertex`
+layout (buffer_reference, std430) readonly buffer VertexWords {
+    uint words[];
+};
+
+// begins with `ScenePushConstants` and continues with `MeshShadingPushConstants`, see graph.hpp
+layout (push_constant) uniform PushConstants {
+    MeshDescriptions mesh_descriptions;
+    uint mesh_offset;
+    Meshlets meshlets;
+    MeshletVertices meshlet_vertices;
+    MeshletTriangles meshlet_triangles;
+    VertexWords vertices;
+} constants;
+
+struct Vertex {
+    vec3 position;
+    vec2 tex_coord;
+    vec3 normal;
+    vec3 tangent;
+    vec3 bitangent;
+};
+
+uint getMeshletTriangleIndex(uint index) {
+    return (constants.meshlet_triangles.words[index / 4] >> (index % 4 * 8)) & 0xffu;
+}
+
+Vertex fetchVertex(uint vertex_id) {
+    Vertex vertex;
+
+#ifdef PACKED_VERTICES
+    const uint base = vertex_id * 6;
+
+    vertex.position = vec3(
+        uintBitsToFloat(constants.vertices.words[base]),
+        uintBitsToFloat(constants.vertices.words[base + 1]),
+        uintBitsToFloat(constants.vertices.words[base + 2])
+    );
+
+    vertex.tex_coord = unpackHalf2x16(constants.vertices.words[base + 3]);
+    vertex.normal = decodeOctahedral(unpackSnorm2x16(constants.vertices.words[base + 4]));
+
+    // R8G8B8A8_SNORM, which the vertex fetch would otherwise unpack
+    const vec4 tangent_and_sign = unpackSnorm4x8(constants.vertices.words[base + 5]);
+
+    // the bitangent is rebuilt in model space, where its handedness is known
+    const float handedness = tangent_and_sign.w < 0.0 ? -1.0 : 1.0;
+    vertex.tangent = tangent_and_sign.xyz;
+    vertex.bitangent = cross(vertex.normal, vertex.tangent) * handedness;
+#else
+    const uint base = vertex_id * 14;
+    float values[14];
+
+    for (uint i = 0; i < 14; i++) {
+        values[i] = uintBitsToFloat(constants.vertices.words[base + i]);
+    }
+
+    vertex.position = vec3(values[0], values[1], values[2]);
+    vertex.tex_coord = vec2(values[3], values[4]);
+    vertex.normal = vec3(values[5], values[6], values[7]);
+    vertex.tangent = vec3(values[8], values[9], values[10]);
+    vertex.bitangent = vec3(values[11], values[12], values[13]);
+#endif
+
+    return vertex;
+}
@@ -0,0 +1,26 @@
+// has to match the layout of meshlet culled draws buffers in graph.hpp
+#define MAX_CULLED_MESHLETS (1 << 17)
+#define MAX_MESHLET_CULLED_INDICES (1 << 23)
+
+// instances of a mesh are tested one by one, so meshes with more visible instances keep all of their meshlets
+#define MAX_MESHLET_TESTED_INSTANCES 16
+
+// has to match `MESH_TASK_MESHLETS` in graph.hpp and `shaders/utils/mesh-shading.glsl`
+#define MESH_TASK_MESHLETS 32
+
+struct MeshTasksCommand {
+    uint group_count_x;
+    uint group_count_y;
+    uint group_count_z;
+};
+
+// draws of the instances which survived culling are at binding 0, as declared in culling-common.glsl.
+// these are copies of them, whose indices only cover the meshlets which survived culling too.
+// `index_counts` holds the number of indices each meshlet contributes, which is zero unless it's visible.
+// `tasks` are read instead of all of these by pipelines with mesh shaders, whose task shaders cull the meshlets.
+layout (set = 0, binding = 1, std430) buffer MeshletCulledDraws {
+    DrawCommand draws[MAX_CULLED_MESHES];
+    MeshTasksCommand tasks[MAX_CULLED_MESHES];
+    uint index_counts[MAX_CULLED_MESHLETS];
+    uint indices[MAX_MESHLET_CULLED_INDICES];
+} meshlet_culled;
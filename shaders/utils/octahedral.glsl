@@ -0,0 +1,12 @@
+// decodes the normals of `PackedModelVertex`, which are octahedral-encoded by vertex.cpp
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+
+    // folds the corners of the square back onto the lower half of the octahedron
+    const float t = max(-v.z, 0.0);
+    v.x += v.x >= 0.0 ? -t : t;
+    v.y += v.y >= 0.0 ? -t : t;
+
+    return normalize(v);
+}
@@ -1,6 +1,8 @@
 struct WindowRes {
     uint width;
     uint height;
+    vec2 g_buffer_uv_scale;
+    vec2 ssao_uv_scale;
 };
 
 struct Matrices {
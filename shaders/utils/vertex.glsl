@@ -0,0 +1,41 @@
+// vertex attributes of models, which are either `ModelVertex` or, if `PACKED_VERTICES` is defined,
+// `PackedModelVertex`. the latter are unpacked by the vertex fetch itself, apart from the normal and bitangent.
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec2 inTexCoord;
+#ifdef PACKED_VERTICES
+layout (location = 2) in vec2 inOctNormal;
+layout (location = 3) in vec4 inTangentAndSign;
+#else
+layout (location = 2) in vec3 inNormal;
+layout (location = 3) in vec3 inTangent;
+layout (location = 4) in vec3 inBitangent;
+#endif
+layout (location = 5) in mat4 inInstanceTransform;
+
+#include "octahedral.glsl"
+
+vec3 getVertexNormal() {
+#ifdef PACKED_VERTICES
+    return decodeOctahedral(inOctNormal);
+#else
+    return inNormal;
+#endif
+}
+
+vec3 getVertexTangent() {
+#ifdef PACKED_VERTICES
+    return inTangentAndSign.xyz;
+#else
+    return inTangent;
+#endif
+}
+
+// the bitangent of packed vertices is rebuilt in model space, where its handedness is known
+vec3 getVertexBitangent() {
+#ifdef PACKED_VERTICES
+    const float handedness = inTangentAndSign.w < 0.0 ? -1.0 : 1.0;
+    return cross(decodeOctahedral(inOctNormal), inTangentAndSign.xyz) * handedness;
+#else
+    return inBitangent;
+#endif
+}
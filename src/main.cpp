@@ -20,6 +20,10 @@ struct GraphicsUBO {
     struct WindowRes {
         uint32_t window_width;
         uint32_t window_height;
+
+        // part of each screen-sized texture which holds the current frame, see `ResourceManager::get_render_uv_scale`
+        glm::vec2 g_buffer_uv_scale;
+        glm::vec2 ssao_uv_scale;
     };
 
     struct Matrices {
@@ -83,8 +87,12 @@ class Engine {
     float debug_number = 0;
 
     bool use_ssao              = false;
+    bool use_gpu_culling       = true;
     bool should_compute_skybox = true;
 
+    // only known once the device is picked, and fixed from then on, as the render graph is built around it
+    bool use_mesh_shaders = false;
+
 public:
     Engine() {
         window = renderer.get_window();
@@ -94,6 +102,7 @@ public:
         bind_key_actions();
         bind_mouse_drag_actions();
 
+        use_mesh_shaders = renderer.supports_mesh_shaders();
         build_render_graph();
     }
 
@@ -140,15 +149,43 @@ private:
 
         // ================== models and vertex buffers ==================
 
+        // packed vertices need the shader variants compiled with `PACKED_VERTICES`
+        constexpr auto scene_vertex_format = VertexFormat::PACKED;
+        constexpr bool use_packed_vertices = scene_vertex_format == VertexFormat::PACKED;
+        using SceneVertex = std::conditional_t<use_packed_vertices, PackedModelVertex, ModelVertex>;
+
         const auto scene_model = render_graph.add_resource(ModelResource{
             "scene-model",
-            "../assets/example models/kettle/kettle.obj"
+            "../assets/example models/kettle/kettle.obj",
+            scene_vertex_format
         });
 
         // const auto skybox_vert_buf = render_graph.add_resource(VertexBufferResource{
         //     // todo
         // });
 
+        // ================== storage buffers ==================
+
+        const auto culled_draws = render_graph.add_resource(StorageBufferResource{
+            "culled-draws",
+            CULLED_DRAWS_BUFFER_SIZE
+        });
+
+        const auto occlusion_culled_draws = render_graph.add_resource(StorageBufferResource{
+            "occlusion-culled-draws",
+            CULLED_DRAWS_BUFFER_SIZE
+        });
+
+        const auto meshlet_culled_draws = render_graph.add_resource(StorageBufferResource{
+            "meshlet-culled-draws",
+            MESHLET_CULLED_DRAWS_BUFFER_SIZE
+        });
+
+        const auto hi_z = render_graph.add_resource(StorageBufferResource{
+            "hi-z",
+            HI_Z_BUFFER_SIZE
+        });
+
         // ================== uniform buffers ==================
 
         const auto uniform_buffer = render_graph.add_resource(UniformBufferResource{
@@ -156,10 +193,6 @@ private:
             sizeof(GraphicsUBO)
         });
 
-        render_graph.add_frame_begin_action([this, uniform_buffer](const FrameBeginActionContext &fba_ctx) {
-            update_graphics_uniform_buffer(fba_ctx.resource_manager.get().get_buffer(uniform_buffer));
-        });
-
         // ================== external resources ==================
 
         const auto base_color_texture = render_graph.add_resource(ExternalTextureResource{
@@ -220,10 +253,62 @@ private:
             "ssao-texture",
             {0, 0},
             ssao_tex_format,
+            vk::TextureFlagBitsZRX::MIPMAPS,
+            0.5f
+        });
+
+        render_graph.add_frame_begin_action([=, this](const FrameBeginActionContext &fba_ctx) {
+            auto &resource_manager = fba_ctx.resource_manager.get();
+
+            update_graphics_uniform_buffer(
+                fba_ctx.get_uniform_buffer_slice(uniform_buffer),
+                resource_manager.get_render_uv_scale(g_buffer_pos),
+                resource_manager.get_render_uv_scale(ssao_texture)
+            );
         });
 
         // ================== shaders ==================
 
+        const auto cull_prepare_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-prepare-comp.spv",
+            {{culled_draws}}
+        });
+
+        const auto cull_instances_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-instances-comp.spv",
+            {{culled_draws, uniform_buffer}}
+        });
+
+        const auto hi_z_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/hi-z-comp.spv",
+            {{uniform_buffer, g_buffer_depth, hi_z}}
+        });
+
+        const auto occlusion_cull_prepare_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-prepare-comp.spv",
+            {{occlusion_culled_draws}}
+        });
+
+        const auto cull_occlusion_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-occlusion-comp.spv",
+            {{occlusion_culled_draws, uniform_buffer, hi_z}}
+        });
+
+        const auto cull_meshlets_prepare_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-meshlets-prepare-comp.spv",
+            {{occlusion_culled_draws, meshlet_culled_draws}}
+        });
+
+        const auto cull_meshlets_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-meshlets-comp.spv",
+            {{occlusion_culled_draws, meshlet_culled_draws, uniform_buffer}}
+        });
+
+        const auto compact_meshlets_shaders = render_graph.add_pipeline(ComputeShaderPack{
+            "../shaders/obj/cull-meshlets-compact-comp.spv",
+            {{occlusion_culled_draws, meshlet_culled_draws}}
+        });
+
         const auto cubecap_shaders = render_graph.add_pipeline({
             "../shaders/obj/sphere-cube-vert.spv",
             "../shaders/obj/sphere-cube-frag.spv",
@@ -237,10 +322,10 @@ private:
         });
 
         const auto prepass_shaders = render_graph.add_pipeline({
-            "../shaders/obj/prepass-vert.spv",
+            use_packed_vertices ? "../shaders/obj/prepass-packed-vert.spv" : "../shaders/obj/prepass-vert.spv",
             "../shaders/obj/prepass-frag.spv",
             {{uniform_buffer}},
-            ModelVertex(),
+            SceneVertex(),
             {g_buffer_color_format, g_buffer_color_format},
             depth_format
         });
@@ -263,7 +348,7 @@ private:
         });
 
         const auto main_shaders = render_graph.add_pipeline({
-            "../shaders/obj/main-vert.spv",
+            use_packed_vertices ? "../shaders/obj/main-packed-vert.spv" : "../shaders/obj/main-vert.spv",
             "../shaders/obj/main-frag.spv",
             {
                 {uniform_buffer, ssao_texture},
@@ -273,13 +358,69 @@ private:
                     ResourceHandleArray{orm_texture}
                 }
             },
-            ModelVertex(),
+            SceneVertex(),
             {FinalImageFormatPlaceholder()},
             FinalImageFormatPlaceholder()
         });
 
+        // the task shader culls the meshlets of each visible instance by itself, and the mesh shader reads
+        // the instances' transforms from the culled draws
+        std::optional<ResourceHandle> main_mesh_shaders;
+
+        if (use_mesh_shaders) {
+            main_mesh_shaders = render_graph.add_pipeline({
+                ShaderPack::MeshShaders{
+                    "../shaders/obj/main-task.spv",
+                    use_packed_vertices ? "../shaders/obj/main-packed-mesh.spv" : "../shaders/obj/main-mesh.spv",
+                },
+                "../shaders/obj/main-frag.spv",
+                {
+                    {uniform_buffer, ssao_texture},
+                    {
+                        ResourceHandleArray{base_color_texture},
+                        ResourceHandleArray{normal_texture},
+                        ResourceHandleArray{orm_texture}
+                    },
+                    {occlusion_culled_draws}
+                },
+                {FinalImageFormatPlaceholder()},
+                FinalImageFormatPlaceholder()
+            });
+        }
+
         // ================== nodes ==================
 
+        const auto cull_prepare_node = render_graph.add_node({
+            .name = "cull-prepare",
+            .storage_targets = {culled_draws},
+            .body = [=](IRenderPassContext &ctx) {
+                ctx.bind_pipeline(cull_prepare_shaders);
+                ctx.dispatch_model_culling(scene_model, CullingStage::PREPARE_DRAWS);
+            },
+            .should_run_predicate = [&] { return use_gpu_culling; }
+        });
+
+        // writes the same buffer as the previous node, so the order has to be explicit
+        render_graph.add_node({
+            .name = "cull-instances",
+            .storage_targets = {culled_draws},
+            .body = [=](IRenderPassContext &ctx) {
+                ctx.bind_pipeline(cull_instances_shaders);
+                ctx.dispatch_model_culling(scene_model, CullingStage::CULL_INSTANCES);
+            },
+            .explicit_dependencies = {cull_prepare_node},
+            .should_run_predicate = [&] { return use_gpu_culling; }
+        });
+
+        // models too large for the culled draws buffers are culled on the cpu instead
+        const auto draw_scene_model = [=, this](IRenderPassContext &ctx) {
+            if (use_gpu_culling && ctx.can_cull_model(scene_model, use_mesh_shaders)) {
+                ctx.draw_model_culled(scene_model, culled_draws);
+            } else {
+                ctx.draw_model_frustum_culled(scene_model, get_cull_matrix());
+            }
+        };
+
         const auto cubecap_node = render_graph.add_node({
             .name = "cubemap-capture",
             .color_targets = {skybox_texture},
@@ -294,17 +435,95 @@ private:
             }
         });
 
-        const auto prepass_node = render_graph.add_node({
+        render_graph.add_node({
             .name = "prepass",
             .color_targets = {g_buffer_normal, g_buffer_pos},
             .depth_target = g_buffer_depth,
             .body = [=](IRenderPassContext &ctx) {
                 ctx.bind_pipeline(prepass_shaders);
-                ctx.draw_model(scene_model);
+                draw_scene_model(ctx);
+            }
+        });
+
+        // the prepass depth is reduced into a hierarchical depth buffer, against which the main pass' instances
+        // are tested. an instance is only dropped if its bounding box is farther than everything drawn in the prepass.
+        render_graph.add_node({
+            .name = "hi-z",
+            .storage_targets = {hi_z},
+            .body = [=](IRenderPassContext &ctx) {
+                const auto extent = ctx.get_render_extent(g_buffer_depth);
+
+                ctx.bind_pipeline(hi_z_shaders);
+                ctx.dispatch(
+                    (extent.width + HI_Z_TILE_SIZE - 1) / HI_Z_TILE_SIZE,
+                    (extent.height + HI_Z_TILE_SIZE - 1) / HI_Z_TILE_SIZE,
+                    1
+                );
+            },
+            .should_run_predicate = [&] { return use_gpu_culling; }
+        });
+
+        const auto occlusion_cull_prepare_node = render_graph.add_node({
+            .name = "occlusion-cull-prepare",
+            .storage_targets = {occlusion_culled_draws},
+            .body = [=](IRenderPassContext &ctx) {
+                ctx.bind_pipeline(occlusion_cull_prepare_shaders);
+                ctx.dispatch_model_culling(scene_model, CullingStage::PREPARE_DRAWS);
+            },
+            .should_run_predicate = [&] { return use_gpu_culling; }
+        });
+
+        render_graph.add_node({
+            .name = "occlusion-cull-instances",
+            .storage_targets = {occlusion_culled_draws},
+            .storage_inputs = {hi_z},
+            .body = [=](IRenderPassContext &ctx) {
+                ctx.bind_pipeline(cull_occlusion_shaders);
+                ctx.dispatch_model_culling(scene_model, CullingStage::CULL_INSTANCES);
+            },
+            .explicit_dependencies = {occlusion_cull_prepare_node},
+            .should_run_predicate = [&] { return use_gpu_culling; }
+        });
+
+        // the main pass also drops the clusters of its instances which face away from the camera or are off-screen
+        const auto cull_meshlets_prepare_node = render_graph.add_node({
+            .name = "cull-meshlets-prepare",
+            .storage_targets = {meshlet_culled_draws},
+            .storage_inputs = {occlusion_culled_draws},
+            .body = [=](IRenderPassContext &ctx) {
+                ctx.bind_pipeline(cull_meshlets_prepare_shaders);
+                ctx.dispatch_model_culling(scene_model, CullingStage::PREPARE_DRAWS);
             },
-            .should_run_predicate = [&] { return use_ssao; }
+            .should_run_predicate = [&] { return use_gpu_culling; }
         });
 
+        // with mesh shaders, the prepared task commands are all that's needed
+        if (!use_mesh_shaders) {
+            const auto cull_meshlets_node = render_graph.add_node({
+                .name = "cull-meshlets",
+                .storage_targets = {meshlet_culled_draws},
+                .storage_inputs = {occlusion_culled_draws},
+                .body = [=](IRenderPassContext &ctx) {
+                    ctx.bind_pipeline(cull_meshlets_shaders);
+                    ctx.dispatch_model_culling(scene_model, CullingStage::CULL_MESHLETS);
+                },
+                .explicit_dependencies = {cull_meshlets_prepare_node},
+                .should_run_predicate = [&] { return use_gpu_culling; }
+            });
+
+            render_graph.add_node({
+                .name = "compact-meshlets",
+                .storage_targets = {meshlet_culled_draws},
+                .storage_inputs = {occlusion_culled_draws},
+                .body = [=](IRenderPassContext &ctx) {
+                    ctx.bind_pipeline(compact_meshlets_shaders);
+                    ctx.dispatch_model_culling(scene_model, CullingStage::COMPACT_MESHLETS);
+                },
+                .explicit_dependencies = {cull_meshlets_node},
+                .should_run_predicate = [&] { return use_gpu_culling; }
+            });
+        }
+
         const auto ssao_node = render_graph.add_node({
             .name = "ssao",
             .color_targets = {ssao_texture},
@@ -312,7 +531,10 @@ private:
                 ctx.bind_pipeline(ssao_shaders);
                 // ctx.draw_screenspace_quad();
             },
-            .should_run_predicate = [&] { return use_ssao; }
+            .should_run_predicate = [&] { return use_ssao; },
+            .custom_properties = RenderNode::CustomProperties {
+                .cache_commands = true
+            }
         });
 
         const auto main_node = render_graph.add_node({
@@ -320,22 +542,36 @@ private:
             .color_targets = {FINAL_IMAGE_RESOURCE_HANDLE},
             .depth_target = FINAL_IMAGE_RESOURCE_HANDLE,
             .body = [=](IRenderPassContext &ctx) {
-                ctx.bind_pipeline(main_shaders);
-                ctx.draw_model(scene_model);
+                if (use_gpu_culling && ctx.can_cull_model(scene_model, use_mesh_shaders)) {
+                    ctx.bind_pipeline(main_mesh_shaders.value_or(main_shaders));
+                    ctx.draw_model_meshlet_culled(scene_model, occlusion_culled_draws, meshlet_culled_draws);
+                } else {
+                    ctx.bind_pipeline(main_shaders);
+                    ctx.draw_model_frustum_culled(scene_model, get_cull_matrix());
+                }
 
                 ctx.bind_pipeline(skybox_shaders);
                 // ctx.draw_skybox();
             },
-            .explicit_dependencies = {cubecap_node, prepass_node, ssao_node}
+            .explicit_dependencies = {cubecap_node, ssao_node}
         });
 
         renderer.register_render_graph(render_graph);
     }
 
-    void update_graphics_uniform_buffer(Buffer &buffer) const {
-        const glm::mat4 model = glm::translate(model_translate)
-                                * glm::mat4_cast(model_rotation)
-                                * glm::scale(glm::vec3(model_scale));
+    [[nodiscard]] glm::mat4 get_model_matrix() const {
+        return glm::translate(model_translate)
+               * glm::mat4_cast(model_rotation)
+               * glm::scale(glm::vec3(model_scale));
+    }
+
+    [[nodiscard]] glm::mat4 get_cull_matrix() const {
+        return camera->get_projection_matrix() * camera->get_view_matrix() * get_model_matrix();
+    }
+
+    void update_graphics_uniform_buffer(void *data, const glm::vec2 g_buffer_uv_scale,
+                                        const glm::vec2 ssao_uv_scale) const {
+        const glm::mat4 model = get_model_matrix();
         const glm::mat4 view = camera->get_view_matrix();
         const glm::mat4 proj = camera->get_projection_matrix();
 
@@ -350,6 +586,8 @@ private:
             .window = {
                 .window_width = static_cast<uint32_t>(window_size.x),
                 .window_height = static_cast<uint32_t>(window_size.y),
+                .g_buffer_uv_scale = g_buffer_uv_scale,
+                .ssao_uv_scale = ssao_uv_scale,
             },
             .matrices = {
                 .model = model,
@@ -386,7 +624,7 @@ private:
             graphics_ubo.matrices.cubemap_capture_views[i] = cubemap_face_views[i];
         }
 
-        memcpy(buffer.map(), &graphics_ubo, sizeof(graphics_ubo));
+        memcpy(data, &graphics_ubo, sizeof(graphics_ubo));
     }
 
     void bind_key_actions() {
@@ -464,6 +702,7 @@ private:
 
         if (ImGui::CollapsingHeader("Advanced ", section_flags)) {
             ImGui::Checkbox("SSAO", &use_ssao);
+            ImGui::Checkbox("GPU instance culling", &use_gpu_culling);
 
 #ifndef NDEBUG
             ImGui::Separator();
@@ -0,0 +1,198 @@
+#include "graph-plan.hpp"
+
+#include <fstream>
+#include <type_traits>
+
+#include "src/utils/logger.hpp"
+
+namespace zrx {
+static constexpr std::uint32_t PLAN_FILE_MAGIC = 0x4e4c5052; // "RPLN"
+static constexpr std::uint32_t PLAN_FILE_VERSION = 4;
+
+// sanity limit on the size of a serialized container, so that a corrupted file doesn't cause huge allocations
+static constexpr size_t MAX_CONTAINER_SIZE = 1 << 20;
+
+namespace {
+    class PlanWriter {
+        std::ofstream file;
+
+    public:
+        explicit PlanWriter(const std::filesystem::path &path) : file(path, std::ios::binary | std::ios::trunc) {
+        }
+
+        [[nodiscard]] bool good() const { return file.good(); }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        void write(const T &value) {
+            file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        template<typename A, typename B>
+        void write(const std::pair<A, B> &pair) {
+            write(pair.first);
+            write(pair.second);
+        }
+
+        template<typename T>
+        void write(const vector<T> &values) {
+            write(values.size());
+            for (const auto &value: values) write(value);
+        }
+
+        template<typename T>
+        void write(const std::set<T> &values) {
+            write(values.size());
+            for (const auto &value: values) write(value);
+        }
+
+        template<typename K, typename V>
+        void write(const std::map<K, V> &values) {
+            write(values.size());
+            for (const auto &[key, value]: values) {
+                write(key);
+                write(value);
+            }
+        }
+
+        void write(const RenderGraphPlan::NodeSchedule &schedule) {
+            write(schedule.image_accesses);
+            write(schedule.buffer_accesses);
+        }
+    };
+
+    class PlanReader {
+        std::ifstream file;
+
+    public:
+        explicit PlanReader(const std::filesystem::path &path) : file(path, std::ios::binary) {
+        }
+
+        [[nodiscard]] bool good() const { return file.good(); }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        void read(T &value) {
+            file.read(reinterpret_cast<char *>(&value), sizeof(T));
+        }
+
+        template<typename A, typename B>
+        void read(std::pair<A, B> &pair) {
+            read(pair.first);
+            read(pair.second);
+        }
+
+        template<typename T>
+        void read(vector<T> &values) {
+            values.resize(read_size());
+            for (auto &value: values) read(value);
+        }
+
+        template<typename T>
+        void read(std::set<T> &values) {
+            const size_t size = read_size();
+
+            for (size_t i = 0; i < size && good(); i++) {
+                T value{};
+                read(value);
+                values.insert(std::move(value));
+            }
+        }
+
+        template<typename K, typename V>
+        void read(std::map<K, V> &values) {
+            const size_t size = read_size();
+
+            for (size_t i = 0; i < size && good(); i++) {
+                K key{};
+                V value{};
+                read(key);
+                read(value);
+                values.emplace(std::move(key), std::move(value));
+            }
+        }
+
+        void read(RenderGraphPlan::NodeSchedule &schedule) {
+            read(schedule.image_accesses);
+            read(schedule.buffer_accesses);
+        }
+
+    private:
+        [[nodiscard]] size_t read_size() {
+            size_t size = 0;
+            read(size);
+
+            if (!good() || size > MAX_CONTAINER_SIZE) {
+                file.setstate(std::ios::failbit);
+                return 0;
+            }
+
+            return size;
+        }
+    };
+} // namespace
+
+RenderGraphPlan RenderGraphPlan::from_compiled_graph(const RenderGraph &graph, const std::uint64_t key) {
+    return {
+        .key = key,
+        .topo_levels = graph.topo_levels,
+        .dependency_graph = graph.dependency_graph,
+        .aliasable_lifetimes = graph.aliasable_lifetimes,
+    };
+}
+
+std::optional<RenderGraphPlan> RenderGraphPlan::load(const std::filesystem::path &path, const std::uint64_t key) {
+    if (!std::filesystem::exists(path)) return {};
+
+    PlanReader reader(path);
+
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint64_t file_key = 0;
+
+    reader.read(magic);
+    reader.read(version);
+    reader.read(file_key);
+
+    if (!reader.good() || magic != PLAN_FILE_MAGIC || version != PLAN_FILE_VERSION || file_key != key) {
+        return {};
+    }
+
+    RenderGraphPlan plan{.key = key};
+
+    reader.read(plan.topo_levels);
+    reader.read(plan.dependency_graph);
+    reader.read(plan.aliasable_lifetimes);
+    reader.read(plan.alias_blocks);
+    reader.read(plan.pipeline_layouts);
+    reader.read(plan.push_constant_ranges);
+    reader.read(plan.node_schedules);
+
+    if (!reader.good()) {
+        Logger::warning("ignoring unreadable render graph plan: ", path.string());
+        return {};
+    }
+
+    return plan;
+}
+
+void RenderGraphPlan::save(const std::filesystem::path &path) const {
+    PlanWriter writer(path);
+
+    writer.write(PLAN_FILE_MAGIC);
+    writer.write(PLAN_FILE_VERSION);
+    writer.write(key);
+
+    writer.write(topo_levels);
+    writer.write(dependency_graph);
+    writer.write(aliasable_lifetimes);
+    writer.write(alias_blocks);
+    writer.write(pipeline_layouts);
+    writer.write(push_constant_ranges);
+    writer.write(node_schedules);
+
+    if (!writer.good()) {
+        Logger::warning("failed to save the render graph plan: ", path.string());
+    }
+}
+} // zrx
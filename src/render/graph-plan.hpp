@@ -0,0 +1,73 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <map>
+#include <set>
+
+#include "graph.hpp"
+#include "vk/sync.hpp"
+
+namespace zrx {
+/**
+ * Results of registering a render graph which depend only on the graph's description, the contents
+ * of its shaders and the device: the compiled topology, the memory aliasing assignment, the reflected
+ * descriptor layouts of the pipelines and the barrier schedule of the nodes. The plan is persisted
+ * between launches, so that a graph which didn't change doesn't have to be analysed again.
+ */
+struct RenderGraphPlan {
+    /**
+     * Descriptor type of a single pipeline binding, along with the shader stages which access it.
+     */
+    struct ReflectedBinding {
+        vk::DescriptorType type{};
+        vk::ShaderStageFlags stages{};
+    };
+
+    // reflected bindings of each descriptor set of a pipeline
+    using ReflectedLayout = vector<vector<ReflectedBinding> >;
+
+    struct NodeSchedule {
+        vector<std::pair<ResourceHandle, ImageAccess> > image_accesses;
+        vector<std::pair<ResourceHandle, BufferAccess> > buffer_accesses;
+    };
+
+    // hash of all the inputs from which the plan was derived
+    std::uint64_t key = 0;
+
+    vector<vector<RenderNodeHandle> > topo_levels;
+
+    // dependencies of every node which survived culling
+    std::map<RenderNodeHandle, std::set<RenderNodeHandle> > dependency_graph;
+
+    std::map<ResourceHandle, RenderGraph::ResourceLifetime> aliasable_lifetimes;
+
+    // textures placed in each of the shared memory blocks
+    vector<vector<ResourceHandle> > alias_blocks;
+
+    std::map<ResourceHandle, ReflectedLayout> pipeline_layouts;
+
+    // push constant ranges of the pipelines which use push constants
+    std::map<ResourceHandle, vk::PushConstantRange> push_constant_ranges;
+
+    std::map<RenderNodeHandle, NodeSchedule> node_schedules;
+
+    /**
+     * Creates a plan holding the topology and resource lifetimes of a graph compiled without a plan.
+     * The rest of the plan depends on the device, so it's filled in by the renderer.
+     */
+    [[nodiscard]] static RenderGraphPlan from_compiled_graph(const RenderGraph &graph, std::uint64_t key);
+
+    /**
+     * Loads a previously saved plan, provided that it was derived from inputs with the same key.
+     * Returns nothing if there's no such plan or if it couldn't be read.
+     */
+    [[nodiscard]] static std::optional<RenderGraphPlan> load(const std::filesystem::path &path, std::uint64_t key);
+
+    /**
+     * Saves the plan, overwriting any plan saved earlier. Failing to do so isn't fatal,
+     * as the plan can always be derived again.
+     */
+    void save(const std::filesystem::path &path) const;
+};
+} // zrx
@@ -1,8 +1,14 @@
 #include "graph.hpp"
+#include "graph-plan.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 
 #include "resource-manager.hpp"
 #include "vk/pipeline.hpp"
 #include "src/utils/logger.hpp"
+#include "src/utils/hash.hpp"
 #include "vk/descriptor.hpp"
 
 namespace zrx {
@@ -23,45 +29,377 @@ namespace zrx {
     return result;
 }
 
+std::set<ResourceHandle> ComputeShaderPack::get_bound_resources_set() const {
+    std::set<ResourceHandle> result;
+
+    for (const auto &set: descriptor_set_descs) {
+        for (const auto &binding: set) {
+            if (std::holds_alternative<ResourceHandle>(binding)) {
+                result.insert(std::get<ResourceHandle>(binding));
+            } else if (std::holds_alternative<ResourceHandleArray>(binding)) {
+                result.insert(std::get<ResourceHandleArray>(binding).begin(),
+                              std::get<ResourceHandleArray>(binding).end());
+            }
+        }
+    }
+
+    return result;
+}
+
+RenderPassStats &RenderPassStats::operator+=(const RenderPassStats &other) {
+    draw_count += other.draw_count;
+    dispatch_count += other.dispatch_count;
+    triangle_count += other.triangle_count;
+    pipeline_binds += other.pipeline_binds;
+    descriptor_set_binds += other.descriptor_set_binds;
+    buffer_binds += other.buffer_binds;
+    skipped_binds += other.skipped_binds;
+    culled_instances += other.culled_instances;
+    return *this;
+}
+
 void RenderPassContext::bind_pipeline(const ResourceHandle pipeline_handle) {
-    const auto &pipeline = pipelines.get().at(pipeline_handle);
-    command_buffer.get().bindPipeline(vk::PipelineBindPoint::eGraphics, **pipeline);
+    const auto compute_it = compute_pipelines.get().find(pipeline_handle);
+    const bool is_compute = compute_it != compute_pipelines.get().end();
+
+    const Pipeline &pipeline = is_compute
+                                   ? static_cast<const Pipeline &>(compute_it->second)
+                                   : pipelines.get().at(pipeline_handle);
+    const auto bind_point = is_compute ? vk::PipelineBindPoint::eCompute : vk::PipelineBindPoint::eGraphics;
+    auto &state = is_compute ? compute_state : graphics_state;
+
+    if (state.pipeline != **pipeline) {
+        command_buffer.get().bindPipeline(bind_point, **pipeline);
+        state.pipeline = **pipeline;
+        stats.pipeline_binds++;
+    } else {
+        stats.skipped_binds++;
+    }
+
+    bound_pipeline = &pipeline;
+    is_mesh_shading_bound = !is_compute && pipelines.get().at(pipeline_handle).uses_mesh_shaders();
+
+    bind_descriptor_sets(state, bind_point, pipeline, pipeline_handle);
+}
+
+void RenderPassContext::bind_descriptor_sets(BindPointState &state, const vk::PipelineBindPoint bind_point,
+                                             const Pipeline &pipeline, const ResourceHandle pipeline_handle) {
+    const auto &desc_sets = pipeline_desc_sets.get().at(pipeline_handle);
+    const auto &slice_sizes = pipeline_dynamic_slice_sizes.get().at(pipeline_handle);
+
+    if (desc_sets.size() > MAX_DESCRIPTOR_SETS || slice_sizes.size() > MAX_DYNAMIC_OFFSETS) {
+        Logger::error("invalid pipeline: too many descriptor sets or dynamic uniform buffers!");
+    }
+
+    std::array<vk::DescriptorSet, MAX_DESCRIPTOR_SETS> sets{};
+    for (size_t i = 0; i < desc_sets.size(); i++) {
+        sets[i] = **desc_sets[i];
+    }
+
+    // uniform buffers are bound at the slice of the frame being recorded
+    std::array<uint32_t, MAX_DYNAMIC_OFFSETS> dynamic_offsets{};
+    for (size_t i = 0; i < slice_sizes.size(); i++) {
+        dynamic_offsets[i] = static_cast<uint32_t>(slice_sizes[i] * frame_index);
+    }
+
+    // every pipeline has its own set layouts, so bound sets only stay compatible while the layout is the same
+    const bool is_redundant = state.layout == *pipeline.get_layout()
+                              && state.set_count == desc_sets.size()
+                              && state.dynamic_offset_count == slice_sizes.size()
+                              && state.sets == sets
+                              && state.dynamic_offsets == dynamic_offsets;
+
+    if (is_redundant) {
+        stats.skipped_binds++;
+        return;
+    }
+
+    if (!desc_sets.empty()) {
+        command_buffer.get().bindDescriptorSets(
+            bind_point,
+            *pipeline.get_layout(),
+            0,
+            vk::ArrayProxy<const vk::DescriptorSet>(static_cast<uint32_t>(desc_sets.size()), sets.data()),
+            vk::ArrayProxy<const uint32_t>(static_cast<uint32_t>(slice_sizes.size()), dynamic_offsets.data())
+        );
+
+        stats.descriptor_set_binds++;
+    }
+
+    state.layout = *pipeline.get_layout();
+    state.sets = sets;
+    state.set_count = desc_sets.size();
+    state.dynamic_offsets = dynamic_offsets;
+    state.dynamic_offset_count = slice_sizes.size();
+}
+
+void RenderPassContext::bind_vertex_buffer(const uint32_t binding, const vk::Buffer buffer,
+                                           const vk::DeviceSize offset) {
+    if (bound_vertex_buffers[binding] == std::make_pair(buffer, offset)) {
+        stats.skipped_binds++;
+        return;
+    }
+
+    command_buffer.get().bindVertexBuffers(binding, buffer, offset);
+    bound_vertex_buffers[binding] = {buffer, offset};
+    stats.buffer_binds++;
+}
 
-    const auto& desc_sets = pipeline_desc_sets.get().at(pipeline_handle);
-    std::vector<vk::DescriptorSet> raw_sets;
-    for (const auto& set: desc_sets) {
-        raw_sets.push_back(*set);
+void RenderPassContext::bind_index_buffer(const vk::Buffer buffer, const vk::DeviceSize offset) {
+    if (bound_index_buffer == std::make_pair(buffer, offset)) {
+        stats.skipped_binds++;
+        return;
     }
 
-    command_buffer.get().bindDescriptorSets(
-        vk::PipelineBindPoint::eGraphics,
-        pipeline.get_layout(),
+    command_buffer.get().bindIndexBuffer(buffer, offset, vk::IndexType::eUint32);
+    bound_index_buffer = {buffer, offset};
+    stats.buffer_binds++;
+}
+
+void RenderPassContext::bind_model_buffers(const Model &model, const vk::Buffer instance_buffer,
+                                           const vk::DeviceSize instance_offset, const vk::Buffer index_buffer,
+                                           const vk::DeviceSize index_offset) {
+    bind_vertex_buffer(0, *model.get_vertex_buffer());
+    bind_vertex_buffer(1, instance_buffer, instance_offset);
+    bind_index_buffer(index_buffer, index_offset);
+
+    if (bound_pipeline && !bound_pipeline->get_push_constant_ranges().empty()) {
+        const ScenePushConstants constants{
+            .mesh_descriptions = model.get_mesh_descriptions_address(),
+            .mesh_offset = 0,
+        };
+
+        push_constants(&constants, ScenePushConstants::SIZE, 0);
+    }
+}
+
+void RenderPassContext::push_constants(const void *data, const uint32_t size, const uint32_t offset) {
+    if (!bound_pipeline || bound_pipeline->get_push_constant_ranges().empty()) {
+        Logger::error("invalid push constants: the bound pipeline doesn't use any!");
+    }
+
+    vk::ShaderStageFlags stages{};
+    for (const auto &range: bound_pipeline->get_push_constant_ranges()) {
+        stages |= range.stageFlags;
+    }
+
+    command_buffer.get().pushConstants(*bound_pipeline->get_layout(), stages, offset, size, data);
+}
+
+void *FrameBeginActionContext::get_uniform_buffer_slice(const ResourceHandle handle) const {
+    auto &buffer = resource_manager.get().get_buffer(handle);
+    const auto slice_size = resource_manager.get().get_buffer_slice_size(handle);
+
+    if (!slice_size) {
+        Logger::error("invalid frame begin action: resource is not a render graph uniform buffer!");
+    }
+
+    return static_cast<std::byte *>(buffer.map()) + *slice_size * frame_index;
+}
+
+void RenderPassContext::draw_model(const ResourceHandle model_handle) {
+    const Model &model = resource_manager.get().get_model(model_handle);
+    bind_model_buffers(model, *model.get_instance_buffer(), 0, *model.get_index_buffer(), 0);
+
+    const auto &meshes = model.get_meshes();
+
+    command_buffer.get().drawIndexedIndirect(
+        *model.get_draw_commands_buffer(),
         0,
-        raw_sets,
-        nullptr
+        static_cast<uint32_t>(meshes.size()),
+        sizeof(vk::DrawIndexedIndirectCommand)
     );
+
+    stats.draw_count++;
+
+    for (const auto &mesh: meshes) {
+        stats.triangle_count += mesh.index_count / 3 * mesh.instances.size();
+    }
 }
 
-void RenderPassContext::draw_model(const ResourceHandle model_handle) {
-    uint32_t index_offset    = 0;
-    int32_t vertex_offset    = 0;
-    uint32_t instance_offset = 0;
+// the capacities of the culled draws buffers, and the limits on mesh shading draws, checked by `can_cull_model`
+
+static bool fits_culled_draws(const Model &model) {
+    return model.get_meshes().size() <= MAX_CULLED_MESHES && model.get_instance_count() <= MAX_CULLED_INSTANCES;
+}
+
+static bool fits_meshlet_culled_draws(const Model &model) {
+    return model.get_index_count() <= MAX_MESHLET_CULLED_INDICES && model.get_meshlet_count() <= MAX_CULLED_MESHLETS;
+}
+
+static bool fits_mesh_task_limits(const Model &model) {
+    return std::ranges::all_of(model.get_meshes(), [](const Mesh &mesh) {
+        const uint64_t group_count = (mesh.meshlet_count + MESH_TASK_MESHLETS - 1) / MESH_TASK_MESHLETS;
+
+        return mesh.instances.size() <= MAX_MESH_TASK_GROUP_COUNT
+               && group_count * mesh.instances.size() <= MAX_MESH_TASK_GROUP_TOTAL_COUNT;
+    });
+}
+
+void RenderPassContext::draw_model_culled(const ResourceHandle model_handle, const ResourceHandle culled_draws_handle) {
+    const Model &model = resource_manager.get().get_model(model_handle);
+    const Buffer &culled_draws = resource_manager.get().get_buffer(culled_draws_handle);
+
+    if (!fits_culled_draws(model)) return;
+
+    // surviving instances are compacted into the buffer, so the instance attributes are read from it too
+    bind_model_buffers(model, *culled_draws, CULLED_TRANSFORMS_OFFSET, *model.get_index_buffer(), 0);
 
+    command_buffer.get().drawIndexedIndirectCount(
+        *culled_draws,
+        CULLED_DRAWS_OFFSET,
+        *culled_draws,
+        CULLED_DRAW_COUNT_OFFSET,
+        static_cast<uint32_t>(model.get_meshes().size()),
+        sizeof(vk::DrawIndexedIndirectCommand)
+    );
+
+    // the number of drawn triangles is only known to the gpu
+    stats.draw_count++;
+}
+
+void RenderPassContext::draw_model_meshlet_culled(const ResourceHandle model_handle,
+                                                  const ResourceHandle culled_draws_handle,
+                                                  const ResourceHandle meshlet_draws_handle) {
     const Model &model = resource_manager.get().get_model(model_handle);
-    model.bind_buffers(command_buffer);
-
-    for (const auto &mesh: model.get_meshes()) {
-        command_buffer.get().drawIndexed(
-            static_cast<uint32_t>(mesh.indices.size()),
-            static_cast<uint32_t>(mesh.instances.size()),
-            index_offset,
-            vertex_offset,
-            instance_offset
+    const Buffer &culled_draws = resource_manager.get().get_buffer(culled_draws_handle);
+    const Buffer &meshlet_draws = resource_manager.get().get_buffer(meshlet_draws_handle);
+
+    if (!can_cull_model(model_handle, is_mesh_shading_bound)) return;
+
+    if (is_mesh_shading_bound) {
+        // mesh shaders fetch the vertices themselves, so there's nothing to bind but the buffers' addresses
+        const ScenePushConstants constants{
+            .mesh_descriptions = model.get_mesh_descriptions_address(),
+            .mesh_offset = 0,
+        };
+
+        push_constants(&constants, ScenePushConstants::SIZE, 0);
+        push_constants(MeshShadingPushConstants{.model = model.get_meshlet_inputs()},
+                       MeshShadingPushConstants::OFFSET);
+
+        // a task command per mesh, whose workgroups cull the meshlets of each of the mesh's visible instances
+        command_buffer.get().drawMeshTasksIndirectCountEXT(
+            *meshlet_draws,
+            MESHLET_CULLED_TASKS_OFFSET,
+            *culled_draws,
+            CULLED_DRAW_COUNT_OFFSET,
+            static_cast<uint32_t>(model.get_meshes().size()),
+            sizeof(vk::DrawMeshTasksIndirectCommandEXT)
         );
 
-        index_offset += static_cast<uint32_t>(mesh.indices.size());
-        vertex_offset += static_cast<int32_t>(mesh.vertices.size());
-        instance_offset += static_cast<uint32_t>(mesh.instances.size());
+        stats.draw_count++;
+        return;
+    }
+
+    bind_model_buffers(model, *culled_draws, CULLED_TRANSFORMS_OFFSET, *meshlet_draws, MESHLET_CULLED_INDICES_OFFSET);
+
+    // meshlet draws only differ from the instance draws in their indices, so they share the draw count
+    command_buffer.get().drawIndexedIndirectCount(
+        *meshlet_draws,
+        MESHLET_CULLED_DRAWS_OFFSET,
+        *culled_draws,
+        CULLED_DRAW_COUNT_OFFSET,
+        static_cast<uint32_t>(model.get_meshes().size()),
+        sizeof(vk::DrawIndexedIndirectCommand)
+    );
+
+    stats.draw_count++;
+}
+
+void RenderPassContext::draw_model_frustum_culled(const ResourceHandle model_handle, const glm::mat4 &cull_matrix) {
+    const Model &model = resource_manager.get().get_model(model_handle);
+    bind_model_buffers(model, *model.get_instance_buffer(), 0, *model.get_index_buffer(), 0);
+
+    // reused between calls, as it's as large as the model's instance count
+    thread_local vector<uint8_t> visible;
+    model.get_instance_bounds().test(Frustum::from_matrix(cull_matrix), visible);
+
+    const bool uses_push_constants = bound_pipeline && !bound_pipeline->get_push_constant_ranges().empty();
+    const auto &meshes = model.get_meshes();
+
+    uint32_t index_offset = 0;
+    int32_t vertex_offset = 0;
+    uint32_t instance = 0;
+
+    for (uint32_t mesh_id = 0; mesh_id < meshes.size(); mesh_id++) {
+        const auto &mesh = meshes[mesh_id];
+        const auto index_count = mesh.index_count;
+        const uint32_t mesh_instances_end = instance + static_cast<uint32_t>(mesh.instances.size());
+        bool is_mesh_offset_pushed = false;
+
+        // every run of consecutive visible instances is drawn separately
+        while (instance < mesh_instances_end) {
+            if (!visible[instance]) {
+                instance++;
+                stats.culled_instances++;
+                continue;
+            }
+
+            const uint32_t first_instance = instance;
+            while (instance < mesh_instances_end && visible[instance]) instance++;
+
+            // direct draws always have a zero draw index, so the mesh is identified by the offset instead
+            if (uses_push_constants && !is_mesh_offset_pushed) {
+                push_constants(mesh_id, offsetof(ScenePushConstants, mesh_offset));
+                is_mesh_offset_pushed = true;
+            }
+
+            command_buffer.get().drawIndexed(index_count, instance - first_instance, index_offset, vertex_offset,
+                                             first_instance);
+
+            stats.draw_count++;
+            stats.triangle_count += static_cast<uint64_t>(index_count / 3) * (instance - first_instance);
+        }
+
+        index_offset += index_count;
+        vertex_offset += static_cast<int32_t>(mesh.vertex_count);
+    }
+}
+
+bool RenderPassContext::can_cull_model(const ResourceHandle model_handle, const bool uses_mesh_shaders) const {
+    const Model &model = resource_manager.get().get_model(model_handle);
+
+    return fits_culled_draws(model) && (uses_mesh_shaders ? fits_mesh_task_limits(model)
+                                                          : fits_meshlet_culled_draws(model));
+}
+
+void RenderPassContext::dispatch_model_culling(const ResourceHandle model_handle, const CullingStage stage) {
+    const Model &model = resource_manager.get().get_model(model_handle);
+    const auto mesh_count = static_cast<uint32_t>(model.get_meshes().size());
+    const auto instance_count = model.get_instance_count();
+    const auto meshlet_count = model.get_meshlet_count();
+
+    const bool culls_meshlets = stage == CullingStage::CULL_MESHLETS || stage == CullingStage::COMPACT_MESHLETS;
+
+    // such a model is drawn without the culled draws, so they're left as they are
+    if (!fits_culled_draws(model) || (culls_meshlets && !fits_meshlet_culled_draws(model))) return;
+
+    push_constants(CullingPushConstants{
+        .model = model.get_culling_inputs(),
+        .instance_count = instance_count,
+        .mesh_count = mesh_count,
+        .meshlet_count = meshlet_count,
+    });
+
+    // at least one invocation is needed to reset the draw count, even without any meshes
+    const auto get_group_count = [](const uint32_t invocation_count) {
+        return (std::max(1u, invocation_count) + CULLING_WORKGROUP_SIZE - 1) / CULLING_WORKGROUP_SIZE;
+    };
+
+    switch (stage) {
+        case CullingStage::PREPARE_DRAWS:
+            dispatch(get_group_count(mesh_count), 1, 1);
+            break;
+        case CullingStage::CULL_INSTANCES:
+            dispatch(get_group_count(instance_count), 1, 1);
+            break;
+        case CullingStage::CULL_MESHLETS:
+            dispatch(get_group_count(meshlet_count), 1, 1);
+            break;
+        case CullingStage::COMPACT_MESHLETS:
+            dispatch(std::max(1u, mesh_count), 1, 1);
+            break;
     }
 }
 
@@ -69,23 +407,47 @@ void RenderPassContext::draw(const ResourceHandle vertices_handle,
                              const uint32_t vertex_count, const uint32_t instance_count,
                              const uint32_t first_vertex, const uint32_t first_instance) {
     const Buffer &vertex_buffer = resource_manager.get().get_buffer(vertices_handle);
-    command_buffer.get().bindVertexBuffers(0, *vertex_buffer, {0});
+    bind_vertex_buffer(0, *vertex_buffer);
     command_buffer.get().draw(vertex_count, instance_count, first_vertex, first_instance);
+
+    stats.draw_count++;
+    stats.triangle_count += static_cast<uint64_t>(vertex_count / 3) * instance_count;
+}
+
+vk::Extent2D RenderPassContext::get_render_extent(const ResourceHandle texture_handle) const {
+    return resource_manager.get().get_render_extent(texture_handle);
+}
+
+void RenderPassContext::dispatch(const uint32_t group_count_x, const uint32_t group_count_y,
+                                 const uint32_t group_count_z) {
+    command_buffer.get().dispatch(group_count_x, group_count_y, group_count_z);
+    stats.dispatch_count++;
+}
+
+void RenderPassContext::dispatch_indirect(const ResourceHandle buffer_handle, const vk::DeviceSize offset) {
+    const Buffer &args_buffer = resource_manager.get().get_buffer(buffer_handle);
+    command_buffer.get().dispatchIndirect(*args_buffer, offset);
+    stats.dispatch_count++;
 }
 
 std::set<ResourceHandle> RenderNode::get_all_targets_set() const {
     std::set result(color_targets.begin(), color_targets.end());
+    result.insert(storage_targets.begin(), storage_targets.end());
     if (depth_target) result.insert(*depth_target);
     return result;
 }
 
-std::set<ResourceHandle>
-RenderNode::get_all_shader_resources_set(const std::map<ResourceHandle, ShaderPack> &shaders) const {
+std::set<ResourceHandle> RenderNode::get_used_pipelines_set() const {
     ShaderGatherRenderPassContext ctx{};
     body(ctx);
+    return {ctx.get().begin(), ctx.get().end()};
+}
+
+std::set<ResourceHandle>
+RenderNode::get_all_shader_resources_set(const std::map<ResourceHandle, ShaderPack> &shaders) const {
     std::set<ResourceHandle> result;
 
-    for (const ResourceHandle shader_handle: ctx.get()) {
+    for (const ResourceHandle shader_handle: get_used_pipelines_set()) {
         const auto bound_resources = shaders.at(shader_handle).get_bound_resources_set();
         result.insert(bound_resources.begin(), bound_resources.end());
     }
@@ -93,65 +455,334 @@ RenderNode::get_all_shader_resources_set(const std::map<ResourceHandle, ShaderPa
     return result;
 }
 
+bool RenderGraph::NodeResourceUsage::references(const ResourceHandle handle) const {
+    return targets.contains(handle) || pipelines.contains(handle)
+           || shader_resources.contains(handle) || draw_resources.contains(handle)
+           || indirect_buffers.contains(handle);
+}
+
+const vector<vector<RenderNodeHandle> > &RenderGraph::get_topo_levels() const {
+    if (!is_compiled) {
+        Logger::error("invalid render graph usage: graph has to be compiled before sorting!");
+    }
+
+    return topo_levels;
+}
+
+const std::set<RenderNodeHandle> &RenderGraph::get_dependents(const RenderNodeHandle handle) const {
+    if (!is_compiled) {
+        Logger::error("invalid render graph usage: graph has to be compiled before querying dependents!");
+    }
+
+    return dependents_graph.at(handle);
+}
+
+bool RenderGraph::is_output_node(const RenderNodeHandle handle) const {
+    return node_usages.at(handle).targets.contains(FINAL_IMAGE_RESOURCE_HANDLE);
+}
+
+bool RenderGraph::is_compute_node(const RenderNodeHandle handle) const {
+    return compute_nodes.contains(handle);
+}
+
+bool RenderGraph::is_async_compute_node(const RenderNodeHandle handle) const {
+    return nodes.at(handle).custom_properties.async_compute;
+}
+
+const std::set<RenderNodeHandle> &RenderGraph::get_cross_queue_dependencies(const RenderNodeHandle handle) const {
+    return cross_queue_dependencies.at(handle);
+}
+
+bool RenderGraph::has_cross_queue_dependents(const RenderNodeHandle handle) const {
+    return nodes_with_cross_queue_dependents.contains(handle);
+}
+
+std::set<ResourceHandle> RenderGraph::get_async_compute_resources() const {
+    std::set<ResourceHandle> result;
+
+    for (const auto &[handle, usage]: node_usages) {
+        if (!is_async_compute_node(handle)) continue;
+
+        result.insert(usage.targets.begin(), usage.targets.end());
+        result.insert(usage.shader_resources.begin(), usage.shader_resources.end());
+        result.insert(usage.indirect_buffers.begin(), usage.indirect_buffers.end());
+    }
+
+    return result;
+}
+
+const RenderGraph::NodeAttachmentOps &RenderGraph::get_attachment_ops(const RenderNodeHandle handle) const {
+    if (!is_compiled) {
+        Logger::error("invalid render graph usage: graph has to be compiled before querying attachment ops!");
+    }
+
+    return attachment_ops.at(handle);
+}
+
 vector<RenderNodeHandle> RenderGraph::get_topo_sorted() const {
     vector<RenderNodeHandle> result;
 
-    std::set<RenderNodeHandle> remaining;
+    for (const auto &level: get_topo_levels()) {
+        result.insert(result.end(), level.begin(), level.end());
+    }
+
+    return result;
+}
+
+void RenderGraph::compile(const RenderGraphPlan *plan) {
+    if (is_compiled) return;
+
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    std::map<ResourceHandle, vector<RenderNodeHandle> > resource_writers;
+    std::map<ResourceHandle, vector<RenderNodeHandle> > resource_readers;
+
+    // gather every node's resources exactly once, indexing them by resource
+    for (const auto &[handle, node]: nodes) {
+        ShaderGatherRenderPassContext gather_ctx{};
+        node.body(gather_ctx);
+
+        NodeResourceUsage usage{
+            .targets = node.get_all_targets_set(),
+            .pipelines = {gather_ctx.get().begin(), gather_ctx.get().end()},
+            .draw_resources = {gather_ctx.get_draw_resources().begin(), gather_ctx.get_draw_resources().end()},
+            .indirect_buffers = {gather_ctx.get_indirect_buffers().begin(), gather_ctx.get_indirect_buffers().end()},
+        };
+
+        for (const auto pipeline: usage.pipelines) {
+            const auto bound_resources = compute_pipelines.contains(pipeline)
+                                             ? compute_pipelines.at(pipeline).get_bound_resources_set()
+                                             : pipelines.at(pipeline).get_bound_resources_set();
+            usage.shader_resources.insert(bound_resources.begin(), bound_resources.end());
+        }
+
+        // storage targets are bound to the pipelines too, but they're written rather than sampled
+        for (const auto target: node.storage_targets) {
+            usage.shader_resources.erase(target);
+        }
+
+        for (const auto input: node.storage_inputs) {
+            if (!usage.shader_resources.contains(input)) {
+                Logger::error("invalid render node \"", node.name, "\": storage input is not bound to any pipeline!");
+            }
+        }
+
+        const bool uses_compute_pipelines = std::ranges::any_of(usage.pipelines, [&](const ResourceHandle pipeline) {
+            return compute_pipelines.contains(pipeline);
+        });
+
+        if (uses_compute_pipelines || node.custom_properties.async_compute) {
+            compute_nodes.insert(handle);
+        }
+
+        validate_compute_node(handle, usage);
+
+        if (!detail::empty_intersection(usage.targets, usage.shader_resources)) {
+            Logger::error("invalid render node \"", node.name, "\": cannot use a target as a shader resource!");
+        }
+
+        for (const auto target: usage.targets) {
+            resource_writers[target].push_back(handle);
+        }
+
+        for (const auto resource: usage.shader_resources) {
+            resource_readers[resource].push_back(handle);
+        }
+
+        // indirect arguments are usually written by an earlier compute node
+        for (const auto buffer: usage.indirect_buffers) {
+            if (!storage_buffers.contains(buffer)) {
+                Logger::error("invalid render node \"", node.name,
+                              "\": indirect arguments have to be placed in a storage buffer!");
+            }
+
+            resource_readers[buffer].push_back(handle);
+        }
+
+        std::set<RenderNodeHandle> dependencies;
+
+        for (const auto dependency: node.explicit_dependencies) {
+            if (!nodes.contains(dependency)) {
+                Logger::error("invalid render node \"", node.name, "\": unknown explicit dependency!");
+            }
 
-    for (const auto &[handle, _]: nodes) {
-        remaining.emplace(handle);
+            dependencies.emplace(dependency);
+        }
+
+        dependency_graph.emplace(handle, std::move(dependencies));
+        node_usages.emplace(handle, std::move(usage));
+        node_versions.emplace(handle, 0);
     }
 
-    while (!remaining.empty()) {
-        for (const auto &handle: remaining) {
-            if (std::ranges::all_of(dependency_graph.at(handle), [&](const RenderNodeHandle &dep) {
-                return !remaining.contains(dep);
-            })) {
-                result.push_back(handle);
-                remaining.erase(handle);
-                break;
+    const size_t node_count_before_culling = nodes.size();
+    size_t edge_count = 0;
+
+    if (plan) {
+        // the plan only knows about the nodes which survived culling when it was made
+        std::set<RenderNodeHandle> culled_nodes;
+
+        for (const auto &[handle, node]: nodes) {
+            if (!plan->dependency_graph.contains(handle)) culled_nodes.insert(handle);
+        }
+
+        remove_nodes(culled_nodes);
+        dependency_graph = plan->dependency_graph;
+
+        for (const auto &[handle, dependencies]: dependency_graph) {
+            edge_count += dependencies.size();
+        }
+    } else {
+        // a node which samples a resource depends on every node which renders to it
+        for (const auto &[resource, readers]: resource_readers) {
+            const auto writers_it = resource_writers.find(resource);
+            if (writers_it == resource_writers.end()) continue;
+
+            for (const auto reader: readers) {
+                auto &dependencies = dependency_graph.at(reader);
+
+                for (const auto writer: writers_it->second) {
+                    if (dependencies.emplace(writer).second) edge_count++;
+                }
             }
         }
+
+        cull_dead_nodes(resource_writers, resource_readers);
+    }
+
+    for (const auto &[handle, dependencies]: dependency_graph) {
+        dependents_graph.try_emplace(handle);
+
+        for (const auto dependency: dependencies) {
+            dependents_graph[dependency].insert(handle);
+        }
     }
 
-    return result;
+    if (plan) {
+        topo_levels = plan->topo_levels;
+        aliasable_lifetimes = plan->aliasable_lifetimes;
+    } else {
+        sort_topologically();
+        compute_aliasable_lifetimes(resource_writers, resource_readers);
+    }
+
+    find_cross_queue_dependencies();
+    infer_attachment_ops();
+
+    is_compiled = true;
+
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+    Logger::info("compiled render graph: ", nodes.size(), " nodes (", node_count_before_culling - nodes.size(),
+                 " culled), ", edge_count, plan ? " edges from the cached plan, " : " inferred edges, ",
+                 topo_levels.size(), " levels, ", aliasable_lifetimes.size(), " aliasable textures in ",
+                 micros / 1000.0, " ms");
 }
 
-RenderNodeHandle RenderGraph::add_node(const RenderNode &node) {
-    const auto handle = get_new_node_handle();
-    nodes.emplace(handle, node);
+std::uint64_t RenderGraph::hash_description() const {
+    Hasher hasher;
+
+    const auto add_set_descs = [&](const vector<ShaderPack::DescriptorSetDescription> &set_descs) {
+        hasher.add(set_descs.size());
+
+        for (const auto &set_desc: set_descs) {
+            hasher.add(set_desc.size());
+
+            for (const auto &binding: set_desc) {
+                hasher.add(binding.index());
+
+                if (std::holds_alternative<ResourceHandle>(binding)) {
+                    hasher.add(std::get<ResourceHandle>(binding));
+                } else if (std::holds_alternative<ResourceHandleArray>(binding)) {
+                    hasher.add(std::get<ResourceHandleArray>(binding));
+                }
+            }
+        }
+    };
 
-    const auto targets_set      = node.get_all_targets_set();
-    const auto shader_resources = node.get_all_shader_resources_set(pipelines);
+    for (const auto &[handle, description]: uniform_buffers) {
+        hasher.add(handle).add(description.name).add(description.size);
+    }
 
-    if (!detail::empty_intersection(targets_set, shader_resources)) {
-        Logger::error("invalid render node: cannot use a target as a shader resource!");
+    for (const auto &[handle, description]: storage_buffers) {
+        hasher.add(handle).add(description.name).add(description.size);
     }
 
-    std::set<RenderNodeHandle> dependencies;
+    for (const auto &[handle, description]: external_tex_resources) {
+        hasher.add(handle).add(description.name).add(description.paths).add(description.format)
+                .add(description.tex_flags);
+    }
 
-    // for each existing node A...
-    for (const auto &[other_handle, other_node]: nodes) {
-        const auto other_targets_set      = other_node.get_all_targets_set();
-        const auto other_shader_resources = other_node.get_all_shader_resources_set(pipelines);
+    for (const auto &[handle, description]: empty_tex_resources) {
+        hasher.add(handle).add(description.name).add(description.format).add(description.tex_flags)
+                .add(description.extent.width).add(description.extent.height).add(description.resolution_scale);
+    }
 
-        // ...if any of the new node's targets is sampled in A,
-        // then the new node is A's dependency.
-        if (!detail::empty_intersection(targets_set, other_shader_resources)) {
-            dependency_graph.at(other_handle).emplace(handle);
+    for (const auto &[handle, description]: transient_tex_resources) {
+        hasher.add(handle).add(description.name).add(description.format).add(description.tex_flags)
+                .add(description.extent.width).add(description.extent.height).add(description.resolution_scale);
+    }
+
+    for (const auto &[handle, description]: model_resources) {
+        hasher.add(handle).add(description.name).add(description.path);
+    }
+
+    for (const auto &[handle, pack]: pipelines) {
+        hasher.add(handle);
+
+        // packs have either a vertex shader or mesh shaders, along with an optional task shader
+        for (const auto &path: {pack.vertex_path, pack.task_path, pack.mesh_path, pack.fragment_path}) {
+            hasher.add(path);
+            if (!path.empty()) hasher.add_file_contents(path);
         }
 
-        // and if the new node samples any of A's targets,
-        // then A is the new node's dependency.
-        if (!detail::empty_intersection(other_targets_set, shader_resources)) {
-            dependencies.emplace(other_handle);
+        add_set_descs(pack.descriptor_set_descs);
+    }
+
+    for (const auto &[handle, pack]: compute_pipelines) {
+        hasher.add(handle).add(pack.compute_path).add_file_contents(pack.compute_path);
+        add_set_descs(pack.descriptor_set_descs);
+    }
+
+    for (const auto &[handle, node]: nodes) {
+        ShaderGatherRenderPassContext gather_ctx{};
+        node.body(gather_ctx);
+
+        hasher.add(handle).add(node.name)
+                .add(node.color_targets)
+                .add(node.depth_target.has_value()).add(node.depth_target.value_or(0))
+                .add(node.storage_targets)
+                .add(node.storage_inputs)
+                .add(node.explicit_dependencies)
+                .add(node.custom_properties.multiview_count)
+                .add(node.custom_properties.cache_commands)
+                .add(node.custom_properties.async_compute)
+                .add(node.should_run_predicate.has_value()) // nodes which might be skipped affect aliasing and stores
+                .add(gather_ctx.get())
+                .add(gather_ctx.get_draw_resources())
+                .add(gather_ctx.get_indirect_buffers());
+    }
+
+    return hasher.get();
+}
+
+void RenderGraph::mark_resource_changed(const ResourceHandle handle) {
+    for (const auto &[node_handle, usage]: node_usages) {
+        if (usage.references(handle)) {
+            node_versions.at(node_handle)++;
         }
     }
+}
 
-    dependency_graph.emplace(handle, std::move(dependencies));
+uint64_t RenderGraph::get_node_version(const RenderNodeHandle handle) const {
+    return node_versions.at(handle);
+}
 
-    check_dependency_cycles();
+RenderNodeHandle RenderGraph::add_node(const RenderNode &node) {
+    check_not_compiled();
 
+    const auto handle = get_new_node_handle();
+    nodes.emplace(handle, node);
     return handle;
 }
 
@@ -159,6 +790,10 @@ ResourceHandle RenderGraph::add_resource(UniformBufferResource &&resource) {
     return add_resource_generic(std::move(resource), uniform_buffers);
 }
 
+ResourceHandle RenderGraph::add_resource(StorageBufferResource &&resource) {
+    return add_resource_generic(std::move(resource), storage_buffers);
+}
+
 ResourceHandle RenderGraph::add_resource(ExternalTextureResource &&resource) {
     return add_resource_generic(std::move(resource), external_tex_resources);
 }
@@ -179,35 +814,288 @@ ResourceHandle RenderGraph::add_pipeline(ShaderPack &&resource) {
     return add_resource_generic(std::move(resource), pipelines);
 }
 
+ResourceHandle RenderGraph::add_pipeline(ComputeShaderPack &&resource) {
+    return add_resource_generic(std::move(resource), compute_pipelines);
+}
+
 void RenderGraph::add_frame_begin_action(FrameBeginCallback &&callback) {
+    check_not_compiled();
     frame_begin_callbacks.emplace_back(std::move(callback));
 }
 
-void RenderGraph::cycles_helper(const RenderNodeHandle handle, std::set<RenderNodeHandle> &discovered,
-                                std::set<RenderNodeHandle> &finished) const {
-    discovered.emplace(handle);
+void RenderGraph::cull_dead_nodes(std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_writers,
+                                  std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_readers) {
+    std::set<RenderNodeHandle> live_nodes;
+    vector<RenderNodeHandle> to_visit;
 
-    for (const auto &neighbour: dependency_graph.at(handle)) {
-        if (discovered.contains(neighbour)) {
-            Logger::error("invalid render graph: illegal cycle in dependency graph!");
+    for (const auto &[handle, usage]: node_usages) {
+        if (usage.targets.contains(FINAL_IMAGE_RESOURCE_HANDLE)) {
+            to_visit.push_back(handle);
         }
+    }
+
+    if (to_visit.empty()) {
+        Logger::error("invalid render graph: no node renders to the final image!");
+    }
 
-        if (!finished.contains(neighbour)) {
-            cycles_helper(neighbour, discovered, finished);
+    // walk the dependencies backwards from the nodes producing the final image
+    while (!to_visit.empty()) {
+        const auto handle = to_visit.back();
+        to_visit.pop_back();
+
+        if (!live_nodes.emplace(handle).second) continue;
+
+        for (const auto dependency: dependency_graph.at(handle)) {
+            to_visit.push_back(dependency);
         }
     }
 
-    discovered.erase(handle);
-    finished.emplace(handle);
-};
+    if (live_nodes.size() == nodes.size()) return;
+
+    std::set<RenderNodeHandle> dead_nodes;
 
-void RenderGraph::check_dependency_cycles() const {
-    std::set<RenderNodeHandle> discovered, finished;
+    for (const auto &[handle, node]: nodes) {
+        if (live_nodes.contains(handle)) continue;
 
-    for (const auto &[handle, _]: nodes) {
-        if (!discovered.contains(handle) && !finished.contains(handle)) {
-            cycles_helper(handle, discovered, finished);
+        Logger::info("culling render node \"", node.name, "\": its outputs never reach the final image");
+        dead_nodes.insert(handle);
+    }
+
+    remove_nodes(dead_nodes);
+
+    const auto erase_dead = [&](auto &resource_index) {
+        for (auto &[resource, node_handles]: resource_index) {
+            std::erase_if(node_handles, [&](const RenderNodeHandle h) { return !live_nodes.contains(h); });
         }
+
+        std::erase_if(resource_index, [](const auto &entry) { return entry.second.empty(); });
+    };
+
+    erase_dead(resource_writers);
+    erase_dead(resource_readers);
+}
+
+void RenderGraph::remove_nodes(const std::set<RenderNodeHandle> &handles) {
+    for (const auto handle: handles) {
+        dependency_graph.erase(handle);
+        node_usages.erase(handle);
+        node_versions.erase(handle);
+        compute_nodes.erase(handle);
+        nodes.erase(handle);
+    }
+}
+
+void RenderGraph::sort_topologically() {
+    std::map<RenderNodeHandle, size_t> remaining_dependency_counts;
+    vector<RenderNodeHandle> current_level;
+
+    for (const auto &[handle, dependencies]: dependency_graph) {
+        remaining_dependency_counts.emplace(handle, dependencies.size());
+
+        if (dependencies.empty()) {
+            current_level.push_back(handle);
+        }
+    }
+
+    size_t sorted_count = 0;
+
+    // kahn's algorithm, releasing nodes one whole level at a time
+    while (!current_level.empty()) {
+        vector<RenderNodeHandle> next_level;
+
+        for (const auto handle: current_level) {
+            for (const auto dependent: dependents_graph.at(handle)) {
+                if (--remaining_dependency_counts.at(dependent) == 0) {
+                    next_level.push_back(dependent);
+                }
+            }
+        }
+
+        std::ranges::sort(next_level);
+
+        sorted_count += current_level.size();
+        topo_levels.emplace_back(std::move(current_level));
+        current_level = std::move(next_level);
+    }
+
+    if (sorted_count != nodes.size()) {
+        Logger::error("invalid render graph: illegal cycle in dependency graph!");
+    }
+}
+
+void RenderGraph::validate_compute_node(const RenderNodeHandle handle, const NodeResourceUsage &usage) const {
+    const auto &node = nodes.at(handle);
+
+    if (!compute_nodes.contains(handle)) {
+        if (!node.storage_targets.empty()) {
+            Logger::error("invalid render node \"", node.name, "\": only compute nodes can have storage targets!");
+        }
+
+        return;
+    }
+
+    if (!node.color_targets.empty() || node.depth_target) {
+        Logger::error("invalid render node \"", node.name, "\": compute nodes cannot have attachments!");
+    }
+
+    if (!std::ranges::all_of(usage.pipelines, [&](const ResourceHandle p) { return compute_pipelines.contains(p); })) {
+        Logger::error("invalid render node \"", node.name, "\": compute nodes cannot bind graphics pipelines!");
+    }
+
+    if (node.custom_properties.async_compute && node.custom_properties.cache_commands) {
+        Logger::error("invalid render node \"", node.name, "\": async compute nodes cannot cache their commands!");
+    }
+}
+
+void RenderGraph::find_cross_queue_dependencies() {
+    for (const auto &[handle, dependencies]: dependency_graph) {
+        auto &cross_dependencies = cross_queue_dependencies[handle];
+
+        for (const auto dependency: dependencies) {
+            if (is_async_compute_node(dependency) != is_async_compute_node(handle)) {
+                cross_dependencies.insert(dependency);
+                nodes_with_cross_queue_dependents.insert(dependency);
+            }
+        }
+    }
+}
+
+void RenderGraph::compute_aliasable_lifetimes(
+    const std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_writers,
+    const std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_readers
+) {
+    std::map<RenderNodeHandle, size_t> node_levels;
+
+    for (size_t level = 0; level < topo_levels.size(); level++) {
+        for (const auto handle: topo_levels[level]) {
+            node_levels.emplace(handle, level);
+        }
+    }
+
+    std::set<ResourceHandle> candidates;
+
+    for (const auto &[handle, description]: empty_tex_resources) {
+        if (!(description.tex_flags & vk::TextureFlagBitsZRX::CUBEMAP)) candidates.insert(handle);
+    }
+
+    for (const auto &[handle, description]: transient_tex_resources) {
+        if (!(description.tex_flags & vk::TextureFlagBitsZRX::CUBEMAP)) candidates.insert(handle);
+    }
+
+    // the queues run concurrently, so the order of levels doesn't say when async compute resources are used
+    for (const auto handle: get_async_compute_resources()) {
+        candidates.erase(handle);
+    }
+
+    for (const auto handle: candidates) {
+        const auto writers_it = resource_writers.find(handle);
+        if (writers_it == resource_writers.end()) continue;
+
+        // if a writer might be skipped, the contents written in an earlier frame have to be preserved
+        const bool has_conditional_writer = std::ranges::any_of(writers_it->second, [&](const RenderNodeHandle w) {
+            return nodes.at(w).should_run_predicate.has_value();
+        });
+
+        if (has_conditional_writer) continue;
+
+        ResourceLifetime lifetime{
+            .first_level = topo_levels.size(),
+            .last_level = 0,
+        };
+
+        for (const auto writer: writers_it->second) {
+            lifetime.first_level = std::min(lifetime.first_level, node_levels.at(writer));
+            lifetime.last_level  = std::max(lifetime.last_level, node_levels.at(writer));
+        }
+
+        // readers always depend on all writers, so the first use is guaranteed to be a write
+        if (const auto readers_it = resource_readers.find(handle); readers_it != resource_readers.end()) {
+            for (const auto reader: readers_it->second) {
+                lifetime.last_level = std::max(lifetime.last_level, node_levels.at(reader));
+            }
+        }
+
+        aliasable_lifetimes.emplace(handle, lifetime);
+    }
+}
+
+void RenderGraph::infer_attachment_ops() {
+    // the swapchain's color and depth images share a handle, so attachments are told apart by their aspect too
+    using AttachmentKey = std::pair<ResourceHandle, bool>;
+
+    vector<RenderNodeHandle> order;
+
+    for (const auto &level: topo_levels) {
+        order.insert(order.end(), level.begin(), level.end());
+    }
+
+    std::map<AttachmentKey, vector<size_t> > write_positions;
+    std::map<ResourceHandle, vector<size_t> > read_positions;
+    std::set<AttachmentKey> conditionally_written;
+
+    for (size_t position = 0; position < order.size(); position++) {
+        const auto &node = nodes.at(order[position]);
+        const auto &usage = node_usages.at(order[position]);
+
+        vector<AttachmentKey> written;
+
+        for (const auto target: node.color_targets) written.emplace_back(target, false);
+
+        if (node.depth_target) written.emplace_back(*node.depth_target, true);
+
+        for (const auto target: node.storage_targets) written.emplace_back(target, false);
+
+        for (const auto &key: written) {
+            write_positions[key].push_back(position);
+            if (node.should_run_predicate) conditionally_written.insert(key);
+        }
+
+        for (const auto resource: usage.shader_resources) read_positions[resource].push_back(position);
+    }
+
+    const auto is_used_after = [](const auto &positions, const size_t position) {
+        return !positions.empty() && positions.back() > position;
+    };
+
+    for (size_t position = 0; position < order.size(); position++) {
+        const auto &node = nodes.at(order[position]);
+
+        const auto infer_ops = [&](const ResourceHandle handle, const bool is_depth) {
+            const AttachmentKey key{handle, is_depth};
+            const auto &writes = write_positions.at(key);
+            const auto reads_it = read_positions.find(handle);
+
+            // the final color image is presented, and contents written by a node which can be skipped
+            // have to survive until a frame in which it is
+            const bool is_needed_later = (handle == FINAL_IMAGE_RESOURCE_HANDLE && !is_depth)
+                                         || conditionally_written.contains(key)
+                                         || is_used_after(writes, position)
+                                         || (reads_it != read_positions.end()
+                                             && is_used_after(reads_it->second, position));
+
+            return AttachmentOps{
+                .load_op = writes.front() < position ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear,
+                .store_op = is_needed_later ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
+            };
+        };
+
+        NodeAttachmentOps ops;
+
+        for (const auto target: node.color_targets) {
+            ops.color_ops.push_back(infer_ops(target, false));
+        }
+
+        if (node.depth_target) {
+            ops.depth_ops = infer_ops(*node.depth_target, true);
+        }
+
+        attachment_ops.emplace(order[position], std::move(ops));
+    }
+}
+
+void RenderGraph::check_not_compiled() const {
+    if (is_compiled) {
+        Logger::error("invalid render graph usage: cannot modify a graph after it has been compiled!");
     }
 }
 
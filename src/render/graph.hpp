@@ -1,10 +1,12 @@
 #pragma once
 
+#include <array>
 #include <filesystem>
 #include <functional>
 #include <string>
 #include <map>
 #include <set>
+#include <type_traits>
 #include <variant>
 
 #include "mesh/model.hpp"
@@ -14,7 +16,10 @@
 
 namespace zrx {
 class DescriptorSet;
+class Pipeline;
 class GraphicsPipeline;
+class ComputePipeline;
+struct RenderGraphPlan;
 
 namespace detail {
     template<typename T>
@@ -30,11 +35,25 @@ using RenderNodeHandle = uint32_t;
 static constexpr ResourceHandle FINAL_IMAGE_RESOURCE_HANDLE = -1;
 static constexpr std::monostate EMPTY_DESCRIPTOR_SET_BINDING = {};
 
+/**
+ * Host-visible uniform buffer, holding a separate slice of `size` bytes for every frame in flight.
+ * The slice of the frame being recorded is written through `FrameBeginActionContext::get_uniform_buffer_slice`.
+ */
 struct UniformBufferResource {
     std::string name;
     vk::DeviceSize size;
 };
 
+/**
+ * Device-local buffer written by compute nodes through storage buffer bindings. It can be read
+ * through storage bindings in any shader, and used as the source of indirect dispatch arguments
+ * or of culled draws.
+ */
+struct StorageBufferResource {
+    std::string name;
+    vk::DeviceSize size;
+};
+
 struct ExternalTextureResource {
     std::string name;
     vector<std::filesystem::path> paths;
@@ -48,6 +67,7 @@ struct EmptyTextureResource {
     vk::Extent2D extent = {0, 0}; // {0, 0} means we're using the swapchain image's extent
     vk::Format format;
     vk::TextureFlagsZRX tex_flags = vk::TextureFlagBitsZRX::MIPMAPS;
+    float resolution_scale = 1.0f; // applied to the swapchain image's extent, if that's the one being used
 };
 
 struct TransientTextureResource {
@@ -55,11 +75,14 @@ struct TransientTextureResource {
     vk::Format format;
     vk::Extent2D extent = {0, 0}; // {0, 0} means we're using the swapchain image's extent
     vk::TextureFlagsZRX tex_flags{};
+    float resolution_scale = 1.0f; // applied to the swapchain image's extent, if that's the one being used
 };
 
 struct ModelResource {
     std::string name;
     std::filesystem::path path;
+    VertexFormat vertex_format = VertexFormat::FULL; // has to match the vertex type of pipelines drawing the model
+    bool use_importer_cache_optimization = false; // see `Model::Model`
 };
 
 // basically same purpose as std::monostate but with a specific name
@@ -71,6 +94,8 @@ struct ShaderPack {
     using AttachmentFormat = std::variant<vk::Format, FinalImageFormatPlaceholder>;
 
     std::filesystem::path vertex_path;
+    std::filesystem::path task_path;
+    std::filesystem::path mesh_path;
     std::filesystem::path fragment_path;
     vector<DescriptorSetDescription> descriptor_set_descs;
     vector<vk::VertexInputBindingDescription> binding_descriptions;
@@ -84,6 +109,15 @@ struct ShaderPack {
         uint32_t multiview_count = 1;
     } custom_properties;
 
+    /**
+     * Stages of a pack drawn through `VK_EXT_mesh_shader`, whose mesh shader replaces the vertex shader
+     * and fetches the vertices itself. The task shader is optional.
+     */
+    struct MeshShaders {
+        std::filesystem::path task_path;
+        std::filesystem::path mesh_path;
+    };
+
     template<typename VertexType>
         requires VertexLike<VertexType>
     ShaderPack(
@@ -108,61 +142,395 @@ struct ShaderPack {
         }
     }
 
+    // `CustomProperties` can't be a default argument here, as its member initializers aren't usable until the end
+    // of this class. the templated ctor above only gets away with it because it's instantiated later.
+    ShaderPack(
+        MeshShaders &&mesh_shaders,
+        std::filesystem::path &&fragment_path_,
+        vector<DescriptorSetDescription> &&descriptor_set_descs_,
+        vector<AttachmentFormat> colors,
+        const std::optional<AttachmentFormat> depth_format = {}
+    )
+        : ShaderPack(std::move(mesh_shaders), std::move(fragment_path_), std::move(descriptor_set_descs_),
+                     std::move(colors), depth_format, CustomProperties{}) {
+    }
+
+    ShaderPack(
+        MeshShaders &&mesh_shaders,
+        std::filesystem::path &&fragment_path_,
+        vector<DescriptorSetDescription> &&descriptor_set_descs_,
+        vector<AttachmentFormat> colors,
+        const std::optional<AttachmentFormat> depth_format,
+        CustomProperties &&custom_properties
+    )
+        : task_path(std::move(mesh_shaders.task_path)), mesh_path(std::move(mesh_shaders.mesh_path)),
+          fragment_path(fragment_path_),
+          descriptor_set_descs(descriptor_set_descs_),
+          color_formats(std::move(colors)), depth_format(depth_format),
+          custom_properties(custom_properties) {
+        for (auto &set_desc: descriptor_set_descs) {
+            while (!set_desc.empty() && std::holds_alternative<std::monostate>(set_desc.back())) {
+                set_desc.pop_back();
+            }
+        }
+    }
+
+    [[nodiscard]] bool uses_mesh_shaders() const { return !mesh_path.empty(); }
+
+    [[nodiscard]] std::set<ResourceHandle> get_bound_resources_set() const;
+};
+
+/**
+ * Compute counterpart of `ShaderPack`. Resources bound to storage bindings of the shader have to be declared
+ * by the node using the pipeline, either as storage targets if they're written, or as storage inputs otherwise.
+ */
+struct ComputeShaderPack {
+    std::filesystem::path compute_path;
+    vector<ShaderPack::DescriptorSetDescription> descriptor_set_descs;
+
     [[nodiscard]] std::set<ResourceHandle> get_bound_resources_set() const;
 };
 
+/**
+ * Push constants set by `IRenderPassContext::draw_model` before drawing the model, provided that the bound
+ * pipeline uses push constants at all. Such pipelines have to begin their push constant block with these members.
+ * Shaders find the description of the mesh being drawn at `mesh_descriptions[mesh_offset + gl_DrawID]`.
+ * Indirect draws cover all of the model's meshes, so the offset is only nonzero for draws of single meshes.
+ */
+struct ScenePushConstants {
+    vk::DeviceAddress mesh_descriptions;
+    uint32_t mesh_offset;
+
+    // the trailing padding isn't a part of the shaders' push constant block
+    static constexpr uint32_t SIZE = sizeof(vk::DeviceAddress) + sizeof(uint32_t);
+};
+
+// layout of a storage buffer filled by the instance culling shaders and drawn from by
+// `IRenderPassContext::draw_model_culled`. it has to match `shaders/utils/culling.glsl` and `culling-common.glsl`.
+static constexpr uint32_t CULLING_WORKGROUP_SIZE = 64;
+static constexpr uint32_t MAX_CULLED_MESHES = 1024;
+static constexpr uint32_t MAX_CULLED_INSTANCES = 65536;
+static constexpr vk::DeviceSize CULLED_DRAW_COUNT_OFFSET = 0;
+static constexpr vk::DeviceSize CULLED_DRAWS_OFFSET = 16;
+static constexpr vk::DeviceSize CULLED_TRANSFORMS_OFFSET =
+        CULLED_DRAWS_OFFSET + MAX_CULLED_MESHES * sizeof(vk::DrawIndexedIndirectCommand);
+static constexpr vk::DeviceSize CULLED_DRAWS_BUFFER_SIZE =
+        CULLED_TRANSFORMS_OFFSET + MAX_CULLED_INSTANCES * sizeof(glm::mat4);
+
+static_assert(CULLED_TRANSFORMS_OFFSET % 16 == 0, "std430 aligns arrays of matrices to 16 bytes");
+
+// layout of a storage buffer filled by the meshlet culling shaders and drawn from by
+// `IRenderPassContext::draw_model_meshlet_culled`. it has to match `shaders/utils/meshlet-culling.glsl`.
+// each mesh's surviving indices are compacted into the buffer's own `indices` array, starting at the same offset
+// as the mesh's indices in the model's index buffer. with mesh shaders, only the task commands are used instead,
+// which launch a task shader workgroup per `MESH_TASK_MESHLETS` meshlets and visible instance of each mesh.
+static constexpr uint32_t MAX_CULLED_MESHLETS = 1 << 17;
+static constexpr uint32_t MAX_MESHLET_CULLED_INDICES = 1 << 23;
+static constexpr uint32_t MESH_TASK_MESHLETS = 32;
+static constexpr vk::DeviceSize MESHLET_CULLED_DRAWS_OFFSET = 0;
+static constexpr vk::DeviceSize MESHLET_CULLED_TASKS_OFFSET =
+        MESHLET_CULLED_DRAWS_OFFSET + MAX_CULLED_MESHES * sizeof(vk::DrawIndexedIndirectCommand);
+static constexpr vk::DeviceSize MESHLET_CULLED_INDEX_COUNTS_OFFSET =
+        MESHLET_CULLED_TASKS_OFFSET + MAX_CULLED_MESHES * sizeof(vk::DrawMeshTasksIndirectCommandEXT);
+static constexpr vk::DeviceSize MESHLET_CULLED_INDICES_OFFSET =
+        MESHLET_CULLED_INDEX_COUNTS_OFFSET + MAX_CULLED_MESHLETS * sizeof(uint32_t);
+static constexpr vk::DeviceSize MESHLET_CULLED_DRAWS_BUFFER_SIZE =
+        MESHLET_CULLED_INDICES_OFFSET + MAX_MESHLET_CULLED_INDICES * sizeof(uint32_t);
+
+// layout of a storage buffer holding a hierarchical depth buffer, which has to match `shaders/utils/hi-z.glsl`.
+// a texel of level `n` holds the farthest depth within a square of 2^n pixels, and only the levels coarse enough
+// to be useful for culling whole instances are stored. the buffer starts with the extent of the source depth.
+static constexpr uint32_t HI_Z_TILE_SIZE = 32; // pixels reduced by a single workgroup of the building shader
+static constexpr uint32_t HI_Z_MAX_EXTENT = 4096;
+static constexpr uint32_t HI_Z_FIRST_LEVEL = 3;
+static constexpr uint32_t HI_Z_LAST_LEVEL = 5;
+static constexpr vk::DeviceSize HI_Z_DEPTHS_OFFSET = 16;
+static constexpr vk::DeviceSize HI_Z_BUFFER_SIZE = [] {
+    vk::DeviceSize texel_count = 0;
+
+    for (uint32_t level = HI_Z_FIRST_LEVEL; level <= HI_Z_LAST_LEVEL; level++) {
+        texel_count += (HI_Z_MAX_EXTENT >> level) * (HI_Z_MAX_EXTENT >> level);
+    }
+
+    return HI_Z_DEPTHS_OFFSET + texel_count * sizeof(float);
+}();
+
+// lowest limits on the task shader workgroups of a single draw, per dimension and in total,
+// which every device with `VK_EXT_mesh_shader` supports
+static constexpr uint32_t MAX_MESH_TASK_GROUP_COUNT = 65535;
+static constexpr uint32_t MAX_MESH_TASK_GROUP_TOTAL_COUNT = 1 << 22;
+
+/**
+ * Push constants set by `IRenderPassContext::draw_model_meshlet_culled` for pipelines with mesh shaders, which
+ * have to continue their push constant block with these, right after `ScenePushConstants` and its padding.
+ */
+struct MeshShadingPushConstants {
+    ModelMeshletInputs model;
+
+    static constexpr uint32_t OFFSET = sizeof(ScenePushConstants);
+};
+
+/**
+ * Push constants set by `IRenderPassContext::dispatch_model_culling` before dispatching the bound culling pipeline.
+ */
+struct CullingPushConstants {
+    ModelCullingInputs model;
+    uint32_t instance_count;
+    uint32_t mesh_count;
+    uint32_t meshlet_count;
+};
+
+enum class CullingStage {
+    PREPARE_DRAWS,    // one invocation per mesh, resetting its draw or copying it from an earlier culling pass
+    CULL_INSTANCES,   // one invocation per instance, appending it to its mesh's draw if it's visible
+    CULL_MESHLETS,    // one invocation per meshlet, counting the indices it contributes to its mesh's draw
+    COMPACT_MESHLETS, // one workgroup per mesh, copying the indices of its visible meshlets in their original order
+};
+
 class IRenderPassContext {
 public:
     virtual ~IRenderPassContext() = default;
 
     virtual void bind_pipeline(ResourceHandle pipeline_handle) = 0;
 
+    /**
+     * Updates a part of the push constant block of the currently bound pipeline. The block's layout
+     * is reflected from the pipeline's shaders, and it's visible to every stage which declares it.
+     */
+    virtual void push_constants(const void *data, uint32_t size, uint32_t offset = 0) = 0;
+
+    template<typename T>
+        requires std::is_trivially_copyable_v<T> && (!std::is_pointer_v<T>)
+    void push_constants(const T &data, const uint32_t offset = 0) {
+        push_constants(&data, static_cast<uint32_t>(sizeof(T)), offset);
+    }
+
     virtual void draw_model(ResourceHandle model_handle) = 0;
 
+    /**
+     * Draws the instances of the model which survived culling into `culled_draws_handle`, a storage buffer
+     * of `CULLED_DRAWS_BUFFER_SIZE` bytes. The number of recorded commands doesn't depend on the instance count.
+     */
+    virtual void draw_model_culled(ResourceHandle model_handle, ResourceHandle culled_draws_handle) = 0;
+
+    /**
+     * Like `draw_model_culled`, but only draws the meshlets which survived culling into `meshlet_draws_handle`,
+     * a storage buffer of `MESHLET_CULLED_DRAWS_BUFFER_SIZE` bytes. The meshlets are culled against the instances
+     * in `culled_draws_handle`, which are drawn along with them.
+     *
+     * The surviving meshlets are drawn through a compacted index buffer, which works on every device. Each mesh's
+     * meshlets are compacted by a prefix sum, so its triangles keep the order chosen by `optimize_overdraw`.
+     *
+     * If the bound pipeline has mesh shaders, its task shader culls the meshlets instead, so only the task commands
+     * of `meshlet_draws_handle` are read. The task shader reads the visible instances through a storage binding,
+     * which has to hold the same buffer as `culled_draws_handle`.
+     */
+    virtual void draw_model_meshlet_culled(ResourceHandle model_handle, ResourceHandle culled_draws_handle,
+                                           ResourceHandle meshlet_draws_handle) = 0;
+
+    /**
+     * Draws the instances of the model whose bounds intersect the frustum of `cull_matrix`, i.e. the product
+     * of the projection, view and model matrices. Culling runs on the cpu, so this works without compute nodes.
+     */
+    virtual void draw_model_frustum_culled(ResourceHandle model_handle, const glm::mat4 &cull_matrix) = 0;
+
+    /**
+     * Returns whether the model fits within the fixed capacities of the culled draws buffers, and within the limits
+     * on the task shader workgroups of a single draw if `uses_mesh_shaders` is set. Models which don't have to be
+     * drawn with `draw_model_frustum_culled` instead, as `dispatch_model_culling` and the culled draws skip them.
+     */
+    [[nodiscard]] virtual bool can_cull_model(ResourceHandle model_handle, bool uses_mesh_shaders) const = 0;
+
+    /**
+     * Dispatches the bound compute pipeline over the model's meshes or instances, depending on the stage.
+     * The pipeline has to be one of the culling shaders, which read the model through `CullingPushConstants`.
+     */
+    virtual void dispatch_model_culling(ResourceHandle model_handle, CullingStage stage) = 0;
+
+    /**
+     * Returns the part of a texture which is rendered to, e.g. to size dispatches which process its contents.
+     */
+    [[nodiscard]] virtual vk::Extent2D get_render_extent(ResourceHandle texture_handle) const = 0;
+
     virtual void draw(ResourceHandle vertices_handle, uint32_t vertex_count, uint32_t instance_count,
                       uint32_t first_vertex, uint32_t first_instance) = 0;
+
+    virtual void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) = 0;
+
+    virtual void dispatch_indirect(ResourceHandle buffer_handle, vk::DeviceSize offset) = 0;
+};
+
+/**
+ * Commands recorded by a single node, along with the binds which were skipped because they were redundant.
+ */
+struct RenderPassStats {
+    uint32_t draw_count = 0;
+    uint32_t dispatch_count = 0;
+    uint64_t triangle_count = 0; // assumes that draws use triangle lists
+    uint32_t pipeline_binds = 0;
+    uint32_t descriptor_set_binds = 0;
+    uint32_t buffer_binds = 0;
+    uint32_t skipped_binds = 0;
+    uint32_t culled_instances = 0; // rejected by frustum culling on the cpu
+
+    RenderPassStats &operator+=(const RenderPassStats &other);
 };
 
 class RenderPassContext final : public IRenderPassContext {
+    static constexpr size_t MAX_DESCRIPTOR_SETS = 8;
+    static constexpr size_t MAX_DYNAMIC_OFFSETS = 16;
+    static constexpr size_t MAX_VERTEX_BUFFERS = 2;
+
+    /**
+     * State bound at one of the pipeline bind points. Binds which wouldn't change it are skipped.
+     */
+    struct BindPointState {
+        vk::Pipeline pipeline;
+        vk::PipelineLayout layout;
+        std::array<vk::DescriptorSet, MAX_DESCRIPTOR_SETS> sets{};
+        size_t set_count = 0;
+        std::array<uint32_t, MAX_DYNAMIC_OFFSETS> dynamic_offsets{};
+        size_t dynamic_offset_count = 0;
+    };
+
     reference_wrapper<const vk::raii::CommandBuffer> command_buffer;
     reference_wrapper<ResourceManager> resource_manager;
     reference_wrapper<const std::map<ResourceHandle, GraphicsPipeline> > pipelines;
+    reference_wrapper<const std::map<ResourceHandle, ComputePipeline> > compute_pipelines;
     reference_wrapper<const std::map<ResourceHandle, vector<DescriptorSet> > > pipeline_desc_sets;
+    reference_wrapper<const std::map<ResourceHandle, vector<vk::DeviceSize> > > pipeline_dynamic_slice_sizes;
+    uint32_t frame_index;
+    const Pipeline *bound_pipeline = nullptr;
+    bool is_mesh_shading_bound = false;
+
+    BindPointState graphics_state;
+    BindPointState compute_state;
+    std::array<std::pair<vk::Buffer, vk::DeviceSize>, MAX_VERTEX_BUFFERS> bound_vertex_buffers{};
+    std::pair<vk::Buffer, vk::DeviceSize> bound_index_buffer;
+
+    RenderPassStats stats;
 
 public:
     explicit RenderPassContext(const vk::raii::CommandBuffer &cmd_buf, ResourceManager &rm,
                                const std::map<ResourceHandle, GraphicsPipeline> &pipelines,
-                               const std::map<ResourceHandle, vector<DescriptorSet> > &sets)
-        : command_buffer(cmd_buf), resource_manager(rm), pipelines(pipelines), pipeline_desc_sets(sets) {
+                               const std::map<ResourceHandle, ComputePipeline> &compute_pipelines,
+                               const std::map<ResourceHandle, vector<DescriptorSet> > &sets,
+                               const std::map<ResourceHandle, vector<vk::DeviceSize> > &dynamic_slice_sizes,
+                               const uint32_t frame_index)
+        : command_buffer(cmd_buf), resource_manager(rm), pipelines(pipelines), compute_pipelines(compute_pipelines),
+          pipeline_desc_sets(sets), pipeline_dynamic_slice_sizes(dynamic_slice_sizes), frame_index(frame_index) {
     }
 
     ~RenderPassContext() override = default;
 
+    using IRenderPassContext::push_constants;
+
     void bind_pipeline(ResourceHandle pipeline_handle) override;
 
+    void push_constants(const void *data, uint32_t size, uint32_t offset) override;
+
     void draw_model(ResourceHandle model_handle) override;
 
+    void draw_model_culled(ResourceHandle model_handle, ResourceHandle culled_draws_handle) override;
+
+    void draw_model_meshlet_culled(ResourceHandle model_handle, ResourceHandle culled_draws_handle,
+                                   ResourceHandle meshlet_draws_handle) override;
+
+    void draw_model_frustum_culled(ResourceHandle model_handle, const glm::mat4 &cull_matrix) override;
+
+    [[nodiscard]] bool can_cull_model(ResourceHandle model_handle, bool uses_mesh_shaders) const override;
+
+    void dispatch_model_culling(ResourceHandle model_handle, CullingStage stage) override;
+
+    [[nodiscard]] vk::Extent2D get_render_extent(ResourceHandle texture_handle) const override;
+
     void draw(ResourceHandle vertices_handle, uint32_t vertex_count, uint32_t instance_count,
               uint32_t first_vertex, uint32_t first_instance) override;
+
+    void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override;
+
+    void dispatch_indirect(ResourceHandle buffer_handle, vk::DeviceSize offset) override;
+
+    [[nodiscard]] const RenderPassStats &get_stats() const { return stats; }
+
+private:
+    void bind_descriptor_sets(BindPointState &state, vk::PipelineBindPoint bind_point, const Pipeline &pipeline,
+                              ResourceHandle pipeline_handle);
+
+    void bind_vertex_buffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset = 0);
+
+    void bind_index_buffer(vk::Buffer buffer, vk::DeviceSize offset = 0);
+
+    void bind_model_buffers(const Model &model, vk::Buffer instance_buffer, vk::DeviceSize instance_offset,
+                            vk::Buffer index_buffer, vk::DeviceSize index_offset);
 };
 
 class ShaderGatherRenderPassContext final : public IRenderPassContext {
     vector<ResourceHandle> used_pipelines;
+    vector<ResourceHandle> used_draw_resources;
+    vector<ResourceHandle> used_indirect_buffers;
 
 public:
     ~ShaderGatherRenderPassContext() override = default;
 
     [[nodiscard]] const vector<ResourceHandle> &get() const { return used_pipelines; }
 
+    [[nodiscard]] const vector<ResourceHandle> &get_draw_resources() const { return used_draw_resources; }
+
+    [[nodiscard]] const vector<ResourceHandle> &get_indirect_buffers() const { return used_indirect_buffers; }
+
+    using IRenderPassContext::push_constants;
+
     void bind_pipeline(const ResourceHandle pipeline_handle) override {
         used_pipelines.push_back(pipeline_handle);
     }
 
-    void draw_model(ResourceHandle model_handle) override {
+    void push_constants(const void *data, uint32_t size, uint32_t offset) override {
     }
 
-    void draw(ResourceHandle vertices_handle, uint32_t vertex_count, uint32_t instance_count,
+    void draw_model(const ResourceHandle model_handle) override {
+        used_draw_resources.push_back(model_handle);
+    }
+
+    void draw_model_culled(const ResourceHandle model_handle, const ResourceHandle culled_draws_handle) override {
+        used_draw_resources.push_back(model_handle);
+        used_indirect_buffers.push_back(culled_draws_handle);
+    }
+
+    void draw_model_meshlet_culled(const ResourceHandle model_handle, const ResourceHandle culled_draws_handle,
+                                   const ResourceHandle meshlet_draws_handle) override {
+        used_draw_resources.push_back(model_handle);
+        used_indirect_buffers.push_back(culled_draws_handle);
+        used_indirect_buffers.push_back(meshlet_draws_handle);
+    }
+
+    void draw_model_frustum_culled(const ResourceHandle model_handle, const glm::mat4 &cull_matrix) override {
+        used_draw_resources.push_back(model_handle);
+    }
+
+    // models aren't loaded yet while gathering, so the culled draws' resources are always gathered
+    [[nodiscard]] bool can_cull_model(ResourceHandle model_handle, bool uses_mesh_shaders) const override {
+        return true;
+    }
+
+    void dispatch_model_culling(const ResourceHandle model_handle, CullingStage stage) override {
+        used_draw_resources.push_back(model_handle);
+    }
+
+    [[nodiscard]] vk::Extent2D get_render_extent(ResourceHandle texture_handle) const override {
+        return {1, 1};
+    }
+
+    void draw(const ResourceHandle vertices_handle, uint32_t vertex_count, uint32_t instance_count,
               uint32_t first_vertex, uint32_t first_instance) override {
+        used_draw_resources.push_back(vertices_handle);
+    }
+
+    void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override {
+    }
+
+    void dispatch_indirect(const ResourceHandle buffer_handle, vk::DeviceSize offset) override {
+        used_indirect_buffers.push_back(buffer_handle);
     }
 };
 
@@ -173,48 +541,196 @@ struct RenderNode {
     std::string name;
     vector<ResourceHandle> color_targets;
     std::optional<ResourceHandle> depth_target;
+    vector<ResourceHandle> storage_targets; // written through storage bindings by compute nodes
+    vector<ResourceHandle> storage_inputs;  // read-only through storage bindings
     RenderNodeBodyFn body;
     vector<RenderNodeHandle> explicit_dependencies;
     std::optional<ShouldRunPredicate> should_run_predicate;
 
     struct CustomProperties {
         uint32_t multiview_count = 1;
+
+        // records the node's commands once and replays them until a resource they reference changes.
+        // only suitable for nodes whose body records the same commands every frame.
+        bool cache_commands = false;
+
+        // runs the node on the async compute queue, letting it overlap with rasterization.
+        // only compute nodes, i.e. ones which bind compute pipelines, can do this.
+        bool async_compute = false;
     } custom_properties;
 
     [[nodiscard]] std::set<ResourceHandle> get_all_targets_set() const;
 
+    [[nodiscard]] std::set<ResourceHandle> get_used_pipelines_set() const;
+
     [[nodiscard]] std::set<ResourceHandle>
     get_all_shader_resources_set(const std::map<ResourceHandle, ShaderPack> &shaders) const;
 };
 
 struct FrameBeginActionContext {
     reference_wrapper<ResourceManager> resource_manager;
+    uint32_t frame_index; // index of the frame in flight which is about to be recorded
+
+    /**
+     * Returns the persistently mapped slice of a graph uniform buffer which is read by the frame about to be
+     * recorded. Earlier frames in flight might still be reading their own slices, so only this one can be written.
+     */
+    [[nodiscard]] void *get_uniform_buffer_slice(ResourceHandle handle) const;
 };
 
 using FrameBeginCallback = std::function<void(const FrameBeginActionContext &)>;
 
 class RenderGraph {
+    /**
+     * Resources read and written by a single node, gathered once during compilation.
+     */
+    struct NodeResourceUsage {
+        std::set<ResourceHandle> targets;
+        std::set<ResourceHandle> pipelines;
+        std::set<ResourceHandle> shader_resources;
+        std::set<ResourceHandle> draw_resources;
+        std::set<ResourceHandle> indirect_buffers;
+
+        [[nodiscard]] bool references(ResourceHandle handle) const;
+    };
+
     std::map<RenderNodeHandle, RenderNode> nodes;
     std::map<RenderNodeHandle, std::set<RenderNodeHandle> > dependency_graph;
+    std::map<RenderNodeHandle, std::set<RenderNodeHandle> > dependents_graph;
+    std::map<RenderNodeHandle, NodeResourceUsage> node_usages;
+
+    // nodes which dispatch compute pipelines instead of rendering to attachments
+    std::set<RenderNodeHandle> compute_nodes;
+
+    // dependencies of each node which run on the other queue, and thus need a semaphore instead of a barrier
+    std::map<RenderNodeHandle, std::set<RenderNodeHandle> > cross_queue_dependencies;
+    std::set<RenderNodeHandle> nodes_with_cross_queue_dependents;
+
+    // bumped whenever something referenced by a node's commands changes, invalidating commands cached for it
+    std::map<RenderNodeHandle, uint64_t> node_versions;
+    vector<vector<RenderNodeHandle> > topo_levels;
+    bool is_compiled = false;
+
+    /**
+     * Range of topological levels during which a resource's contents have to be preserved.
+     */
+    struct ResourceLifetime {
+        size_t first_level;
+        size_t last_level;
+    };
+
+    // lifetimes of the textures which don't have to outlive a single frame, and thus can share memory
+    std::map<ResourceHandle, ResourceLifetime> aliasable_lifetimes;
+
+    struct AttachmentOps {
+        vk::AttachmentLoadOp load_op = vk::AttachmentLoadOp::eClear;
+        vk::AttachmentStoreOp store_op = vk::AttachmentStoreOp::eStore;
+    };
+
+    /**
+     * Load and store operations of a node's attachments, inferred from what the other nodes
+     * do with the attachments' contents.
+     */
+    struct NodeAttachmentOps {
+        // in the same order as the node's color targets
+        vector<AttachmentOps> color_ops;
+        AttachmentOps depth_ops;
+    };
+
+    std::map<RenderNodeHandle, NodeAttachmentOps> attachment_ops;
 
     std::map<ResourceHandle, UniformBufferResource> uniform_buffers;
+    std::map<ResourceHandle, StorageBufferResource> storage_buffers;
     std::map<ResourceHandle, ExternalTextureResource> external_tex_resources;
     std::map<ResourceHandle, EmptyTextureResource> empty_tex_resources;
     std::map<ResourceHandle, TransientTextureResource> transient_tex_resources;
     std::map<ResourceHandle, ModelResource> model_resources;
     std::map<ResourceHandle, ShaderPack> pipelines;
+    std::map<ResourceHandle, ComputeShaderPack> compute_pipelines;
 
     vector<FrameBeginCallback> frame_begin_callbacks;
 
     friend class VulkanRenderer;
+    friend struct RenderGraphPlan;
 
 public:
+    /**
+     * Infers the dependencies between nodes, validates the graph and freezes it.
+     * Nodes and resources can't be added to a graph after it's been compiled.
+     * Compiling an already compiled graph is a no-op.
+     *
+     * If given a plan saved after compiling an identical graph, the topology and resource lifetimes
+     * are restored from it instead of being inferred again.
+     */
+    void compile(const RenderGraphPlan *plan = nullptr);
+
+    /**
+     * Returns a hash of everything which affects the compiled graph and the layouts of its pipelines,
+     * including the contents of the shader binaries.
+     */
+    [[nodiscard]] std::uint64_t hash_description() const;
+
+    [[nodiscard]] bool compiled() const { return is_compiled; }
+
+    /**
+     * Returns the nodes grouped into levels. Nodes within a single level don't depend on each other,
+     * and each node depends only on nodes from earlier levels.
+     */
+    [[nodiscard]] const vector<vector<RenderNodeHandle> > &get_topo_levels() const;
+
     [[nodiscard]] vector<RenderNodeHandle> get_topo_sorted() const;
 
+    /**
+     * Returns the nodes which directly depend on the given node, i.e. the consumers of its outputs.
+     */
+    [[nodiscard]] const std::set<RenderNodeHandle> &get_dependents(RenderNodeHandle handle) const;
+
+    /**
+     * Returns whether the given node renders to the final image, i.e. whether it's a root of the graph
+     * from which the liveness of other nodes is derived.
+     */
+    [[nodiscard]] bool is_output_node(RenderNodeHandle handle) const;
+
+    [[nodiscard]] bool is_compute_node(RenderNodeHandle handle) const;
+
+    [[nodiscard]] bool is_async_compute_node(RenderNodeHandle handle) const;
+
+    /**
+     * Returns the dependencies of a node which run on a different queue than the node itself.
+     * These are the only places where the queues have to wait for one another.
+     */
+    [[nodiscard]] const std::set<RenderNodeHandle> &get_cross_queue_dependencies(RenderNodeHandle handle) const;
+
+    /**
+     * Returns whether any node consuming this node's outputs runs on a different queue.
+     */
+    [[nodiscard]] bool has_cross_queue_dependents(RenderNodeHandle handle) const;
+
+    /**
+     * Returns every resource accessed by at least one async compute node.
+     */
+    [[nodiscard]] std::set<ResourceHandle> get_async_compute_resources() const;
+
+    [[nodiscard]] const NodeAttachmentOps &get_attachment_ops(RenderNodeHandle handle) const;
+
+    /**
+     * Notifies the graph that a resource was recreated or otherwise changed in a way which invalidates
+     * previously recorded commands referencing it. Can be called after compilation.
+     */
+    void mark_resource_changed(ResourceHandle handle);
+
+    /**
+     * Returns the version of everything the node's commands reference. Commands recorded for the node
+     * stay valid as long as this doesn't change.
+     */
+    [[nodiscard]] uint64_t get_node_version(RenderNodeHandle handle) const;
+
     RenderNodeHandle add_node(const RenderNode &node);
 
     [[nodiscard]] ResourceHandle add_resource(UniformBufferResource &&resource);
 
+    [[nodiscard]] ResourceHandle add_resource(StorageBufferResource &&resource);
+
     [[nodiscard]] ResourceHandle add_resource(ExternalTextureResource &&resource);
 
     [[nodiscard]] ResourceHandle add_resource(EmptyTextureResource &&resource);
@@ -225,21 +741,47 @@ public:
 
     [[nodiscard]] ResourceHandle add_pipeline(ShaderPack &&resource);
 
+    [[nodiscard]] ResourceHandle add_pipeline(ComputeShaderPack &&resource);
+
     void add_frame_begin_action(FrameBeginCallback &&callback);
 
 private:
-    void cycles_helper(RenderNodeHandle handle, std::set<RenderNodeHandle> &discovered,
-                       std::set<RenderNodeHandle> &finished) const;
+    /**
+     * Removes nodes whose outputs never reach the final image, neither directly nor through other nodes.
+     */
+    void cull_dead_nodes(std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_writers,
+                         std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_readers);
+
+    /**
+     * Removes the given nodes, along with everything gathered for them during compilation.
+     */
+    void remove_nodes(const std::set<RenderNodeHandle> &handles);
+
+    void sort_topologically();
+
+    void validate_compute_node(RenderNodeHandle handle, const NodeResourceUsage &usage) const;
+
+    void find_cross_queue_dependencies();
+
+    void compute_aliasable_lifetimes(const std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_writers,
+                                     const std::map<ResourceHandle, vector<RenderNodeHandle> > &resource_readers);
+
+    /**
+     * Chooses the load and store operations of every attachment, so that its contents are only loaded
+     * if an earlier node wrote them, and only stored if a later node (or a later frame) needs them.
+     */
+    void infer_attachment_ops();
 
-    void check_dependency_cycles() const;
+    void check_not_compiled() const;
 
     [[nodiscard]] static ResourceHandle get_new_node_handle();
 
     [[nodiscard]] static ResourceHandle get_new_resource_handle();
 
     template<typename ResourceType>
-    [[nodiscard]] static ResourceHandle
+    [[nodiscard]] ResourceHandle
     add_resource_generic(ResourceType &&resource, std::map<ResourceHandle, ResourceType> &resource_map) {
+        check_not_compiled();
         const auto handle = get_new_resource_handle();
         resource_map.emplace(handle, resource);
         return handle;
@@ -0,0 +1,134 @@
+#include "culling.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// ZRX_CULLING_NO_SIMD forces the scalar path, which the benchmark checks the vectorized ones against
+#if defined(ZRX_CULLING_NO_SIMD)
+#elif defined(__AVX__)
+#define ZRX_CULLING_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZRX_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+namespace zrx {
+Frustum Frustum::from_matrix(const glm::mat4 &matrix) {
+    const glm::mat4 rows = glm::transpose(matrix);
+
+    Frustum result{
+        .planes = {
+            rows[3] + rows[0],
+            rows[3] - rows[0],
+            rows[3] + rows[1],
+            rows[3] - rows[1],
+            rows[2],
+            rows[3] - rows[2],
+        }
+    };
+
+    for (auto &plane: result.planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    return result;
+}
+
+void BoundingSpheres::push_back(const glm::vec4 &sphere) {
+    if (count % LANE_COUNT == 0) {
+        // no point is at a distance of at least the maximum float from every plane
+        constexpr float padding_radius = std::numeric_limits<float>::lowest();
+
+        center_x.resize(count + LANE_COUNT, 0);
+        center_y.resize(count + LANE_COUNT, 0);
+        center_z.resize(count + LANE_COUNT, 0);
+        radius.resize(count + LANE_COUNT, padding_radius);
+    }
+
+    center_x[count] = sphere.x;
+    center_y[count] = sphere.y;
+    center_z[count] = sphere.z;
+    radius[count]   = sphere.w;
+    count++;
+}
+
+void BoundingSpheres::test(const Frustum &frustum, vector<uint8_t> &visible) const {
+    const size_t padded_count = center_x.size();
+    visible.resize(padded_count);
+
+#if defined(ZRX_CULLING_AVX)
+    __m256 planes[6][4];
+
+    for (size_t p = 0; p < 6; p++) {
+        for (glm::length_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    for (size_t i = 0; i < padded_count; i += 8) {
+        const __m256 x = _mm256_loadu_ps(&center_x[i]);
+        const __m256 y = _mm256_loadu_ps(&center_y[i]);
+        const __m256 z = _mm256_loadu_ps(&center_z[i]);
+        const __m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&radius[i]));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (const auto &[a, b, c, d]: planes) {
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(x, a), _mm256_mul_ps(y, b)),
+                _mm256_add_ps(_mm256_mul_ps(z, c), d)
+            );
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, neg_radius, _CMP_GE_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(inside);
+
+        for (size_t lane = 0; lane < 8; lane++) {
+            visible[i + lane] = (mask >> lane) & 1;
+        }
+    }
+#elif defined(ZRX_CULLING_SSE)
+    __m128 planes[6][4];
+
+    for (size_t p = 0; p < 6; p++) {
+        for (glm::length_t c = 0; c < 4; c++) {
+            planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+        }
+    }
+
+    for (size_t i = 0; i < padded_count; i += 4) {
+        const __m128 x = _mm_loadu_ps(&center_x[i]);
+        const __m128 y = _mm_loadu_ps(&center_y[i]);
+        const __m128 z = _mm_loadu_ps(&center_z[i]);
+        const __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius[i]));
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const auto &[a, b, c, d]: planes) {
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, a), _mm_mul_ps(y, b)),
+                _mm_add_ps(_mm_mul_ps(z, c), d)
+            );
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, neg_radius));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+
+        for (size_t lane = 0; lane < 4; lane++) {
+            visible[i + lane] = (mask >> lane) & 1;
+        }
+    }
+#else
+    for (size_t i = 0; i < padded_count; i++) {
+        const glm::vec3 center{center_x[i], center_y[i], center_z[i]};
+
+        visible[i] = std::ranges::all_of(frustum.planes, [&](const glm::vec4 &plane) {
+            return glm::dot(glm::vec3(plane), center) + plane.w >= -radius[i];
+        });
+    }
+#endif
+}
+} // zrx
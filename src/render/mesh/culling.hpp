@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+
+#include "src/render/libs.hpp"
+#include "src/render/globals.hpp"
+
+namespace zrx {
+/**
+ * View frustum given by six planes, whose normals point inwards and are normalized.
+ */
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    /**
+     * Extracts the planes from a projection matrix with a [0, 1] depth range. If the matrix is premultiplied
+     * by view and model matrices, the planes are in the space of the model instead.
+     */
+    [[nodiscard]] static Frustum from_matrix(const glm::mat4 &matrix);
+};
+
+/**
+ * Bounding spheres stored as a structure of arrays, so that several of them can be tested against a frustum
+ * with a single instruction. The arrays are padded with spheres which are never visible, so that the tests
+ * don't need a scalar tail.
+ */
+class BoundingSpheres {
+    vector<float> center_x;
+    vector<float> center_y;
+    vector<float> center_z;
+    vector<float> radius;
+    size_t count = 0;
+
+public:
+    static constexpr size_t LANE_COUNT = 8;
+
+    void push_back(const glm::vec4 &sphere);
+
+    [[nodiscard]] size_t size() const { return count; }
+
+    /**
+     * Writes whether each sphere intersects the frustum into `visible`, which ends up with at least
+     * `size()` elements. Uses AVX if the build enables it, and SSE otherwise, unless `ZRX_CULLING_NO_SIMD` is defined.
+     */
+    void test(const Frustum &frustum, vector<uint8_t> &visible) const;
+};
+} // zrx
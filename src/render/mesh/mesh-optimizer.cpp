@@ -0,0 +1,291 @@
+#include "mesh-optimizer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace zrx {
+static constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+namespace {
+    /**
+     * FIFO vertex cache, which remembers when each vertex entered it instead of holding the vertices themselves.
+     * A vertex is still cached if fewer than `VERTEX_CACHE_SIZE` vertices entered after it.
+     */
+    class VertexCache {
+        vector<uint32_t> timestamps;
+        uint32_t time = VERTEX_CACHE_SIZE + 1;
+
+    public:
+        explicit VertexCache(const uint32_t vertex_count) : timestamps(vertex_count, 0) {
+        }
+
+        [[nodiscard]] uint32_t get_age(const uint32_t vertex) const { return time - timestamps[vertex]; }
+
+        /**
+         * Returns whether the vertex missed the cache, in which case it's now the most recent one in it.
+         */
+        bool access(const uint32_t vertex) {
+            if (get_age(vertex) <= VERTEX_CACHE_SIZE) return false;
+
+            timestamps[vertex] = time++;
+            return true;
+        }
+
+        void flush() { time += VERTEX_CACHE_SIZE + 1; }
+    };
+}
+
+VertexCacheStats &VertexCacheStats::operator+=(const VertexCacheStats &other) {
+    triangle_count += other.triangle_count;
+    vertex_count += other.vertex_count;
+    miss_count += other.miss_count;
+    return *this;
+}
+
+VertexCacheStats analyze_vertex_cache(const std::span<const uint32_t> indices, const uint32_t vertex_count) {
+    VertexCacheStats stats{.triangle_count = indices.size() / 3};
+
+    VertexCache cache(vertex_count);
+    vector<uint8_t> is_referenced(vertex_count, false);
+
+    for (const auto index: indices) {
+        stats.miss_count += cache.access(index);
+
+        if (!is_referenced[index]) {
+            is_referenced[index] = true;
+            stats.vertex_count++;
+        }
+    }
+
+    return stats;
+}
+
+void optimize_vertex_cache(vector<uint32_t> &indices, const uint32_t vertex_count) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return;
+
+    // triangles adjacent to each vertex, stored contiguously. `live_counts` holds how many of them
+    // are yet to be emitted, which starts out as all of them.
+    vector<uint32_t> live_counts(vertex_count, 0);
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+        live_counts[indices[i]]++;
+    }
+
+    vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+    std::partial_sum(live_counts.begin(), live_counts.end(), adjacency_offsets.begin() + 1);
+
+    vector<uint32_t> adjacency(triangle_count * 3);
+    vector<uint32_t> adjacency_cursors(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+        adjacency[adjacency_cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    VertexCache cache(vertex_count);
+    vector<uint8_t> is_emitted(triangle_count, false);
+    vector<uint32_t> dead_end_stack;
+    vector<uint32_t> candidates;
+    vector<uint32_t> result;
+
+    dead_end_stack.reserve(triangle_count * 3);
+    result.reserve(triangle_count * 3);
+
+    uint32_t next_unvisited = 0;
+
+    const auto get_next_vertex = [&] {
+        // prefers the candidate which stays in the cache after emitting all of its triangles, and was cached
+        // the earliest, so that it's used before it's evicted. candidates which won't fit score lowest.
+        uint32_t best_vertex = NO_VERTEX;
+        int64_t best_priority = -1;
+
+        for (const auto vertex: candidates) {
+            if (live_counts[vertex] == 0) continue;
+
+            int64_t priority = 0;
+            if (cache.get_age(vertex) + 2 * live_counts[vertex] <= VERTEX_CACHE_SIZE) {
+                priority = cache.get_age(vertex);
+            }
+
+            if (priority > best_priority) {
+                best_vertex   = vertex;
+                best_priority = priority;
+            }
+        }
+
+        if (best_vertex != NO_VERTEX) return best_vertex;
+
+        // dead end, so the search continues from the most recently used vertex with triangles left, if any
+        while (!dead_end_stack.empty()) {
+            const uint32_t vertex = dead_end_stack.back();
+            dead_end_stack.pop_back();
+
+            if (live_counts[vertex] > 0) return vertex;
+        }
+
+        while (next_unvisited < vertex_count) {
+            if (live_counts[next_unvisited] > 0) return next_unvisited;
+            next_unvisited++;
+        }
+
+        return NO_VERTEX;
+    };
+
+    for (uint32_t fan_vertex = indices[0]; fan_vertex != NO_VERTEX; fan_vertex = get_next_vertex()) {
+        candidates.clear();
+
+        // emits every remaining triangle around the vertex
+        for (uint32_t i = adjacency_offsets[fan_vertex]; i < adjacency_offsets[fan_vertex + 1]; i++) {
+            const uint32_t triangle = adjacency[i];
+            if (is_emitted[triangle]) continue;
+
+            for (uint32_t j = 0; j < 3; j++) {
+                const uint32_t vertex = indices[triangle * 3 + j];
+
+                result.push_back(vertex);
+                dead_end_stack.push_back(vertex);
+                candidates.push_back(vertex);
+                live_counts[vertex]--;
+                cache.access(vertex);
+            }
+
+            is_emitted[triangle] = true;
+        }
+    }
+
+    indices = std::move(result);
+}
+
+void optimize_overdraw(vector<uint32_t> &indices, const std::span<const ModelVertex> vertices, const float threshold) {
+    const size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2) return;
+
+    vector<uint8_t> triangle_misses(triangle_count);
+    VertexCache cache(static_cast<uint32_t>(vertices.size()));
+
+    for (size_t triangle = 0; triangle < triangle_count; triangle++) {
+        for (uint32_t j = 0; j < 3; j++) {
+            triangle_misses[triangle] += cache.access(indices[triangle * 3 + j]);
+        }
+    }
+
+    // triangles missing the cache with all of their vertices start new strips of the cache-optimized order,
+    // so reordering whole strips doesn't affect the cache much. these are split further where the miss ratio
+    // of the cluster so far, drawn starting with an empty cache, is close enough to that of the whole strip.
+    vector<uint32_t> hard_boundaries;
+
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++) {
+        if (triangle == 0 || triangle_misses[triangle] == 3) {
+            hard_boundaries.push_back(triangle);
+        }
+    }
+
+    hard_boundaries.push_back(static_cast<uint32_t>(triangle_count));
+
+    vector<uint32_t> cluster_boundaries;
+
+    for (size_t i = 0; i + 1 < hard_boundaries.size(); i++) {
+        const uint32_t begin = hard_boundaries[i];
+        const uint32_t end   = hard_boundaries[i + 1];
+
+        uint32_t strip_misses = 0;
+        for (uint32_t triangle = begin; triangle < end; triangle++) {
+            strip_misses += triangle_misses[triangle];
+        }
+
+        const float max_cluster_acmr = threshold * static_cast<float>(strip_misses) / static_cast<float>(end - begin);
+
+        uint32_t cluster_begin  = begin;
+        uint32_t cluster_misses = 0;
+
+        cluster_boundaries.push_back(begin);
+        cache.flush();
+
+        for (uint32_t triangle = begin; triangle + 1 < end; triangle++) {
+            for (uint32_t j = 0; j < 3; j++) {
+                cluster_misses += cache.access(indices[triangle * 3 + j]);
+            }
+
+            const auto cluster_size = static_cast<float>(triangle + 1 - cluster_begin);
+
+            if (static_cast<float>(cluster_misses) <= max_cluster_acmr * cluster_size) {
+                cluster_begin  = triangle + 1;
+                cluster_misses = 0;
+                cluster_boundaries.push_back(cluster_begin);
+                cache.flush();
+            }
+        }
+    }
+
+    cluster_boundaries.push_back(static_cast<uint32_t>(triangle_count));
+
+    const size_t cluster_count = cluster_boundaries.size() - 1;
+
+    // each triangle's normal is as long as twice its area, so the sums of normals are weighted by area
+    vector<glm::vec3> cluster_centroids(cluster_count, glm::vec3(0));
+    vector<glm::vec3> cluster_normals(cluster_count, glm::vec3(0));
+    glm::vec3 mesh_centroid(0);
+
+    for (size_t cluster = 0; cluster < cluster_count; cluster++) {
+        for (uint32_t triangle = cluster_boundaries[cluster]; triangle < cluster_boundaries[cluster + 1]; triangle++) {
+            const glm::vec3 &p0 = vertices[indices[triangle * 3]].pos;
+            const glm::vec3 &p1 = vertices[indices[triangle * 3 + 1]].pos;
+            const glm::vec3 &p2 = vertices[indices[triangle * 3 + 2]].pos;
+
+            cluster_centroids[cluster] += (p0 + p1 + p2) / 3.0f;
+            cluster_normals[cluster] += glm::cross(p1 - p0, p2 - p0);
+        }
+
+        mesh_centroid += cluster_centroids[cluster];
+        cluster_centroids[cluster] /= static_cast<float>(cluster_boundaries[cluster + 1] - cluster_boundaries[cluster]);
+    }
+
+    mesh_centroid /= static_cast<float>(triangle_count);
+
+    // clusters facing away from the center are likely to occlude the rest from any point of view
+    vector<float> occlusion_potentials(cluster_count);
+
+    for (size_t cluster = 0; cluster < cluster_count; cluster++) {
+        const float normal_length = glm::length(cluster_normals[cluster]);
+
+        occlusion_potentials[cluster] = normal_length > 0
+                                            ? glm::dot(cluster_centroids[cluster] - mesh_centroid,
+                                                       cluster_normals[cluster] / normal_length)
+                                            : 0;
+    }
+
+    vector<uint32_t> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), 0);
+
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&](const uint32_t a, const uint32_t b) {
+        return occlusion_potentials[a] > occlusion_potentials[b];
+    });
+
+    vector<uint32_t> result;
+    result.reserve(triangle_count * 3);
+
+    for (const auto cluster: cluster_order) {
+        result.insert(result.end(), indices.begin() + cluster_boundaries[cluster] * 3,
+                      indices.begin() + cluster_boundaries[cluster + 1] * 3);
+    }
+
+    indices = std::move(result);
+}
+
+void optimize_vertex_fetch(vector<ModelVertex> &vertices, vector<uint32_t> &indices) {
+    vector<uint32_t> remapped_indices(vertices.size(), NO_VERTEX);
+    vector<ModelVertex> result;
+    result.reserve(vertices.size());
+
+    for (auto &index: indices) {
+        if (remapped_indices[index] == NO_VERTEX) {
+            remapped_indices[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+        }
+
+        index = remapped_indices[index];
+    }
+
+    vertices = std::move(result);
+}
+} // zrx
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <span>
+
+#include "vertex.hpp"
+#include "src/render/libs.hpp"
+#include "src/render/globals.hpp"
+
+namespace zrx {
+/**
+ * Size of the post-transform vertex cache assumed by the optimizations below. It's modelled as a FIFO,
+ * which is close enough to how actual hardware reuses transformed vertices.
+ */
+static constexpr uint32_t VERTEX_CACHE_SIZE = 16;
+
+/**
+ * Cache misses of a simulated vertex cache while drawing a triangle list. These add up over several meshes.
+ */
+struct VertexCacheStats {
+    uint64_t triangle_count = 0;
+    uint64_t vertex_count = 0; // vertices referenced by the indices
+    uint64_t miss_count = 0;
+
+    /**
+     * Average cache miss ratio, i.e. vertices transformed per triangle. It's 3 at worst and approaches 0.5
+     * for large regular meshes.
+     */
+    [[nodiscard]] float get_acmr() const {
+        return triangle_count ? static_cast<float>(miss_count) / static_cast<float>(triangle_count) : 0;
+    }
+
+    /**
+     * Average transform to vertex ratio, i.e. how many times each vertex is transformed. It's 1 at best.
+     */
+    [[nodiscard]] float get_atvr() const {
+        return vertex_count ? static_cast<float>(miss_count) / static_cast<float>(vertex_count) : 0;
+    }
+
+    VertexCacheStats &operator+=(const VertexCacheStats &other);
+};
+
+[[nodiscard]] VertexCacheStats analyze_vertex_cache(std::span<const uint32_t> indices, uint32_t vertex_count);
+
+/**
+ * Reorders the triangles for vertex cache reuse, using Tipsify (Sander et al., "Fast triangle reordering for
+ * vertex locality and reduced overdraw"). It runs in time linear in the number of triangles.
+ */
+void optimize_vertex_cache(vector<uint32_t> &indices, uint32_t vertex_count);
+
+/**
+ * Splits triangles already ordered for the vertex cache into clusters, which are then sorted so that those
+ * facing away from the mesh's center, and thus likely occluding the others, are drawn first. Clusters only
+ * end where the cache reuse doesn't suffer much from it, i.e. where the ACMR of the cluster so far is within
+ * `threshold` times that of the whole mesh.
+ */
+void optimize_overdraw(vector<uint32_t> &indices, std::span<const ModelVertex> vertices, float threshold);
+
+/**
+ * Renumbers the vertices in the order in which the indices first reference them, so that vertex fetches
+ * move through memory linearly. Vertices which aren't referenced at all are dropped.
+ */
+void optimize_vertex_fetch(vector<ModelVertex> &vertices, vector<uint32_t> &indices);
+} // zrx
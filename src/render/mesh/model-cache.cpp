@@ -0,0 +1,356 @@
+#include "model-cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+#include "src/utils/hash.hpp"
+#include "src/utils/logger.hpp"
+
+namespace zrx {
+static constexpr std::uint32_t CACHE_FILE_MAGIC = 0x48534d5a; // "ZMSH"
+static constexpr std::uint32_t CACHE_FILE_VERSION = 5;
+
+// sections start at offsets aligned to this, so that the arrays in a mapped file are aligned for any of their types
+static constexpr std::uint64_t SECTION_ALIGNMENT = 64;
+
+namespace {
+    struct Section {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0; // in bytes
+    };
+
+    /**
+     * Size and modification time of a file, which are compared before its contents are, as reading a whole
+     * model file takes longer than loading its cache.
+     */
+    struct FileStamp {
+        std::uint64_t size = 0;
+        std::int64_t write_time = 0; // in the file clock's ticks
+
+        bool operator==(const FileStamp &) const = default;
+    };
+
+    struct CacheHeader {
+        std::uint32_t magic = 0;
+        std::uint32_t version = 0;
+        std::uint64_t key = 0;
+        std::uint64_t file_size = 0;
+
+        Section meshes{};
+        Section vertices{};
+        Section indices{};
+        Section instance_transforms{};
+        Section mesh_descriptions{};
+        Section meshlets{};
+        Section meshlet_vertices{};
+        Section meshlet_triangles{};
+        Section materials{};
+        Section dependencies{};
+    };
+
+    class CacheWriter {
+        std::ofstream file;
+        std::uint64_t offset = 0;
+
+    public:
+        explicit CacheWriter(const std::filesystem::path &path) : file(path, std::ios::binary | std::ios::trunc) {
+        }
+
+        [[nodiscard]] bool good() const { return file.good(); }
+
+        [[nodiscard]] std::uint64_t get_offset() const { return offset; }
+
+        void write_bytes(const void *data, const size_t size) {
+            file.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+            offset += size;
+        }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        void write(const T &value) {
+            write_bytes(&value, sizeof(T));
+        }
+
+        void write(const std::filesystem::path &path) {
+            const auto str = path.u8string();
+
+            write(static_cast<std::uint32_t>(str.size()));
+            write_bytes(str.data(), str.size());
+        }
+
+        void align() {
+            constexpr char zeros[SECTION_ALIGNMENT]{};
+            write_bytes(zeros, (SECTION_ALIGNMENT - offset % SECTION_ALIGNMENT) % SECTION_ALIGNMENT);
+        }
+
+        template<typename T>
+        Section write_section(const std::span<const T> elements) {
+            align();
+
+            const Section section{.offset = offset, .size = elements.size_bytes()};
+            write_bytes(elements.data(), elements.size_bytes());
+
+            return section;
+        }
+
+        void rewind() {
+            file.seekp(0);
+            offset = 0;
+        }
+    };
+
+    /**
+     * Reads values out of a section of the mapped file, failing instead of reading past its end.
+     */
+    class SectionReader {
+        std::span<const std::byte> bytes;
+        bool failed = false;
+
+    public:
+        explicit SectionReader(const std::span<const std::byte> bytes) : bytes(bytes) {
+        }
+
+        [[nodiscard]] bool good() const { return !failed; }
+
+        [[nodiscard]] bool at_end() const { return bytes.empty(); }
+
+        template<typename T>
+            requires std::is_trivially_copyable_v<T>
+        void read(T &value) {
+            if (failed || bytes.size() < sizeof(T)) {
+                failed = true;
+                return;
+            }
+
+            std::memcpy(&value, bytes.data(), sizeof(T));
+            bytes = bytes.subspan(sizeof(T));
+        }
+
+        void read(std::filesystem::path &path) {
+            std::uint32_t size = 0;
+            read(size);
+
+            if (failed || bytes.size() < size) {
+                failed = true;
+                return;
+            }
+
+            const auto chars = reinterpret_cast<const char8_t *>(bytes.data());
+            path  = std::u8string(chars, chars + size);
+            bytes = bytes.subspan(size);
+        }
+    };
+} // namespace
+
+static std::optional<FileStamp> get_file_stamp(const std::filesystem::path &path) {
+    std::error_code error;
+    const auto size       = std::filesystem::file_size(path, error);
+    if (error) return {};
+    const auto write_time = std::filesystem::last_write_time(path, error);
+    if (error) return {};
+
+    return FileStamp{.size = size, .write_time = write_time.time_since_epoch().count()};
+}
+
+static std::uint64_t hash_file_contents(const std::filesystem::path &path) {
+    return Hasher().add_file_contents(path).get();
+}
+
+/**
+ * Returns the elements of a section of the mapped file, or nothing if the section doesn't lie within the file
+ * or isn't an array of `T`.
+ */
+template<typename T>
+static std::optional<std::span<const T> > get_section_elements(const MappedFile &file, const Section &section) {
+    if (section.offset % SECTION_ALIGNMENT != 0 || section.size % sizeof(T) != 0
+        || section.offset > file.get_size() || section.size > file.get_size() - section.offset) {
+        return {};
+    }
+
+    const auto elements = reinterpret_cast<const T *>(file.get_data() + section.offset);
+    return std::span(elements, section.size / sizeof(T));
+}
+
+std::optional<ModelCache> ModelCache::load(const std::filesystem::path &path, const std::uint64_t key) {
+    auto file = MappedFile::open(path);
+    if (!file) return {};
+
+    CacheHeader header{};
+    if (file->get_size() < sizeof(CacheHeader)) {
+        Logger::warning("ignoring unreadable model cache: ", path.string());
+        return {};
+    }
+
+    std::memcpy(&header, file->get_data(), sizeof(CacheHeader));
+
+    if (header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION || header.key != key) {
+        return {};
+    }
+
+    ModelCache cache(std::move(*file));
+
+    const auto meshes              = get_section_elements<CachedMesh>(cache.file, header.meshes);
+    const auto vertices            = get_section_elements<ModelVertex>(cache.file, header.vertices);
+    const auto indices             = get_section_elements<uint32_t>(cache.file, header.indices);
+    const auto instance_transforms = get_section_elements<glm::mat4>(cache.file, header.instance_transforms);
+    const auto mesh_descriptions   = get_section_elements<MeshDescription>(cache.file, header.mesh_descriptions);
+    const auto meshlets            = get_section_elements<MeshletDescription>(cache.file, header.meshlets);
+    const auto meshlet_vertices    = get_section_elements<uint32_t>(cache.file, header.meshlet_vertices);
+    const auto meshlet_triangles   = get_section_elements<uint32_t>(cache.file, header.meshlet_triangles);
+    const auto materials           = get_section_elements<std::byte>(cache.file, header.materials);
+    const auto dependencies        = get_section_elements<std::byte>(cache.file, header.dependencies);
+
+    if (header.file_size != cache.file.get_size() || !meshes || !vertices || !indices || !instance_transforms
+        || !mesh_descriptions || !meshlets || !meshlet_vertices || !meshlet_triangles || !materials
+        || !dependencies) {
+        Logger::warning("ignoring unreadable model cache: ", path.string());
+        return {};
+    }
+
+    // the meshes are drawn from the arrays by their counts, so these have to agree with each other
+    size_t vertex_count   = 0;
+    size_t index_count    = 0;
+    size_t instance_count = 0;
+
+    for (const auto &mesh: *meshes) {
+        vertex_count += mesh.vertex_count;
+        index_count += mesh.index_count;
+        instance_count += mesh.instance_count;
+    }
+
+    // as do the meshlet ranges of the meshes, which the meshlet culling shaders read without any bounds checks
+    const bool are_meshlet_ranges_valid = std::ranges::all_of(*mesh_descriptions, [&](const auto &description) {
+        return description.first_meshlet <= meshlets->size()
+               && description.meshlet_count <= meshlets->size() - description.first_meshlet;
+    });
+
+    // and so do the meshlets' vertex ranges and triangles, which the mesh shaders read in the same way
+    const bool are_meshlet_vertex_ranges_valid = std::ranges::all_of(*meshlets, [&](const auto &meshlet) {
+        return meshlet.first_vertex <= meshlet_vertices->size()
+               && meshlet.vertex_count <= meshlet_vertices->size() - meshlet.first_vertex;
+    });
+
+    if (vertex_count != vertices->size() || index_count != indices->size()
+        || instance_count != instance_transforms->size() || meshes->size() != mesh_descriptions->size()
+        || !are_meshlet_ranges_valid || !are_meshlet_vertex_ranges_valid
+        || meshlet_triangles->size() != (index_count + 3) / 4) {
+        Logger::warning("ignoring unreadable model cache: ", path.string());
+        return {};
+    }
+
+    cache.meshes   = *meshes;
+    cache.geometry = ModelGeometry{
+        .vertices = *vertices,
+        .indices = *indices,
+        .instance_transforms = *instance_transforms,
+        .mesh_descriptions = *mesh_descriptions,
+        .meshlets = *meshlets,
+        .meshlet_vertices = *meshlet_vertices,
+        .meshlet_triangles = *meshlet_triangles,
+    };
+
+    SectionReader reader(*materials);
+
+    while (reader.good() && !reader.at_end()) {
+        auto &material = cache.materials.emplace_back();
+
+        reader.read(material.base_color);
+        reader.read(material.normal);
+        reader.read(material.ao);
+        reader.read(material.roughness);
+        reader.read(material.metallic);
+    }
+
+    if (!reader.good()) {
+        Logger::warning("ignoring unreadable model cache: ", path.string());
+        return {};
+    }
+
+    SectionReader dependency_reader(*dependencies);
+
+    while (dependency_reader.good() && !dependency_reader.at_end()) {
+        std::filesystem::path dependency;
+        FileStamp stamp{};
+        std::uint64_t hash = 0;
+
+        dependency_reader.read(dependency);
+        dependency_reader.read(stamp);
+        dependency_reader.read(hash);
+
+        if (!dependency_reader.good()) {
+            Logger::warning("ignoring unreadable model cache: ", path.string());
+            return {};
+        }
+
+        const auto current_stamp = get_file_stamp(dependency);
+        if (!current_stamp || current_stamp->size != stamp.size) return {};
+
+        // a file which was only touched, e.g. by a checkout, still has the same contents
+        if (*current_stamp != stamp && hash_file_contents(dependency) != hash) return {};
+    }
+
+    return cache;
+}
+
+void ModelCache::save(const std::filesystem::path &path, const std::uint64_t key,
+                      const std::span<const CachedMesh> meshes, const ModelGeometry &geometry,
+                      const vector<MaterialPaths> &materials, const vector<std::filesystem::path> &dependencies) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    CacheWriter writer(path);
+
+    // the header is written last, once the sections' offsets are known
+    CacheHeader header{
+        .magic = CACHE_FILE_MAGIC,
+        .version = CACHE_FILE_VERSION,
+        .key = key,
+    };
+
+    writer.write(CacheHeader{});
+
+    header.meshes              = writer.write_section(meshes);
+    header.vertices            = writer.write_section(geometry.vertices);
+    header.indices             = writer.write_section(geometry.indices);
+    header.instance_transforms = writer.write_section(geometry.instance_transforms);
+    header.mesh_descriptions   = writer.write_section(geometry.mesh_descriptions);
+    header.meshlets            = writer.write_section(geometry.meshlets);
+    header.meshlet_vertices    = writer.write_section(geometry.meshlet_vertices);
+    header.meshlet_triangles   = writer.write_section(geometry.meshlet_triangles);
+
+    writer.align();
+    header.materials.offset = writer.get_offset();
+
+    for (const auto &material: materials) {
+        writer.write(material.base_color);
+        writer.write(material.normal);
+        writer.write(material.ao);
+        writer.write(material.roughness);
+        writer.write(material.metallic);
+    }
+
+    header.materials.size = writer.get_offset() - header.materials.offset;
+
+    writer.align();
+    header.dependencies.offset = writer.get_offset();
+
+    for (const auto &dependency: dependencies) {
+        writer.write(dependency);
+        writer.write(get_file_stamp(dependency).value_or(FileStamp{}));
+        writer.write(hash_file_contents(dependency));
+    }
+
+    header.dependencies.size = writer.get_offset() - header.dependencies.offset;
+    header.file_size      = writer.get_offset();
+
+    writer.rewind();
+    writer.write(header);
+
+    if (!writer.good()) {
+        Logger::warning("failed to save the model cache: ", path.string());
+    }
+}
+} // zrx
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "model.hpp"
+#include "src/utils/mapped-file.hpp"
+
+namespace zrx {
+/**
+ * Paths of the textures making up a material, which are empty for the textures it doesn't have.
+ */
+struct MaterialPaths {
+    std::filesystem::path base_color;
+    std::filesystem::path normal;
+    std::filesystem::path ao;
+    std::filesystem::path roughness;
+    std::filesystem::path metallic;
+};
+
+/**
+ * Everything about a mesh needed to draw and cull it, apart from its geometry and its instances.
+ */
+struct CachedMesh {
+    MeshAabb aabb;
+    glm::vec4 bounding_sphere;
+    uint32_t material_id;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t instance_count;
+};
+
+/**
+ * Geometry of an imported model, stored exactly as it's uploaded into the model's buffers, along with the meshes'
+ * bounds and the model's materials. The file is mapped into memory, so that a model which didn't change since
+ * it was last imported is uploaded straight from it, without running the importer again.
+ */
+class ModelCache {
+    MappedFile file;
+    std::span<const CachedMesh> meshes;
+    ModelGeometry geometry;
+    vector<MaterialPaths> materials;
+
+    explicit ModelCache(MappedFile &&file) : file(std::move(file)) {
+    }
+
+public:
+    /**
+     * Maps the cache at `path`, or returns nothing if it doesn't exist, is malformed or was written for a different
+     * `key`, i.e. a hash of the settings the model was imported with. It's also stale if any of the files read by
+     * the importer, i.e. the source model and the files it references, like external buffers or material libraries,
+     * changed since. Only files whose size matches but whose modification time doesn't are read to find out.
+     */
+    [[nodiscard]] static std::optional<ModelCache> load(const std::filesystem::path &path, std::uint64_t key);
+
+    /**
+     * Writes the cache of a model imported from `dependencies`, i.e. every file the importer read. Their sizes,
+     * modification times and content hashes are stored, so that changes to them invalidate the cache.
+     */
+    static void save(const std::filesystem::path &path, std::uint64_t key, std::span<const CachedMesh> meshes,
+                     const ModelGeometry &geometry, const vector<MaterialPaths> &materials,
+                     const vector<std::filesystem::path> &dependencies);
+
+    // both of these point into the mapped file, so they're only valid as long as the cache
+
+    [[nodiscard]] std::span<const CachedMesh> get_meshes() const { return meshes; }
+
+    [[nodiscard]] const ModelGeometry &get_geometry() const { return geometry; }
+
+    [[nodiscard]] const vector<MaterialPaths> &get_materials() const { return materials; }
+};
+} // zrx
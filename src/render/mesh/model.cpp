@@ -1,14 +1,29 @@
 #include "model.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/version.h>
 
 #include "vertex.hpp"
+#include "model-cache.hpp"
 #include "src/render/renderer.hpp"
 #include "src/render/vk/image.hpp"
 #include "src/render/vk/buffer.hpp"
+#include "src/render/vk/cmd.hpp"
+#include "src/utils/hash.hpp"
+#include "src/utils/thread-pool.hpp"
 
 namespace zrx {
 static glm::vec3 assimp_vec_to_glm(const aiVector3D &v) {
@@ -41,112 +56,399 @@ static glm::mat4 assimp_matrix_to_glm(const aiMatrix4x4 &m) {
     return res;
 }
 
-Mesh::Mesh(const aiMesh *assimp_mesh) : material_id(assimp_mesh->mMaterialIndex) {
-    std::unordered_map<ModelVertex, uint32_t> unique_vertices;
+static ModelVertex get_assimp_vertex(const aiMesh *assimp_mesh, const uint32_t index) {
+    ModelVertex vertex{};
 
-    for (size_t faceIdx = 0; faceIdx < assimp_mesh->mNumFaces; faceIdx++) {
-        const auto &face = assimp_mesh->mFaces[faceIdx];
+    if (assimp_mesh->HasPositions()) {
+        vertex.pos = assimp_vec_to_glm(assimp_mesh->mVertices[index]);
+    }
 
-        for (size_t i = 0; i < face.mNumIndices; i++) {
-            ModelVertex vertex{};
+    if (assimp_mesh->HasTextureCoords(0)) {
+        vertex.tex_coord = {
+            assimp_mesh->mTextureCoords[0][index].x,
+            1.0f - assimp_mesh->mTextureCoords[0][index].y
+        };
+    }
 
-            if (assimp_mesh->HasPositions()) {
-                vertex.pos = assimp_vec_to_glm(assimp_mesh->mVertices[face.mIndices[i]]);
-            }
+    if (assimp_mesh->HasNormals()) {
+        vertex.normal = assimp_vec_to_glm(assimp_mesh->mNormals[index]);
+    }
 
-            if (assimp_mesh->HasTextureCoords(0)) {
-                vertex.tex_coord = {
-                    assimp_mesh->mTextureCoords[0][face.mIndices[i]].x,
-                    1.0f - assimp_mesh->mTextureCoords[0][face.mIndices[i]].y
-                };
-            }
+    if (assimp_mesh->HasTangentsAndBitangents()) {
+        vertex.tangent   = assimp_vec_to_glm(assimp_mesh->mTangents[index]);
+        vertex.bitangent = assimp_vec_to_glm(assimp_mesh->mBitangents[index]);
+    }
 
-            if (assimp_mesh->HasTangentsAndBitangents()) {
-                vertex.normal = assimp_vec_to_glm(assimp_mesh->mNormals[face.mIndices[i]]);
-            }
+    return vertex;
+}
+
+namespace {
+    /**
+     * Open addressing hash set of vertices, which finds the index of a vertex with the same bytes as
+     * the given one, appending it to the vertex list if there's none. Each vertex is looked up only once.
+     */
+    class VertexWelder {
+        static constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+        vector<ModelVertex> &vertices;
+        vector<uint32_t> slots; // indices of the vertices, or `EMPTY_SLOT`
+        size_t slot_mask;
+
+    public:
+        VertexWelder(vector<ModelVertex> &vertices, const size_t max_vertex_count) : vertices(vertices) {
+            // the table is kept at most half full, so that probe sequences stay short
+            const size_t slot_count = std::bit_ceil(std::max<size_t>(16, max_vertex_count * 2));
+
+            slots.assign(slot_count, EMPTY_SLOT);
+            slot_mask = slot_count - 1;
+        }
+
+        uint32_t weld(const ModelVertex &vertex) {
+            for (size_t slot = hash(vertex) & slot_mask;; slot = (slot + 1) & slot_mask) {
+                const uint32_t index = slots[slot];
 
-            if (assimp_mesh->HasTangentsAndBitangents()) {
-                vertex.tangent   = assimp_vec_to_glm(assimp_mesh->mTangents[face.mIndices[i]]);
-                vertex.bitangent = assimp_vec_to_glm(assimp_mesh->mBitangents[face.mIndices[i]]);
+                if (index == EMPTY_SLOT) {
+                    slots[slot] = static_cast<uint32_t>(vertices.size());
+                    vertices.push_back(vertex);
+                    return slots[slot];
+                }
+
+                if (std::memcmp(&vertices[index], &vertex, sizeof(ModelVertex)) == 0) {
+                    return index;
+                }
             }
+        }
+
+    private:
+        static std::uint64_t hash(const ModelVertex &vertex) {
+            static_assert(sizeof(ModelVertex) % sizeof(std::uint64_t) == 0 && sizeof(ModelVertex) == 14 * sizeof(float),
+                          "vertices are hashed by their bytes, so they mustn't contain any padding");
+
+            std::uint64_t words[sizeof(ModelVertex) / sizeof(std::uint64_t)];
+            std::memcpy(words, &vertex, sizeof(ModelVertex));
+
+            // every word is mixed into the state, which is then finalized like in murmur3
+            std::uint64_t value = 0x9e3779b97f4a7c15ULL;
 
-            if (!unique_vertices.contains(vertex)) {
-                unique_vertices[vertex] = vertices.size();
-                vertices.push_back(vertex);
+            for (const auto word: words) {
+                value = std::rotl(value ^ (word * 0x87c37b91114253d5ULL), 31) * 0x4cf5ad432745937fULL;
             }
 
-            indices.push_back(unique_vertices.at(vertex));
+            value ^= value >> 33;
+            value *= 0xff51afd7ed558ccdULL;
+            value ^= value >> 33;
+            value *= 0xc4ceb9fe1a85ec53ULL;
+            value ^= value >> 33;
+
+            return value;
         }
+    };
+}
+
+Mesh::Mesh(const aiMesh *assimp_mesh, const bool is_welded) : material_id(assimp_mesh->mMaterialIndex) {
+    if (is_welded) {
+        load_indexed(assimp_mesh);
+    } else {
+        load_welded(assimp_mesh);
     }
+
+    optimize();
+
+    vertex_count = static_cast<uint32_t>(vertices.size());
+    index_count  = static_cast<uint32_t>(indices.size());
+
+    compute_bounds();
+    build_meshlets();
+
+    meshlet_count = static_cast<uint32_t>(meshlets.size());
 }
 
-Material::Material(const RendererContext &ctx, const aiMaterial *assimp_material,
-                   const std::filesystem::path &base_path) {
-    // base color
+void Mesh::load_indexed(const aiMesh *assimp_mesh) {
+    vertices.reserve(assimp_mesh->mNumVertices);
+
+    for (uint32_t i = 0; i < assimp_mesh->mNumVertices; i++) {
+        vertices.push_back(get_assimp_vertex(assimp_mesh, i));
+    }
+
+    indices.reserve(assimp_mesh->mNumFaces * 3);
+
+    for (uint32_t face_idx = 0; face_idx < assimp_mesh->mNumFaces; face_idx++) {
+        const auto &face = assimp_mesh->mFaces[face_idx];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+    }
+}
+
+void Mesh::load_welded(const aiMesh *assimp_mesh) {
+    indices.reserve(assimp_mesh->mNumFaces * 3);
+
+    VertexWelder welder(vertices, assimp_mesh->mNumFaces * 3);
+
+    for (uint32_t face_idx = 0; face_idx < assimp_mesh->mNumFaces; face_idx++) {
+        const auto &face = assimp_mesh->mFaces[face_idx];
+
+        for (uint32_t i = 0; i < face.mNumIndices; i++) {
+            indices.push_back(welder.weld(get_assimp_vertex(assimp_mesh, face.mIndices[i])));
+        }
+    }
+}
 
-    aiString base_color_rel_path;
-    aiReturn result = assimp_material->GetTexture(aiTextureType_BASE_COLOR, 0, &base_color_rel_path);
-
-    if (result == aiReturn_SUCCESS) {
-        auto path = base_path;
-        path /= base_color_rel_path.C_Str();
-        path.make_preferred();
-
-        try {
-            base_color = TextureBuilder()
-                    .with_flags(vk::TextureFlagBitsZRX::MIPMAPS)
-                    .from_paths({path})
-                    .create(ctx);
-        } catch (std::exception &e) {
-            std::cerr << "failed to allocate buffer for texture: " << path << std::endl;
-            base_color = nullptr;
+void Mesh::optimize() {
+    // clusters are only split where it raises their miss ratio by at most this much
+    constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+    const auto vertex_count = static_cast<uint32_t>(vertices.size());
+
+    imported_cache_stats  = analyze_vertex_cache(indices, vertex_count);
+    optimized_cache_stats = imported_cache_stats;
+
+    auto cache_indices = indices;
+    optimize_vertex_cache(cache_indices, vertex_count);
+    const auto cache_stats = analyze_vertex_cache(cache_indices, vertex_count);
+
+    // the imported order is kept if it's at least as good, e.g. when the importer already optimized it.
+    // the overdraw order is built from the cache order, so it's only worth computing if the latter is kept.
+    if (cache_stats.get_acmr() < imported_cache_stats.get_acmr()) {
+        auto overdraw_indices = cache_indices;
+        optimize_overdraw(overdraw_indices, vertices, OVERDRAW_THRESHOLD);
+        const auto overdraw_stats = analyze_vertex_cache(overdraw_indices, vertex_count);
+
+        // it gives up some of the cache reuse, which mustn't drop it below that of the imported order
+        if (overdraw_stats.get_acmr() < imported_cache_stats.get_acmr()) {
+            indices = std::move(overdraw_indices);
+            optimized_cache_stats = overdraw_stats;
+        } else {
+            indices = std::move(cache_indices);
+            optimized_cache_stats = cache_stats;
         }
     }
 
-    // normal map
+    // renumbering the vertices doesn't change which of them hit the cache
+    optimize_vertex_fetch(vertices, indices);
+}
 
-    aiString normal_rel_path;
-    if (assimp_material->GetTexture(aiTextureType_NORMALS, 0, &normal_rel_path) != aiReturn_SUCCESS) {
-        result = assimp_material->GetTexture(aiTextureType_NORMAL_CAMERA, 0, &normal_rel_path);
+void Mesh::compute_bounds() {
+    if (vertices.empty()) return;
+
+    aabb_min = glm::vec3(std::numeric_limits<float>::max());
+    aabb_max = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (const auto &vertex: vertices) {
+        aabb_min = glm::min(aabb_min, vertex.pos);
+        aabb_max = glm::max(aabb_max, vertex.pos);
     }
 
-    if (result == aiReturn_SUCCESS) {
-        auto path = base_path;
-        path /= normal_rel_path.C_Str();
-        path.make_preferred();
+    const glm::vec3 center = (aabb_min + aabb_max) / 2.0f;
+    float radius = 0;
 
-        normal = TextureBuilder()
-                .use_format(vk::Format::eR8G8B8A8Unorm)
-                .from_paths({path})
-                .with_flags(vk::TextureFlagBitsZRX::MIPMAPS)
-                .create(ctx);
+    for (const auto &vertex: vertices) {
+        radius = std::max(radius, glm::distance(center, vertex.pos));
     }
 
-    // orm
+    bounding_sphere = glm::vec4(center, radius);
+}
+
+void Mesh::build_meshlets() {
+    // the meshlet which last used each vertex, so that vertices shared by its triangles are counted once
+    vector<uint32_t> vertex_meshlets(vertices.size(), std::numeric_limits<uint32_t>::max());
+
+    uint32_t first_index    = 0;
+    uint32_t triangle_count = 0;
+    uint32_t vertex_count   = 0;
+
+    meshlet_triangles.reserve(indices.size());
+
+    const auto push_meshlet = [&] {
+        auto &meshlet = meshlets.emplace_back(create_meshlet(first_index, triangle_count));
+        meshlet.first_vertex = static_cast<uint32_t>(meshlet_vertices.size());
+
+        // the meshlet's vertices are listed in the order its triangles first use them
+        for (uint32_t i = first_index; i < first_index + triangle_count * 3; i++) {
+            const auto meshlet_begin = meshlet_vertices.begin() + meshlet.first_vertex;
+            const auto it = std::find(meshlet_begin, meshlet_vertices.end(), indices[i]);
+
+            meshlet_triangles.push_back(static_cast<uint8_t>(it - meshlet_begin));
+            if (it == meshlet_vertices.end()) meshlet_vertices.push_back(indices[i]);
+        }
+
+        meshlet.vertex_count = static_cast<uint32_t>(meshlet_vertices.size()) - meshlet.first_vertex;
+    };
+
+    const auto count_new_vertices = [&](const uint32_t index) {
+        const auto current = static_cast<uint32_t>(meshlets.size());
+        uint32_t count = 0;
+
+        for (uint32_t i = index; i < index + 3; i++) {
+            const bool is_repeated = (i > index && indices[i] == indices[i - 1])
+                                     || (i == index + 2 && indices[i] == indices[index]);
+            if (vertex_meshlets[indices[i]] != current && !is_repeated) count++;
+        }
+
+        return count;
+    };
+
+    // triangles are taken in order, which keeps them spatially coherent after the vertex cache optimization
+    for (uint32_t index = 0; index + 2 < indices.size(); index += 3) {
+        if (triangle_count == Meshlet::MAX_TRIANGLES
+            || vertex_count + count_new_vertices(index) > Meshlet::MAX_VERTICES) {
+            push_meshlet();
+
+            first_index    = index;
+            triangle_count = 0;
+            vertex_count   = 0;
+        }
+
+        vertex_count += count_new_vertices(index);
+        triangle_count++;
+
+        for (uint32_t i = index; i < index + 3; i++) {
+            vertex_meshlets[indices[i]] = static_cast<uint32_t>(meshlets.size());
+        }
+    }
+
+    if (triangle_count > 0) {
+        push_meshlet();
+    }
+}
+
+Meshlet Mesh::create_meshlet(const uint32_t first_index, const uint32_t triangle_count) const {
+    const uint32_t end_index = first_index + triangle_count * 3;
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+
+    for (uint32_t i = first_index; i < end_index; i++) {
+        min = glm::min(min, vertices[indices[i]].pos);
+        max = glm::max(max, vertices[indices[i]].pos);
+    }
+
+    const glm::vec3 center = (min + max) / 2.0f;
+    float radius = 0;
+
+    for (uint32_t i = first_index; i < end_index; i++) {
+        radius = std::max(radius, glm::distance(center, vertices[indices[i]].pos));
+    }
+
+    // front faces wind counter-clockwise, so these normals point out of the front faces
+    vector<glm::vec3> normals;
+    glm::vec3 normal_sum(0);
+
+    for (uint32_t i = first_index; i < end_index; i += 3) {
+        const glm::vec3 &p0 = vertices[indices[i]].pos;
+        const glm::vec3 &p1 = vertices[indices[i + 1]].pos;
+        const glm::vec3 &p2 = vertices[indices[i + 2]].pos;
+        const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+
+        if (glm::length(normal) > 0) {
+            normals.push_back(glm::normalize(normal));
+            normal_sum += normals.back();
+        }
+    }
+
+    glm::vec4 normal_cone(0, 0, 0, 1);
+
+    if (glm::length(normal_sum) > 0) {
+        const glm::vec3 axis = glm::normalize(normal_sum);
+        float min_cos = 1;
 
-    std::filesystem::path ao_path, roughness_path, metallic_path;
+        for (const auto &normal: normals) {
+            min_cos = std::min(min_cos, glm::dot(axis, normal));
+        }
 
-    aiString ao_rel_path;
-    if (assimp_material->GetTexture(aiTextureType_AMBIENT_OCCLUSION, 0, &ao_rel_path) == aiReturn_SUCCESS) {
-        ao_path = base_path;
-        ao_path /= ao_rel_path.C_Str();
-        ao_path.make_preferred();
+        // cones wider than a hemisphere (or nearly so) can't be entirely back-facing from any point
+        constexpr float MIN_CULLABLE_COS = 0.1f;
+        if (min_cos > MIN_CULLABLE_COS) {
+            normal_cone = glm::vec4(axis, std::sqrt(1.0f - min_cos * min_cos));
+        }
     }
 
-    aiString roughness_rel_path;
-    if (assimp_material->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &roughness_rel_path) == aiReturn_SUCCESS) {
-        roughness_path = base_path;
-        roughness_path /= roughness_rel_path.C_Str();
-        roughness_path.make_preferred();
+    return {
+        .first_index = first_index,
+        .triangle_count = triangle_count,
+        .first_vertex = 0,
+        .vertex_count = 0,
+        .bounding_sphere = glm::vec4(center, radius),
+        .normal_cone = normal_cone,
+    };
+}
+
+namespace {
+    /**
+     * Texture whose contents are decoded on a worker thread, before it's created on the calling one.
+     */
+    struct PendingTexture {
+        TextureBuilder builder;
+        std::filesystem::path path;
+        TextureBuilder::LoadedTextureData data{};
+        std::future<void> loaded;
+    };
+
+    struct PendingMaterial {
+        std::optional<PendingTexture> base_color;
+        std::optional<PendingTexture> normal;
+        std::optional<PendingTexture> orm;
+    };
+}
+
+static std::filesystem::path get_texture_path(const aiMaterial *assimp_material, const aiTextureType type,
+                                              const std::filesystem::path &base_path) {
+    aiString rel_path;
+    if (assimp_material->GetTexture(type, 0, &rel_path) != aiReturn_SUCCESS) {
+        return {};
     }
 
-    aiString metallic_rel_path;
-    if (assimp_material->GetTexture(aiTextureType_METALNESS, 0, &metallic_rel_path) == aiReturn_SUCCESS) {
-        metallic_path = base_path;
-        metallic_path /= metallic_rel_path.C_Str();
-        metallic_path.make_preferred();
+    auto path = base_path;
+    path /= rel_path.C_Str();
+    path.make_preferred();
+
+    return path;
+}
+
+static MaterialPaths get_material_paths(const aiMaterial *assimp_material, const std::filesystem::path &base_path) {
+    MaterialPaths paths{
+        .base_color = get_texture_path(assimp_material, aiTextureType_BASE_COLOR, base_path),
+        .normal = get_texture_path(assimp_material, aiTextureType_NORMALS, base_path),
+        .ao = get_texture_path(assimp_material, aiTextureType_AMBIENT_OCCLUSION, base_path),
+        .roughness = get_texture_path(assimp_material, aiTextureType_DIFFUSE_ROUGHNESS, base_path),
+        .metallic = get_texture_path(assimp_material, aiTextureType_METALNESS, base_path),
+    };
+
+    if (paths.normal.empty()) {
+        paths.normal = get_texture_path(assimp_material, aiTextureType_NORMAL_CAMERA, base_path);
     }
 
+    return paths;
+}
+
+static PendingMaterial get_pending_material(const MaterialPaths &paths) {
+    PendingMaterial material;
+
+    // base color
+
+    if (!paths.base_color.empty()) {
+        auto builder = TextureBuilder()
+                .with_flags(vk::TextureFlagBitsZRX::MIPMAPS)
+                .from_paths({paths.base_color});
+
+        material.base_color = PendingTexture{.builder = std::move(builder), .path = paths.base_color};
+    }
+
+    // normal map
+
+    if (!paths.normal.empty()) {
+        auto builder = TextureBuilder()
+                .use_format(vk::Format::eR8G8B8A8Unorm)
+                .from_paths({paths.normal})
+                .with_flags(vk::TextureFlagBitsZRX::MIPMAPS);
+
+        material.normal = PendingTexture{.builder = std::move(builder), .path = paths.normal};
+    }
+
+    // orm
+
+    const auto &ao_path        = paths.ao;
+    const auto &roughness_path = paths.roughness;
+    const auto &metallic_path  = paths.metallic;
+
     auto orm_builder = TextureBuilder()
             .use_format(vk::Format::eR8G8B8A8Unorm)
             .with_flags(vk::TextureFlagBitsZRX::MIPMAPS)
@@ -169,31 +471,151 @@ Material::Material(const RendererContext &ctx, const aiMaterial *assimp_material
         orm_builder.as_separate_channels().from_paths({ao_path, roughness_path, metallic_path});
     }
 
-    orm = orm_builder.create(ctx);
+    material.orm = PendingTexture{.builder = std::move(orm_builder)};
+
+    return material;
+}
+
+/**
+ * Queues decoding the textures of every material on the pool. They take the longest to load, so they should
+ * be queued before anything else.
+ */
+static void queue_texture_loads(ThreadPool &thread_pool, vector<PendingMaterial> &materials) {
+    for (auto &material: materials) {
+        for (auto *texture: {&material.base_color, &material.normal, &material.orm}) {
+            if (!*texture) continue;
+
+            (*texture)->loaded = thread_pool.submit(ThreadPool::Task([&pending = **texture](size_t) {
+                pending.data = pending.builder.load();
+            }));
+        }
+    }
+}
+
+static Material create_material(const RendererContext &ctx, PendingMaterial &pending,
+                                const vk::raii::CommandBuffer &command_buffer,
+                                vector<unique_ptr<Buffer> > &staging_buffers) {
+    Material material;
+
+    const auto create_texture = [&](std::optional<PendingTexture> &texture) -> unique_ptr<Texture> {
+        if (!texture) return nullptr;
+
+        texture->loaded.get();
+        return texture->builder.create(ctx, texture->data, command_buffer, staging_buffers);
+    };
+
+    try {
+        material.base_color = create_texture(pending.base_color);
+    } catch (std::exception &e) {
+        std::cerr << "failed to allocate buffer for texture: " << pending.base_color->path << std::endl;
+        material.base_color = nullptr;
+    }
+
+    material.normal = create_texture(pending.normal);
+    material.orm    = create_texture(pending.orm);
+
+    return material;
 }
 
-Model::Model(const RendererContext &ctx, const std::filesystem::path &path, const bool load_materials) {
+// version of the processing done to meshes after they're imported, i.e. welding, `Mesh::optimize`, building meshlets
+// and normalizing the scale. it's a part of the cache key, so it has to be bumped whenever any of these changes.
+static constexpr std::uint32_t MESH_PROCESSING_VERSION = 2;
+
+namespace {
+    /**
+     * Assimp's default file system, which also records every file the importer opens. These are the model file
+     * itself as well as any files it references, like external buffers or material libraries.
+     */
+    class RecordingIOSystem : public Assimp::DefaultIOSystem {
+        vector<std::filesystem::path> &opened_paths;
+
+    public:
+        explicit RecordingIOSystem(vector<std::filesystem::path> &opened_paths) : opened_paths(opened_paths) {
+        }
+
+        Assimp::IOStream *Open(const char *path, const char *mode = "rb") override {
+            Assimp::IOStream *stream = DefaultIOSystem::Open(path, mode);
+
+            if (stream) {
+                opened_paths.emplace_back(std::filesystem::absolute(path).lexically_normal());
+            }
+
+            return stream;
+        }
+    };
+}
+
+// the importer's own cache locality optimization is only run on request, as `Mesh::optimize` usually finds
+// a better order anyway
+static constexpr unsigned int IMPORT_FLAGS = aiProcess_RemoveRedundantMaterials
+                                             | aiProcess_FindInstances
+                                             | aiProcess_OptimizeMeshes
+                                             | aiProcess_OptimizeGraph
+                                             | aiProcess_FixInfacingNormals
+                                             | aiProcess_Triangulate
+                                             | aiProcess_JoinIdenticalVertices
+                                             | aiProcess_CalcTangentSpace
+                                             | aiProcess_SortByPType
+                                             | aiProcess_ValidateDataStructure;
+
+Model::Model(const RendererContext &ctx, const std::filesystem::path &path, const bool load_materials,
+             const VertexFormat vertex_format, const bool use_importer_cache_optimization)
+    : vertex_format(vertex_format) {
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
+    const unsigned int import_flags = IMPORT_FLAGS
+                                      | (use_importer_cache_optimization ? aiProcess_ImproveCacheLocality : 0);
+
+    // any setting which changes the imported geometry invalidates the cache. the model file itself is checked
+    // by the cache along with the other files read by the importer, so that it's only hashed if it was touched.
+    const std::uint64_t cache_key = Hasher()
+            .add(import_flags)
+            .add(MESH_PROCESSING_VERSION)
+            .add(load_materials)
+            .add(aiGetVersionMajor())
+            .add(aiGetVersionMinor())
+            .add(aiGetVersionPatch())
+            .get();
+
+    const auto cache_path = get_cache_path(path);
+    const auto cache      = ModelCache::load(cache_path, cache_key);
+
+    if (cache) {
+        load_cached(ctx, *cache);
+    } else {
+        import(ctx, path, load_materials, import_flags, cache_path, cache_key);
+    }
+
+    // create_blas(ctx);
+
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+    Logger::info(cache ? "loaded cached model " : "loaded model ", path.filename().string(),
+                 " in ", micros / 1000.0, " ms, with ", vertex_buffer->get_size() / 1024.0, " KiB of vertices");
+}
+
+void Model::import(const RendererContext &ctx, const std::filesystem::path &path, const bool load_materials,
+                   const unsigned int import_flags, const std::filesystem::path &cache_path,
+                   const std::uint64_t cache_key) {
+    // the importer already joins identical vertices, so meshes don't have to be welded again
+    const bool is_welded = (import_flags & aiProcess_JoinIdenticalVertices) != 0;
+
+    vector<std::filesystem::path> opened_paths;
+
+    // the importer takes ownership of the io system
     Assimp::Importer importer;
+    importer.SetIOHandler(new RecordingIOSystem(opened_paths));
 
-    const aiScene *scene = importer.ReadFile(
-        path.string(),
-        aiProcess_RemoveRedundantMaterials
-        | aiProcess_FindInstances
-        | aiProcess_OptimizeMeshes
-        | aiProcess_OptimizeGraph
-        | aiProcess_FixInfacingNormals
-        | aiProcess_Triangulate
-        | aiProcess_JoinIdenticalVertices
-        | aiProcess_CalcTangentSpace
-        | aiProcess_SortByPType
-        | aiProcess_ImproveCacheLocality
-        | aiProcess_ValidateDataStructure
-    );
+    const aiScene *scene = importer.ReadFile(path.string(), import_flags);
 
     if (!scene) {
         Logger::error(importer.GetErrorString());
     }
 
+    vector<MaterialPaths> material_paths;
+    vector<PendingMaterial> pending_materials;
+
     if (load_materials) {
         constexpr size_t MAX_MATERIAL_COUNT = 32;
         if (scene->mNumMaterials > MAX_MATERIAL_COUNT) {
@@ -201,25 +623,166 @@ Model::Model(const RendererContext &ctx, const std::filesystem::path &path, cons
         }
 
         for (size_t i = 0; i < scene->mNumMaterials; i++) {
-            std::filesystem::path base_path = path.parent_path();
-            materials.emplace_back(ctx, scene->mMaterials[i], base_path);
+            material_paths.push_back(get_material_paths(scene->mMaterials[i], path.parent_path()));
+            pending_materials.push_back(get_pending_material(material_paths.back()));
         }
     }
 
+    vector<std::optional<Mesh> > converted_meshes(scene->mNumMeshes);
+    vector<std::future<void> > mesh_futures;
+
+    // textures are decoded and meshes converted independently of each other, so they're spread over all cores.
+    // the pool is declared after everything its tasks write to, so that it's joined before that's destroyed.
+    ThreadPool thread_pool(std::max(1u, std::thread::hardware_concurrency()));
+
+    queue_texture_loads(thread_pool, pending_materials);
+
+    for (size_t i = 0; i < scene->mNumMeshes; i++) {
+        mesh_futures.push_back(thread_pool.submit(ThreadPool::Task([&, i](size_t) {
+            converted_meshes[i].emplace(scene->mMeshes[i], is_welded);
+        })));
+    }
+
+    VertexCacheStats imported_cache_stats;
+    VertexCacheStats optimized_cache_stats;
+
     for (size_t i = 0; i < scene->mNumMeshes; i++) {
-        meshes.emplace_back(scene->mMeshes[i]);
+        mesh_futures[i].get();
+        meshes.push_back(std::move(*converted_meshes[i]));
 
         if (!load_materials) {
             meshes.back().material_id = 0;
         }
+
+        imported_cache_stats += meshes.back().imported_cache_stats;
+        optimized_cache_stats += meshes.back().optimized_cache_stats;
     }
 
+    // the imported order is that of the importer's cache optimization, if it ran
+    Logger::info("reordered ", path.filename().string(), " for a vertex cache of ", VERTEX_CACHE_SIZE,
+                 " vertices: ACMR ", imported_cache_stats.get_acmr(), " -> ", optimized_cache_stats.get_acmr(),
+                 ", ATVR ", imported_cache_stats.get_atvr(), " -> ", optimized_cache_stats.get_atvr());
+
     add_instances(scene->mRootNode, glm::identity<glm::mat4>());
 
     normalize_scale();
+    create_instance_bounds();
+
+    const auto vertices            = get_vertices();
+    const auto indices             = get_indices();
+    const auto instance_transforms = get_instance_transforms();
+    const auto mesh_descriptions   = get_mesh_descriptions();
+    const auto meshlets            = get_meshlet_descriptions();
+    const auto meshlet_vertices    = get_meshlet_vertices();
+    const auto meshlet_triangles   = get_meshlet_triangles();
+
+    const ModelGeometry geometry{
+        .vertices = vertices,
+        .indices = indices,
+        .instance_transforms = instance_transforms,
+        .mesh_descriptions = mesh_descriptions,
+        .meshlets = meshlets,
+        .meshlet_vertices = meshlet_vertices,
+        .meshlet_triangles = meshlet_triangles,
+    };
 
-    create_buffers(ctx);
-    // create_blas(ctx);
+    meshlet_count = static_cast<uint32_t>(meshlets.size());
+
+    // everything is uploaded by a single submission, once all the textures are decoded
+    vector<unique_ptr<Buffer> > staging_buffers;
+
+    utils::cmd::do_single_time_commands(ctx, [&](const vk::raii::CommandBuffer &command_buffer) {
+        for (auto &material: pending_materials) {
+            materials.push_back(create_material(ctx, material, command_buffer, staging_buffers));
+        }
+
+        create_buffers(ctx, geometry, command_buffer, staging_buffers);
+    });
+
+    vector<CachedMesh> cached_meshes;
+
+    for (auto &mesh: meshes) {
+        cached_meshes.push_back(CachedMesh{
+            .aabb = {.min = glm::vec4(mesh.aabb_min, 1.0f), .max = glm::vec4(mesh.aabb_max, 1.0f)},
+            .bounding_sphere = mesh.bounding_sphere,
+            .material_id = mesh.material_id,
+            .vertex_count = mesh.vertex_count,
+            .index_count = mesh.index_count,
+            .instance_count = static_cast<uint32_t>(mesh.instances.size()),
+        });
+
+        // the geometry lives in the buffers from now on, like that of a cached model
+        mesh.vertices          = {};
+        mesh.indices           = {};
+        mesh.meshlets          = {};
+        mesh.meshlet_vertices  = {};
+        mesh.meshlet_triangles = {};
+    }
+
+    // the model file is normally among the opened ones, but it has to be checked even if it wasn't
+    opened_paths.push_back(std::filesystem::absolute(path).lexically_normal());
+    std::ranges::sort(opened_paths);
+    const auto [unique_end, paths_end] = std::ranges::unique(opened_paths);
+    opened_paths.erase(unique_end, paths_end);
+
+    ModelCache::save(cache_path, cache_key, cached_meshes, geometry, material_paths, opened_paths);
+}
+
+void Model::load_cached(const RendererContext &ctx, const ModelCache &cache) {
+    const auto &geometry = cache.get_geometry();
+
+    vector<PendingMaterial> pending_materials;
+
+    for (const auto &paths: cache.get_materials()) {
+        pending_materials.push_back(get_pending_material(paths));
+    }
+
+    ThreadPool thread_pool(std::max(1u, std::thread::hardware_concurrency()));
+    queue_texture_loads(thread_pool, pending_materials);
+
+    size_t instance_offset = 0;
+
+    for (size_t i = 0; i < cache.get_meshes().size(); i++) {
+        const auto &cached_mesh = cache.get_meshes()[i];
+        auto &mesh = meshes.emplace_back();
+
+        mesh.material_id     = cached_mesh.material_id;
+        mesh.vertex_count    = cached_mesh.vertex_count;
+        mesh.index_count     = cached_mesh.index_count;
+        mesh.aabb_min        = glm::vec3(cached_mesh.aabb.min);
+        mesh.aabb_max        = glm::vec3(cached_mesh.aabb.max);
+        mesh.bounding_sphere = cached_mesh.bounding_sphere;
+        mesh.meshlet_count   = geometry.mesh_descriptions[i].meshlet_count;
+
+        const auto instances = geometry.instance_transforms.subspan(instance_offset, cached_mesh.instance_count);
+        mesh.instances.assign(instances.begin(), instances.end());
+        instance_offset += cached_mesh.instance_count;
+    }
+
+    // the cached transforms are already normalized
+    create_instance_bounds();
+
+    meshlet_count = static_cast<uint32_t>(geometry.meshlets.size());
+
+    vector<unique_ptr<Buffer> > staging_buffers;
+
+    utils::cmd::do_single_time_commands(ctx, [&](const vk::raii::CommandBuffer &command_buffer) {
+        for (auto &material: pending_materials) {
+            materials.push_back(create_material(ctx, material, command_buffer, staging_buffers));
+        }
+
+        create_buffers(ctx, geometry, command_buffer, staging_buffers);
+    });
+}
+
+std::filesystem::path Model::get_cache_path(const std::filesystem::path &path) {
+    // the name is made unique among models with the same file name by the hash of the whole path
+    const std::uint64_t path_hash = Hasher().add(std::filesystem::absolute(path)).get();
+
+    std::ostringstream name;
+    name << path.stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0') << path_hash << ".zrxmesh";
+
+    return std::filesystem::path(CACHE_DIRECTORY) / name.str();
 }
 
 void Model::add_instances(const aiNode *node, const glm::mat4 &base_transform) {
@@ -288,18 +851,168 @@ vector<glm::mat4> Model::get_instance_transforms() const {
 vector<MeshDescription> Model::get_mesh_descriptions() const {
     vector<MeshDescription> result;
 
-    uint32_t index_offset  = 0;
-    uint32_t vertex_offset = 0;
+    uint32_t index_offset   = 0;
+    uint32_t vertex_offset  = 0;
+    uint32_t meshlet_offset = 0;
 
     for (const auto &mesh: meshes) {
         result.emplace_back(MeshDescription{
             .material_id = mesh.material_id,
             .vertex_offset = vertex_offset,
             .index_offset = index_offset,
+            .first_meshlet = meshlet_offset,
+            .meshlet_count = mesh.meshlet_count,
+        });
+
+        index_offset += mesh.index_count;
+        vertex_offset += mesh.vertex_count;
+        meshlet_offset += mesh.meshlet_count;
+    }
+
+    return result;
+}
+
+vector<vk::DrawIndexedIndirectCommand> Model::get_draw_commands() const {
+    vector<vk::DrawIndexedIndirectCommand> result;
+
+    uint32_t index_offset    = 0;
+    int32_t vertex_offset    = 0;
+    uint32_t instance_offset = 0;
+
+    for (const auto &mesh: meshes) {
+        result.emplace_back(vk::DrawIndexedIndirectCommand{
+            .indexCount = mesh.index_count,
+            .instanceCount = static_cast<uint32_t>(mesh.instances.size()),
+            .firstIndex = index_offset,
+            .vertexOffset = vertex_offset,
+            .firstInstance = instance_offset,
+        });
+
+        index_offset += mesh.index_count;
+        vertex_offset += static_cast<int32_t>(mesh.vertex_count);
+        instance_offset += static_cast<uint32_t>(mesh.instances.size());
+    }
+
+    return result;
+}
+
+uint32_t Model::get_instance_count() const {
+    uint32_t result = 0;
+
+    for (const auto &mesh: meshes) {
+        result += static_cast<uint32_t>(mesh.instances.size());
+    }
+
+    return result;
+}
+
+uint32_t Model::get_vertex_count() const {
+    uint32_t result = 0;
+
+    for (const auto &mesh: meshes) {
+        result += mesh.vertex_count;
+    }
+
+    return result;
+}
+
+uint32_t Model::get_index_count() const {
+    uint32_t result = 0;
+
+    for (const auto &mesh: meshes) {
+        result += mesh.index_count;
+    }
+
+    return result;
+}
+
+vector<uint32_t> Model::get_instance_mesh_ids() const {
+    vector<uint32_t> result;
+    result.reserve(get_instance_count());
+
+    for (uint32_t mesh_id = 0; mesh_id < meshes.size(); mesh_id++) {
+        result.insert(result.end(), meshes[mesh_id].instances.size(), mesh_id);
+    }
+
+    return result;
+}
+
+vector<glm::vec4> Model::get_mesh_bounds() const {
+    vector<glm::vec4> result;
+
+    for (const auto &mesh: meshes) {
+        result.push_back(mesh.bounding_sphere);
+    }
+
+    return result;
+}
+
+vector<MeshAabb> Model::get_mesh_aabbs() const {
+    vector<MeshAabb> result;
+
+    for (const auto &mesh: meshes) {
+        result.emplace_back(MeshAabb{
+            .min = glm::vec4(mesh.aabb_min, 1.0f),
+            .max = glm::vec4(mesh.aabb_max, 1.0f),
         });
+    }
+
+    return result;
+}
 
-        index_offset += static_cast<uint32_t>(mesh.indices.size());
-        vertex_offset += static_cast<std::int32_t>(mesh.vertices.size());
+vector<MeshletDescription> Model::get_meshlet_descriptions() const {
+    vector<MeshletDescription> result;
+
+    uint32_t index_offset          = 0;
+    uint32_t meshlet_vertex_offset = 0;
+
+    for (uint32_t mesh_id = 0; mesh_id < meshes.size(); mesh_id++) {
+        for (const auto &meshlet: meshes[mesh_id].meshlets) {
+            result.emplace_back(MeshletDescription{
+                .bounding_sphere = meshlet.bounding_sphere,
+                .normal_cone = meshlet.normal_cone,
+                .mesh_id = mesh_id,
+                .first_index = index_offset + meshlet.first_index,
+                .triangle_count = meshlet.triangle_count,
+                .first_vertex = meshlet_vertex_offset + meshlet.first_vertex,
+                .vertex_count = meshlet.vertex_count,
+            });
+        }
+
+        index_offset += meshes[mesh_id].index_count;
+        meshlet_vertex_offset += static_cast<uint32_t>(meshes[mesh_id].meshlet_vertices.size());
+    }
+
+    return result;
+}
+
+vector<uint32_t> Model::get_meshlet_vertices() const {
+    vector<uint32_t> result;
+
+    uint32_t vertex_offset = 0;
+
+    for (const auto &mesh: meshes) {
+        for (const auto vertex: mesh.meshlet_vertices) {
+            result.push_back(vertex_offset + vertex);
+        }
+
+        vertex_offset += mesh.vertex_count;
+    }
+
+    return result;
+}
+
+vector<uint32_t> Model::get_meshlet_triangles() const {
+    vector<uint32_t> result((get_index_count() + 3) / 4, 0);
+
+    // shaders read the bytes out of whole words, so that they don't need 8-bit storage
+    size_t index = 0;
+
+    for (const auto &mesh: meshes) {
+        for (const auto local_index: mesh.meshlet_triangles) {
+            result[index / 4] |= static_cast<uint32_t>(local_index) << (index % 4 * 8);
+            index++;
+        }
     }
 
     return result;
@@ -311,47 +1024,151 @@ void Model::bind_buffers(const vk::raii::CommandBuffer &command_buffer) const {
     command_buffer.bindIndexBuffer(**index_buffer, 0, vk::IndexType::eUint32);
 }
 
-void Model::create_buffers(const RendererContext &ctx) {
+void Model::create_vertex_buffer(const RendererContext &ctx, const std::span<const ModelVertex> vertices,
+                                 const vk::BufferUsageFlags usage, const vk::raii::CommandBuffer &command_buffer,
+                                 vector<unique_ptr<Buffer> > &staging_buffers) {
+    if (vertex_format == VertexFormat::FULL) {
+        vertex_buffer = utils::buf::create_local_buffer(ctx, vertices, usage, command_buffer, staging_buffers);
+        return;
+    }
+
+    vector<PackedModelVertex> packed_vertices;
+    packed_vertices.reserve(vertices.size());
+
+    for (const auto &vertex: vertices) {
+        packed_vertices.emplace_back(vertex);
+    }
+
+    vertex_buffer = utils::buf::create_local_buffer(ctx, packed_vertices, usage, command_buffer, staging_buffers);
+}
+
+void Model::create_buffers(const RendererContext &ctx, const ModelGeometry &geometry,
+                           const vk::raii::CommandBuffer &command_buffer,
+                           vector<unique_ptr<Buffer> > &staging_buffers) {
     constexpr auto ray_tracing_flags = vk::BufferUsageFlagBits::eStorageBuffer
                                        | vk::BufferUsageFlagBits::eShaderDeviceAddress
                                        | vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR;
 
-    vertex_buffer = utils::buf::create_local_buffer(
-        ctx,
-        get_vertices(),
-        vk::BufferUsageFlagBits::eVertexBuffer | ray_tracing_flags
-    );
+    // read through buffer references by the instance culling shaders
+    constexpr auto culling_flags = vk::BufferUsageFlagBits::eStorageBuffer
+                                   | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+    create_vertex_buffer(ctx, geometry.vertices, vk::BufferUsageFlagBits::eVertexBuffer | ray_tracing_flags,
+                         command_buffer, staging_buffers);
 
     instance_data_buffer = utils::buf::create_local_buffer(
         ctx,
-        get_instance_transforms(),
-        vk::BufferUsageFlagBits::eVertexBuffer | ray_tracing_flags
+        geometry.instance_transforms,
+        vk::BufferUsageFlagBits::eVertexBuffer | ray_tracing_flags,
+        command_buffer,
+        staging_buffers
     );
 
     index_buffer = utils::buf::create_local_buffer(
         ctx,
-        get_indices(),
-        vk::BufferUsageFlagBits::eIndexBuffer | ray_tracing_flags
+        geometry.indices,
+        vk::BufferUsageFlagBits::eIndexBuffer | ray_tracing_flags,
+        command_buffer,
+        staging_buffers
     );
 
     mesh_descriptions_buffer = utils::buf::create_local_buffer(
         ctx,
-        get_mesh_descriptions(),
-        ray_tracing_flags
+        geometry.mesh_descriptions,
+        ray_tracing_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    // lets the shaders look up the material of the mesh being drawn
+    mesh_descriptions_address = ctx.device->getBufferAddress({.buffer = **mesh_descriptions_buffer});
+
+    draw_commands_buffer = utils::buf::create_local_buffer(
+        ctx,
+        get_draw_commands(),
+        vk::BufferUsageFlagBits::eIndirectBuffer | culling_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    instance_mesh_ids_buffer = utils::buf::create_local_buffer(
+        ctx,
+        get_instance_mesh_ids(),
+        culling_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    mesh_bounds_buffer = utils::buf::create_local_buffer(
+        ctx,
+        get_mesh_bounds(),
+        culling_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    mesh_aabbs_buffer = utils::buf::create_local_buffer(
+        ctx,
+        get_mesh_aabbs(),
+        culling_flags,
+        command_buffer,
+        staging_buffers
     );
+
+    meshlets_buffer = utils::buf::create_local_buffer(
+        ctx,
+        geometry.meshlets,
+        culling_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    meshlet_vertices_buffer = utils::buf::create_local_buffer(
+        ctx,
+        geometry.meshlet_vertices,
+        culling_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    meshlet_triangles_buffer = utils::buf::create_local_buffer(
+        ctx,
+        geometry.meshlet_triangles,
+        culling_flags,
+        command_buffer,
+        staging_buffers
+    );
+
+    culling_inputs = ModelCullingInputs{
+        .instance_transforms = ctx.device->getBufferAddress({.buffer = **instance_data_buffer}),
+        .instance_mesh_ids = ctx.device->getBufferAddress({.buffer = **instance_mesh_ids_buffer}),
+        .mesh_bounds = ctx.device->getBufferAddress({.buffer = **mesh_bounds_buffer}),
+        .mesh_aabbs = ctx.device->getBufferAddress({.buffer = **mesh_aabbs_buffer}),
+        .draw_commands = ctx.device->getBufferAddress({.buffer = **draw_commands_buffer}),
+        .meshlets = ctx.device->getBufferAddress({.buffer = **meshlets_buffer}),
+        .indices = ctx.device->getBufferAddress({.buffer = **index_buffer}),
+        .mesh_descriptions = mesh_descriptions_address,
+    };
+
+    meshlet_inputs = ModelMeshletInputs{
+        .meshlets = culling_inputs.meshlets,
+        .meshlet_vertices = ctx.device->getBufferAddress({.buffer = **meshlet_vertices_buffer}),
+        .meshlet_triangles = ctx.device->getBufferAddress({.buffer = **meshlet_triangles_buffer}),
+        .vertices = ctx.device->getBufferAddress({.buffer = **vertex_buffer}),
+    };
 }
 
 void Model::create_blas(const RendererContext &ctx) {
     const vk::DeviceAddress vertex_address = ctx.device->getBufferAddress({.buffer = **vertex_buffer});
     const vk::DeviceAddress index_address  = ctx.device->getBufferAddress({.buffer = **index_buffer});
 
-    const uint32_t max_primitive_count = get_indices().size() / 3;
+    const uint32_t max_primitive_count = get_index_count() / 3;
 
     const vk::AccelerationStructureGeometryTrianglesDataKHR geometry_triangles{
         .vertexFormat = vk::Format::eR32G32B32Sfloat,
         .vertexData = vertex_address,
-        .vertexStride = sizeof(ModelVertex),
-        .maxVertex = static_cast<uint32_t>(get_vertices().size() - 1),
+        .vertexStride = get_vertex_stride(vertex_format), // both formats start with the full position
+        .maxVertex = get_vertex_count() - 1,
         .indexType = vk::IndexType::eUint32,
         .indexData = index_address,
     };
@@ -441,6 +1258,21 @@ void Model::normalize_scale() {
     }
 }
 
+void Model::create_instance_bounds() {
+    for (const auto &mesh: meshes) {
+        for (const auto &transform: mesh.instances) {
+            const glm::vec3 center = transform * glm::vec4(glm::vec3(mesh.bounding_sphere), 1.0f);
+            const float scale = std::max({
+                glm::length(glm::vec3(transform[0])),
+                glm::length(glm::vec3(transform[1])),
+                glm::length(glm::vec3(transform[2]))
+            });
+
+            instance_bounds.push_back(glm::vec4(center, mesh.bounding_sphere.w * scale));
+        }
+    }
+}
+
 float Model::get_max_vertex_distance() const {
     float largest_distance = 0.0;
 
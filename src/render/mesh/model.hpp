@@ -1,14 +1,16 @@
 #pragma once
 
 #include <filesystem>
+#include <span>
 #include <vector>
 
 #include "vertex.hpp"
+#include "culling.hpp"
+#include "mesh-optimizer.hpp"
 #include "src/render/libs.hpp"
 #include "src/render/globals.hpp"
 #include "src/render/vk/accel-struct.hpp"
 
-struct aiMaterial;
 struct aiScene;
 struct aiMesh;
 struct aiNode;
@@ -17,31 +19,154 @@ namespace zrx {
 struct RendererContext;
 class Texture;
 class Buffer;
+class ModelCache;
+
+/**
+ * A small cluster of a mesh's triangles, which is culled as a whole. Its triangles are a contiguous range
+ * of the mesh's indices, so that drawing the cluster doesn't need any indices of its own. Mesh shaders
+ * draw it from its own list of vertices instead, which its triangles index into.
+ */
+struct Meshlet {
+    static constexpr uint32_t MAX_VERTICES  = 64;
+    static constexpr uint32_t MAX_TRIANGLES = 124;
+
+    uint32_t first_index; // relative to the first index of the mesh
+    uint32_t triangle_count;
+    uint32_t first_vertex; // relative to the first of the mesh's meshlet vertices
+    uint32_t vertex_count;
+
+    // bounds in the mesh's local space. the cone holds the average normal of the triangles in `xyz`
+    // and the sine of its spread in `w`, which is 1 if the triangles might face any direction.
+    glm::vec4 bounding_sphere;
+    glm::vec4 normal_cone;
+};
 
 struct Mesh {
+    // only kept while the mesh is imported, as its geometry lives in the model's buffers afterwards
     vector<ModelVertex> vertices;
     vector<uint32_t> indices;
+
     vector<glm::mat4> instances;
-    uint32_t material_id;
+    uint32_t material_id = 0;
+    uint32_t vertex_count = 0;
+    uint32_t index_count = 0;
+
+    // bounds of the vertices in the mesh's local space
+    glm::vec3 aabb_min{0};
+    glm::vec3 aabb_max{0};
+    glm::vec4 bounding_sphere{0}; // radius stored in `w`
+
+    // only kept while the mesh is imported, like its geometry. `meshlet_vertices` holds the vertices of each meshlet
+    // as indices of the mesh's vertices, and `meshlet_triangles` holds the position of every one of the mesh's
+    // indices within the vertices of its meshlet.
+    vector<Meshlet> meshlets;
+    vector<uint32_t> meshlet_vertices;
+    vector<uint8_t> meshlet_triangles;
+    uint32_t meshlet_count = 0;
+
+    // simulated vertex cache behaviour of the imported indices, before and after they're reordered
+    VertexCacheStats imported_cache_stats;
+    VertexCacheStats optimized_cache_stats;
+
+    /**
+     * Creates an empty mesh, to be filled in from the model cache.
+     */
+    Mesh() = default;
+
+    /**
+     * Loads the mesh's vertices and indices. Welded meshes, i.e. ones imported with identical vertices joined,
+     * are taken as they are, while the vertices of other meshes are welded here. Either way, the triangles
+     * are then reordered for the vertex cache and overdraw, unless that wouldn't improve on the imported order,
+     * and the vertices are reordered for vertex fetches.
+     */
+    explicit Mesh(const aiMesh *assimp_mesh, bool is_welded);
+
+private:
+    void load_indexed(const aiMesh *assimp_mesh);
+
+    void load_welded(const aiMesh *assimp_mesh);
+
+    void optimize();
+
+    void compute_bounds();
 
-    explicit Mesh(const aiMesh *assimp_mesh);
+    void build_meshlets();
+
+    [[nodiscard]] Meshlet create_meshlet(uint32_t first_index, uint32_t triangle_count) const;
 };
 
 struct MeshDescription {
     uint32_t material_id;
     uint32_t vertex_offset;
     uint32_t index_offset;
+    uint32_t first_meshlet; // meshlets are ordered by mesh, so each mesh owns a contiguous range of them
+    uint32_t meshlet_count;
+};
+
+/**
+ * Meshlet as read by the meshlet culling and mesh shaders, padded to the alignment of `vec4` in shaders.
+ */
+struct MeshletDescription {
+    glm::vec4 bounding_sphere;
+    glm::vec4 normal_cone;
+    uint32_t mesh_id;
+    uint32_t first_index; // relative to the start of the model's index buffer
+    uint32_t triangle_count;
+    uint32_t first_vertex; // relative to the start of the model's meshlet vertices
+    uint32_t vertex_count;
+    uint32_t _padding[3];
+};
+
+/**
+ * Device addresses of the model's buffers read by the instance culling shaders.
+ */
+struct ModelCullingInputs {
+    vk::DeviceAddress instance_transforms;
+    vk::DeviceAddress instance_mesh_ids;
+    vk::DeviceAddress mesh_bounds;
+    vk::DeviceAddress mesh_aabbs;
+    vk::DeviceAddress draw_commands;
+    vk::DeviceAddress meshlets;
+    vk::DeviceAddress indices;
+    vk::DeviceAddress mesh_descriptions;
+};
+
+/**
+ * Device addresses of the model's buffers read by the task and mesh shaders, which fetch the vertices themselves.
+ */
+struct ModelMeshletInputs {
+    vk::DeviceAddress meshlets;
+    vk::DeviceAddress meshlet_vertices;
+    vk::DeviceAddress meshlet_triangles;
+    vk::DeviceAddress vertices;
+};
+
+/**
+ * Axis-aligned bounding box of a mesh, padded to the alignment of `vec4` in shaders.
+ */
+struct MeshAabb {
+    glm::vec4 min;
+    glm::vec4 max;
+};
+
+/**
+ * Contiguous arrays uploaded into a model's vertex, index, instance, mesh description and meshlet buffers,
+ * which either point into the imported meshes or into a mapped model cache.
+ */
+struct ModelGeometry {
+    std::span<const ModelVertex> vertices;
+    std::span<const uint32_t> indices;
+    std::span<const glm::mat4> instance_transforms;
+    std::span<const MeshDescription> mesh_descriptions;
+    std::span<const MeshletDescription> meshlets;
+    std::span<const uint32_t> meshlet_vertices;  // indices of the model's vertices
+    std::span<const uint32_t> meshlet_triangles; // one byte per index of the model, packed into words
 };
 
 struct Material {
     unique_ptr<Texture> base_color;
     unique_ptr<Texture> normal;
     unique_ptr<Texture> orm;
-
-    Material() = default;
-
-    explicit Material(const RendererContext &ctx, const aiMaterial *assimp_material,
-                      const std::filesystem::path &base_path);
 };
 
 class Model {
@@ -52,11 +177,43 @@ class Model {
     unique_ptr<Buffer> instance_data_buffer;
     unique_ptr<Buffer> index_buffer;
     unique_ptr<Buffer> mesh_descriptions_buffer;
+    unique_ptr<Buffer> draw_commands_buffer;
+    unique_ptr<Buffer> instance_mesh_ids_buffer;
+    unique_ptr<Buffer> mesh_bounds_buffer;
+    unique_ptr<Buffer> mesh_aabbs_buffer;
+    unique_ptr<Buffer> meshlets_buffer;
+    unique_ptr<Buffer> meshlet_vertices_buffer;
+    unique_ptr<Buffer> meshlet_triangles_buffer;
+
+    vk::DeviceAddress mesh_descriptions_address = 0;
+    ModelCullingInputs culling_inputs{};
+    ModelMeshletInputs meshlet_inputs{};
+
+    uint32_t meshlet_count = 0;
+
+    VertexFormat vertex_format;
+
+    // bounds of every instance in the model's space, in the same order as the instance transforms
+    BoundingSpheres instance_bounds;
 
     unique_ptr<AccelerationStructure> blas;
 
 public:
-    explicit Model(const RendererContext &ctx, const std::filesystem::path &path, bool load_materials);
+    // directory holding the geometry caches of imported models, relative to the working directory
+    static constexpr auto CACHE_DIRECTORY = "model-cache";
+
+    /**
+     * Loads the model at `path`. Its geometry is imported only when there's no valid cache of it yet,
+     * and is otherwise uploaded straight from the cache written by an earlier import. The cache always holds
+     * full vertices, which are packed while uploading them if `vertex_format` asks for it.
+     *
+     * Meshes are reordered by `Mesh::optimize`, which keeps the order the importer leaves them in only if it's
+     * better for the vertex cache. Assimp's own cache locality optimization skips meshes triangulated from
+     * polygons and usually loses to the in-tree one, so it only runs if `use_importer_cache_optimization` is set,
+     * e.g. to compare against it. `bench/mesh-optimizer-bench.cpp` measures both on the bundled models.
+     */
+    explicit Model(const RendererContext &ctx, const std::filesystem::path &path, bool load_materials,
+                   VertexFormat vertex_format = VertexFormat::FULL, bool use_importer_cache_optimization = false);
 
     void add_instances(const aiNode *node, const glm::mat4 &base_transform);
 
@@ -66,26 +223,96 @@ public:
 
     [[nodiscard]] const Buffer &get_vertex_buffer() const { return *vertex_buffer; }
 
+    [[nodiscard]] VertexFormat get_vertex_format() const { return vertex_format; }
+
     [[nodiscard]] const Buffer &get_index_buffer() const { return *index_buffer; }
 
+    [[nodiscard]] const Buffer &get_instance_buffer() const { return *instance_data_buffer; }
+
     [[nodiscard]] const Buffer &get_mesh_descriptions_buffer() const { return *mesh_descriptions_buffer; }
 
-    [[nodiscard]] vector<ModelVertex> get_vertices() const;
+    [[nodiscard]] vk::DeviceAddress get_mesh_descriptions_address() const { return mesh_descriptions_address; }
 
-    [[nodiscard]] vector<uint32_t> get_indices() const;
+    /**
+     * Buffer of one indexed indirect draw per mesh, in the same order as the meshes.
+     */
+    [[nodiscard]] const Buffer &get_draw_commands_buffer() const { return *draw_commands_buffer; }
+
+    [[nodiscard]] const ModelCullingInputs &get_culling_inputs() const { return culling_inputs; }
+
+    [[nodiscard]] const ModelMeshletInputs &get_meshlet_inputs() const { return meshlet_inputs; }
+
+    [[nodiscard]] uint32_t get_instance_count() const;
+
+    [[nodiscard]] uint32_t get_vertex_count() const;
+
+    [[nodiscard]] uint32_t get_index_count() const;
+
+    [[nodiscard]] uint32_t get_meshlet_count() const { return meshlet_count; }
+
+    [[nodiscard]] const BoundingSpheres &get_instance_bounds() const { return instance_bounds; }
 
     [[nodiscard]] vector<glm::mat4> get_instance_transforms() const;
 
     [[nodiscard]] vector<MeshDescription> get_mesh_descriptions() const;
 
+    [[nodiscard]] vector<vk::DrawIndexedIndirectCommand> get_draw_commands() const;
+
+    /**
+     * Returns the index of the mesh drawn by each instance, in the same order as `get_instance_transforms`.
+     */
+    [[nodiscard]] vector<uint32_t> get_instance_mesh_ids() const;
+
+    /**
+     * Returns the bounding sphere of each mesh in its local space, with the radius stored in `w`.
+     */
+    [[nodiscard]] vector<glm::vec4> get_mesh_bounds() const;
+
+    [[nodiscard]] vector<MeshAabb> get_mesh_aabbs() const;
+
     [[nodiscard]] const vk::raii::AccelerationStructureKHR &get_blas() const { return **blas; }
 
     void bind_buffers(const vk::raii::CommandBuffer &command_buffer) const;
 
 private:
+    void import(const RendererContext &ctx, const std::filesystem::path &path, bool load_materials,
+                unsigned int import_flags, const std::filesystem::path &cache_path, std::uint64_t cache_key);
+
+    void load_cached(const RendererContext &ctx, const ModelCache &cache);
+
+    [[nodiscard]] static std::filesystem::path get_cache_path(const std::filesystem::path &path);
+
+    // these need the meshes' geometry, so they're only available while importing
+
+    [[nodiscard]] vector<ModelVertex> get_vertices() const;
+
+    [[nodiscard]] vector<uint32_t> get_indices() const;
+
+    /**
+     * Returns the meshlets of all meshes, ordered by mesh.
+     */
+    [[nodiscard]] vector<MeshletDescription> get_meshlet_descriptions() const;
+
+    /**
+     * Returns the vertices of all meshlets as indices of the model's vertices, in the same order as the meshlets.
+     */
+    [[nodiscard]] vector<uint32_t> get_meshlet_vertices() const;
+
+    /**
+     * Returns the meshlet triangles of all meshes, i.e. one byte per index of the model, packed four to a word.
+     */
+    [[nodiscard]] vector<uint32_t> get_meshlet_triangles() const;
+
     void normalize_scale();
 
-    void create_buffers(const RendererContext &ctx);
+    void create_instance_bounds();
+
+    void create_vertex_buffer(const RendererContext &ctx, std::span<const ModelVertex> vertices,
+                              vk::BufferUsageFlags usage, const vk::raii::CommandBuffer &command_buffer,
+                              vector<unique_ptr<Buffer> > &staging_buffers);
+
+    void create_buffers(const RendererContext &ctx, const ModelGeometry &geometry,
+                        const vk::raii::CommandBuffer &command_buffer, vector<unique_ptr<Buffer> > &staging_buffers);
 
     void create_blas(const RendererContext &ctx);
 
@@ -1,5 +1,7 @@
 #include "vertex.hpp"
 
+#include <glm/gtc/packing.hpp>
+
 namespace zrx {
 vector<vk::VertexInputBindingDescription> ModelVertex::get_binding_descriptions() {
     return {
@@ -75,6 +77,102 @@ vector<vk::VertexInputAttributeDescription> ModelVertex::get_attribute_descripti
     };
 }
 
+/**
+ * Maps a unit vector onto the [-1, 1] square, by projecting it onto an octahedron and unfolding
+ * the octahedron's lower half over the corners of the square.
+ */
+static glm::vec2 encode_octahedral(const glm::vec3 &v) {
+    const float l1_norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    if (l1_norm == 0) return {0, 0};
+
+    const glm::vec2 projected = glm::vec2(v) / l1_norm;
+    if (v.z >= 0) return projected;
+
+    const glm::vec2 sign = {projected.x >= 0 ? 1.0f : -1.0f, projected.y >= 0 ? 1.0f : -1.0f};
+    return (1.0f - glm::abs(glm::vec2(projected.y, projected.x))) * sign;
+}
+
+PackedModelVertex::PackedModelVertex(const ModelVertex &vertex)
+    : pos(vertex.pos),
+      tex_coord(glm::packHalf2x16(vertex.tex_coord)),
+      normal(glm::packSnorm2x16(encode_octahedral(vertex.normal))) {
+    // the bitangent is flipped relative to cross(normal, tangent) in mirrored parts of the uv mapping
+    const float handedness = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0 ? -1.0f : 1.0f;
+    const float tangent_length = glm::length(vertex.tangent);
+    const glm::vec3 unit_tangent = tangent_length > 0 ? vertex.tangent / tangent_length : glm::vec3(0);
+
+    tangent = glm::packSnorm4x8(glm::vec4(unit_tangent, handedness));
+}
+
+vector<vk::VertexInputBindingDescription> PackedModelVertex::get_binding_descriptions() {
+    return {
+        {
+            .binding = 0u,
+            .stride = static_cast<uint32_t>(sizeof(PackedModelVertex)),
+            .inputRate = vk::VertexInputRate::eVertex
+        },
+        {
+            .binding = 1u,
+            .stride = static_cast<uint32_t>(sizeof(glm::mat4)),
+            .inputRate = vk::VertexInputRate::eInstance
+        }
+    };
+}
+
+vector<vk::VertexInputAttributeDescription> PackedModelVertex::get_attribute_descriptions() {
+    // locations of the instance transform are the same as with `ModelVertex`
+    return {
+        {
+            .location = 0U,
+            .binding = 0U,
+            .format = vk::Format::eR32G32B32Sfloat,
+            .offset = static_cast<uint32_t>(offsetof(PackedModelVertex, pos)),
+        },
+        {
+            .location = 1U,
+            .binding = 0U,
+            .format = vk::Format::eR16G16Sfloat,
+            .offset = static_cast<uint32_t>(offsetof(PackedModelVertex, tex_coord)),
+        },
+        {
+            .location = 2U,
+            .binding = 0U,
+            .format = vk::Format::eR16G16Snorm,
+            .offset = static_cast<uint32_t>(offsetof(PackedModelVertex, normal)),
+        },
+        {
+            .location = 3U,
+            .binding = 0U,
+            .format = vk::Format::eR8G8B8A8Snorm,
+            .offset = static_cast<uint32_t>(offsetof(PackedModelVertex, tangent)),
+        },
+        {
+            .location = 5U,
+            .binding = 1U,
+            .format = vk::Format::eR32G32B32A32Sfloat,
+            .offset = 0U,
+        },
+        {
+            .location = 6U,
+            .binding = 1U,
+            .format = vk::Format::eR32G32B32A32Sfloat,
+            .offset = static_cast<uint32_t>(sizeof(glm::vec4)),
+        },
+        {
+            .location = 7U,
+            .binding = 1U,
+            .format = vk::Format::eR32G32B32A32Sfloat,
+            .offset = static_cast<uint32_t>(2 * sizeof(glm::vec4)),
+        },
+        {
+            .location = 8U,
+            .binding = 1U,
+            .format = vk::Format::eR32G32B32A32Sfloat,
+            .offset = static_cast<uint32_t>(3 * sizeof(glm::vec4)),
+        },
+    };
+}
+
 vector<vk::VertexInputBindingDescription> SkyboxVertex::get_binding_descriptions() {
     return {
         {
@@ -19,19 +19,50 @@ struct ModelVertex {
     glm::vec3 tangent;
     glm::vec3 bitangent;
 
-    // this is implemented to allow using `Vertex` as a key in an `unordered_map`.
-    bool operator==(const ModelVertex &other) const {
-        return pos == other.pos
-               && tex_coord == other.tex_coord
-               && tangent == other.tangent
-               && bitangent == other.bitangent;
-    }
+    bool operator==(const ModelVertex &other) const = default;
 
     static vector<vk::VertexInputBindingDescription> get_binding_descriptions();
 
     static vector<vk::VertexInputAttributeDescription> get_attribute_descriptions();
 };
 
+/**
+ * Compact counterpart of `ModelVertex`, taking 24 bytes instead of 56. Its texture coordinates are half floats,
+ * its normal is octahedral-encoded into two 16-bit components, and only the tangent is stored in place of
+ * the tangent frame, with the handedness of the bitangent in its `w` component. The shaders reconstruct
+ * the bitangent from these. The tangent takes 8 bits per component, as R8G8B8A8_SNORM is one of the formats
+ * every device supports for vertex buffers, unlike the packed 10-bit ones.
+ */
+struct PackedModelVertex {
+    glm::vec3 pos;
+    uint32_t tex_coord; // R16G16_SFLOAT
+    uint32_t normal;    // R16G16_SNORM
+    uint32_t tangent;   // R8G8B8A8_SNORM
+
+    PackedModelVertex() = default;
+
+    explicit PackedModelVertex(const ModelVertex &vertex);
+
+    static vector<vk::VertexInputBindingDescription> get_binding_descriptions();
+
+    static vector<vk::VertexInputAttributeDescription> get_attribute_descriptions();
+};
+
+static_assert(sizeof(PackedModelVertex) == 24, "packed vertices are read by the vertex fetch, so they can't be padded");
+
+/**
+ * Layout of the vertices in a model's vertex buffer, which has to match the vertex type of the pipelines
+ * drawing the model.
+ */
+enum class VertexFormat {
+    FULL,   // ModelVertex
+    PACKED, // PackedModelVertex
+};
+
+[[nodiscard]] constexpr uint32_t get_vertex_stride(const VertexFormat format) {
+    return format == VertexFormat::PACKED ? sizeof(PackedModelVertex) : sizeof(ModelVertex);
+}
+
 struct SkyboxVertex {
     glm::vec3 pos;
 
@@ -105,15 +136,3 @@ static const vector<ScreenSpaceQuadVertex> screen_space_quad_vertices = {
     {{-1, 1}, {0, 0}},
 };
 } // zrx
-
-// as mentioned above, this is implemented to allow using `Vertex` as a key in an `unordered_map`.
-template<>
-struct std::hash<zrx::ModelVertex> {
-    size_t operator()(zrx::ModelVertex const &vertex) const noexcept {
-        return (hash<glm::vec3>()(vertex.pos) >> 1) ^
-               (hash<glm::vec2>()(vertex.tex_coord) << 1) ^
-               (hash<glm::vec3>()(vertex.normal) << 1) ^
-               (hash<glm::vec3>()(vertex.tangent) << 1) ^
-               (hash<glm::vec3>()(vertex.bitangent) << 1);
-    }
-};
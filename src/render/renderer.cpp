@@ -12,6 +12,9 @@
 #include <filesystem>
 #include <array>
 #include <random>
+#include <limits>
+#include <chrono>
+#include <cmath>
 
 #include "camera.hpp"
 #include "resource-manager.hpp"
@@ -28,10 +31,13 @@
 #include "vk/pipeline.hpp"
 #include "vk/accel-struct.hpp"
 #include "vk/ctx.hpp"
+#include "vk/sync.hpp"
 
 #include <vk-bootstrap/VkBootstrap.h>
 
 #include "src/utils/logger.hpp"
+#include "src/utils/thread-pool.hpp"
+#include "src/utils/hash.hpp"
 
 /**
  * Information held in the fragment shader's uniform buffer.
@@ -103,6 +109,7 @@ VulkanRenderer::VulkanRenderer() {
 
     create_command_pool();
     create_command_buffers();
+    create_recording_workers();
 
     create_descriptor_pool();
 
@@ -194,10 +201,16 @@ vkb::PhysicalDevice VulkanRenderer::pick_physical_device(const vkb::Instance &vk
             .require_present()
             .add_required_extensions(device_extensions)
             .set_required_features(vk::PhysicalDeviceFeatures{
+                .multiDrawIndirect = vk::True,
+                .drawIndirectFirstInstance = vk::True,
                 .fillModeNonSolid = vk::True,
                 .samplerAnisotropy = vk::True,
             })
+            .set_required_features_11(vk::PhysicalDeviceVulkan11Features{
+                .shaderDrawParameters = vk::True,
+            })
             .set_required_features_12(vk::PhysicalDeviceVulkan12Features{
+                .drawIndirectCount = vk::True,
                 .descriptorIndexing = vk::True,
                 .shaderUniformBufferArrayNonUniformIndexing = vk::True,
                 .shaderSampledImageArrayNonUniformIndexing = vk::True,
@@ -230,11 +243,20 @@ vkb::PhysicalDevice VulkanRenderer::pick_physical_device(const vkb::Instance &vk
         Logger::error("failed to select physical device: " + physical_device_result.error().message());
     }
 
-    ctx.physical_device = make_unique<vk::raii::PhysicalDevice>(
-        *instance, physical_device_result.value().physical_device);
+    auto physical_device = physical_device_result.value();
+
+    // mesh shaders are optional, as meshlets can be culled by compute shaders instead
+    mesh_shader_support = physical_device.enable_extension_if_present(VK_EXT_MESH_SHADER_EXTENSION_NAME)
+                          && physical_device.enable_extension_features_if_present(
+                              vk::PhysicalDeviceMeshShaderFeaturesEXT{
+                                  .taskShader = vk::True,
+                                  .meshShader = vk::True,
+                              });
+
+    ctx.physical_device = make_unique<vk::raii::PhysicalDevice>(*instance, physical_device.physical_device);
     msaa_sample_count = get_max_usable_sample_count();
 
-    return physical_device_result.value();
+    return physical_device;
 }
 
 void VulkanRenderer::create_logical_device(const vkb::PhysicalDevice &vkb_physical_device) {
@@ -265,6 +287,17 @@ void VulkanRenderer::create_logical_device(const vkb::PhysicalDevice &vkb_physic
         .graphics_compute_family = graphics_queue_index_result.value(),
         .present_family = present_queue_index_result.value()
     };
+
+    // vk-bootstrap only returns a compute queue from a family separate from the graphics one
+    auto compute_queue_result = device_result.value().get_queue(vkb::QueueType::compute);
+    auto compute_queue_index_result = device_result.value().get_queue_index(vkb::QueueType::compute);
+
+    if (compute_queue_result && compute_queue_index_result) {
+        async_compute_queue = make_unique<vk::raii::Queue>(*ctx.device, compute_queue_result.value());
+        queue_family_indices.async_compute_family = compute_queue_index_result.value();
+    } else {
+        Logger::info("no separate compute queue family available, async compute nodes will run on the graphics queue");
+    }
 }
 
 // ==================== swapchain ====================
@@ -288,6 +321,21 @@ void VulkanRenderer::recreate_swap_chain() {
         window,
         get_msaa_sample_count()
     );
+
+    // the new depth image starts out in an undefined layout
+    image_sync_states.erase(FINAL_IMAGE_RESOURCE_HANDLE);
+
+    if (render_graph_info.render_graph) {
+        render_graph_info.render_graph->mark_resource_changed(FINAL_IMAGE_RESOURCE_HANDLE);
+        resize_render_graph_textures();
+
+        // render infos reference the old swapchain's images, and possibly textures which were just recreated
+        for (auto &level: render_graph_info.node_levels) {
+            for (auto &node_resources: level) {
+                node_resources.render_infos = create_node_render_infos(node_resources.handle);
+            }
+        }
+    }
 }
 
 // ==================== descriptors ====================
@@ -298,6 +346,10 @@ void VulkanRenderer::create_descriptor_pool() {
             .type = vk::DescriptorType::eUniformBuffer,
             .descriptorCount = 100u,
         },
+        {
+            .type = vk::DescriptorType::eUniformBufferDynamic,
+            .descriptorCount = 100u,
+        },
         {
             .type = vk::DescriptorType::eCombinedImageSampler,
             .descriptorCount = 1000u,
@@ -422,18 +474,65 @@ void VulkanRenderer::create_command_pool() {
     };
 
     ctx.command_pool = make_unique<vk::raii::CommandPool>(*ctx.device, pool_info);
+
+    if (queue_family_indices.async_compute_family) {
+        const vk::CommandPoolCreateInfo compute_pool_info{
+            .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+            .queueFamilyIndex = *queue_family_indices.async_compute_family
+        };
+
+        async_compute_command_pool = make_unique<vk::raii::CommandPool>(*ctx.device, compute_pool_info);
+    }
 }
 
 void VulkanRenderer::create_command_buffers() {
     const uint32_t n_buffers = frame_resources.size();
 
+    // most frames need just a single graphics submission, more buffers are allocated when needed
     auto graphics_command_buffers =
             utils::cmd::create_command_buffers(ctx, vk::CommandBufferLevel::ePrimary, n_buffers);
 
     for (size_t i = 0; i < graphics_command_buffers.size(); i++) {
-        frame_resources[i].graphics_cmd_buffer =
-                make_unique<vk::raii::CommandBuffer>(std::move(graphics_command_buffers[i]));
+        frame_resources[i].graphics_cmd_buffers.emplace_back(
+                make_unique<vk::raii::CommandBuffer>(std::move(graphics_command_buffers[i])));
+    }
+}
+
+const vk::raii::CommandBuffer &VulkanRenderer::acquire_primary_command_buffer(const bool is_async_compute) {
+    auto &frame = frame_resources[current_frame_idx];
+    auto &buffers = is_async_compute ? frame.async_compute_cmd_buffers : frame.graphics_cmd_buffers;
+    auto &used_count = is_async_compute
+                           ? submission_state.used_async_compute_cmd_buffers
+                           : submission_state.used_graphics_cmd_buffers;
+
+    if (used_count == buffers.size()) {
+        const auto &pool = is_async_compute ? *async_compute_command_pool : *ctx.command_pool;
+        auto new_buffers = utils::cmd::create_command_buffers(ctx, pool, vk::CommandBufferLevel::ePrimary, 1);
+        buffers.emplace_back(make_unique<vk::raii::CommandBuffer>(std::move(new_buffers[0])));
+    }
+
+    return *buffers[used_count++];
+}
+
+void VulkanRenderer::create_recording_workers() {
+    // leave one core for the main thread, which records barriers in the meantime
+    const size_t worker_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    recording_thread_pool = make_unique<ThreadPool>(worker_count);
+
+    const vk::CommandPoolCreateInfo pool_info{
+        .flags = vk::CommandPoolCreateFlagBits::eTransient,
+        .queueFamilyIndex = queue_family_indices.graphics_compute_family.value()
+    };
+
+    for (auto &res: frame_resources) {
+        res.recording_workers.resize(worker_count);
+
+        for (auto &worker: res.recording_workers) {
+            worker.command_pool = make_unique<vk::raii::CommandPool>(*ctx.device, pool_info);
+        }
     }
+
+    Logger::info("recording render graph commands on ", worker_count, " worker threads");
 }
 
 // ==================== sync ====================
@@ -449,6 +548,11 @@ void VulkanRenderer::create_sync_objects() {
 
     constexpr vk::SemaphoreCreateInfo binary_semaphore_info;
 
+    graphics_queue_timeline.semaphore =
+            make_unique<vk::raii::Semaphore>(*ctx.device, timeline_semaphore_info.get<vk::SemaphoreCreateInfo>());
+    async_compute_queue_timeline.semaphore =
+            make_unique<vk::raii::Semaphore>(*ctx.device, timeline_semaphore_info.get<vk::SemaphoreCreateInfo>());
+
     for (auto &res: frame_resources) {
         res.sync = {
             .image_available_semaphore = make_unique<vk::raii::Semaphore>(*ctx.device, binary_semaphore_info),
@@ -508,6 +612,33 @@ void VulkanRenderer::render_gui_section() {
     constexpr auto section_flags = ImGuiTreeNodeFlags_DefaultOpen;
 
     if (ImGui::CollapsingHeader("Renderer ", section_flags)) {
+        ImGui::Text("Memory saved by aliasing: %.2f MiB", aliasing_saved_bytes / (1024.0 * 1024.0));
+
+        ImGui::Checkbox("Parallel command recording", &use_parallel_recording);
+
+        if (ImGui::TreeNode("Render node statistics")) {
+            RenderPassStats total;
+
+            for (const auto &[handle, stats]: node_stats) {
+                ImGui::Text("%s: %u draws, %u dispatches, %llu triangles",
+                            render_graph_info.render_graph->nodes.at(handle).name.c_str(),
+                            stats.draw_count, stats.dispatch_count,
+                            static_cast<unsigned long long>(stats.triangle_count));
+                ImGui::Text("    binds: %u pipelines, %u descriptor sets, %u buffers, %u skipped as redundant",
+                            stats.pipeline_binds, stats.descriptor_set_binds, stats.buffer_binds,
+                            stats.skipped_binds);
+
+                total += stats;
+            }
+
+            ImGui::Separator();
+            ImGui::Text("Total: %u draws, %llu triangles, %u redundant binds skipped", total.draw_count,
+                        static_cast<unsigned long long>(total.triangle_count), total.skipped_binds);
+            ImGui::Text("Instances culled on the cpu: %u", total.culled_instances);
+
+            ImGui::TreePop();
+        }
+
         static bool use_msaa_dummy = use_msaa;
         if (ImGui::Checkbox("MSAA", &use_msaa_dummy)) {
             queued_frame_begin_actions.emplace([this](const FrameBeginActionContext &fba_ctx) {
@@ -526,34 +657,126 @@ void VulkanRenderer::render_gui_section() {
 // ==================== render graph ====================
 
 void VulkanRenderer::register_render_graph(const RenderGraph &graph) {
+    const auto start_time = std::chrono::high_resolution_clock::now();
+
     render_graph_info.render_graph = make_unique<RenderGraph>(graph);
+    auto &plan = render_graph_info.plan;
+
+    const auto plan_key = get_render_graph_plan_key();
+
+    if (auto cached_plan = RenderGraphPlan::load(RENDER_GRAPH_PLAN_PATH, plan_key)) {
+        plan = std::move(*cached_plan);
+        render_graph_info.is_plan_cached = true;
+    } else {
+        plan = RenderGraphPlan{.key = plan_key};
+    }
+
+    const bool is_plan_cached = render_graph_info.is_plan_cached;
+
+    render_graph_info.render_graph->compile(is_plan_cached ? &plan : nullptr);
+
+    if (!is_plan_cached) {
+        plan = RenderGraphPlan::from_compiled_graph(*render_graph_info.render_graph, plan_key);
+    }
 
     create_render_graph_resources();
 
-    const auto topo_sorted_handles = render_graph_info.render_graph->get_topo_sorted();
-    const uint32_t n_nodes = topo_sorted_handles.size();
+    for (const auto &level: render_graph_info.render_graph->get_topo_levels()) {
+        auto &level_resources = render_graph_info.node_levels.emplace_back();
 
-    for (uint32_t i = 0; i < n_nodes; i++) {
-        const auto node_handle = topo_sorted_handles[i];
-        auto render_infos = create_node_render_infos(node_handle);
+        for (const auto node_handle: level) {
+            auto render_infos = create_node_render_infos(node_handle);
 
-        render_graph_info.topo_sorted_nodes.emplace_back(RenderNodeResources{
-            .handle = node_handle,
-            .render_infos = std::move(render_infos),
-        });
+            if (!is_plan_cached) {
+                plan.node_schedules.emplace(node_handle, RenderGraphPlan::NodeSchedule{
+                    .image_accesses = create_node_image_accesses(node_handle),
+                    .buffer_accesses = create_node_buffer_accesses(node_handle),
+                });
+            }
+
+            const auto &schedule = plan.node_schedules.at(node_handle);
+
+            level_resources.emplace_back(RenderNodeResources{
+                .handle = node_handle,
+                .render_infos = std::move(render_infos),
+                .image_accesses = schedule.image_accesses,
+                .buffer_accesses = schedule.buffer_accesses,
+            });
+        }
     }
 
+    if (!is_plan_cached) plan.save(RENDER_GRAPH_PLAN_PATH);
+
     repeated_frame_begin_actions = render_graph_info.render_graph->frame_begin_callbacks;
+
+    const auto end_time = std::chrono::high_resolution_clock::now();
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+
+    Logger::info("registered render graph in ", micros / 1000.0, " ms, ",
+                 is_plan_cached ? "reusing the cached plan" : "building and caching a new plan");
+}
+
+std::uint64_t VulkanRenderer::get_render_graph_plan_key() const {
+    const auto properties = ctx.physical_device->getProperties();
+
+    return Hasher()
+            .add(render_graph_info.render_graph->hash_description())
+            .add(properties.vendorID)
+            .add(properties.deviceID)
+            .add(properties.driverVersion)
+            .get();
 }
 
 void VulkanRenderer::create_render_graph_resources() {
+    const auto &graph = *render_graph_info.render_graph;
+
+    // resources used on both queues are shared concurrently, so that they never need ownership transfers
+    const auto async_compute_resources = graph.get_async_compute_resources();
+    const auto sharing_families = get_async_compute_sharing_families();
+
+    const auto get_sharing_families = [&](const ResourceHandle handle) {
+        return async_compute_resources.contains(handle) ? sharing_families : vector<uint32_t>{};
+    };
+
+    std::set<ResourceHandle> storage_resources;
+    for (const auto &[handle, node]: graph.nodes) {
+        storage_resources.insert(node.storage_targets.begin(), node.storage_targets.end());
+        storage_resources.insert(node.storage_inputs.begin(), node.storage_inputs.end());
+    }
+
+    const auto get_storage_usage = [&](const ResourceHandle handle) {
+        return storage_resources.contains(handle) ? vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlags{};
+    };
+
     for (const auto &[handle, description]: render_graph_info.render_graph->model_resources) {
-        auto model = make_unique<Model>(ctx, description.path, false);
+        auto model = make_unique<Model>(ctx, description.path, false, description.vertex_format,
+                                        description.use_importer_cache_optimization);
         resource_manager->add(handle, std::move(model));
     }
 
     for (const auto &[handle, description]: render_graph_info.render_graph->uniform_buffers) {
-        resource_manager->add(handle, utils::buf::create_uniform_buffer(ctx, description.size));
+        // one slice per frame in flight, so that a frame's uniforms can be written while earlier frames still run
+        const auto slice_size = utils::buf::get_uniform_slice_size(ctx, description.size);
+
+        resource_manager->add(handle, utils::buf::create_uniform_buffer(ctx, slice_size * MAX_FRAMES_IN_FLIGHT,
+                                                                         get_sharing_families(handle)));
+        resource_manager->set_buffer_slice_size(handle, slice_size);
+    }
+
+    for (const auto &[handle, description]: render_graph_info.render_graph->storage_buffers) {
+        resource_manager->add(handle, make_unique<Buffer>(
+            **ctx.allocator,
+            description.size,
+            vk::BufferUsageFlagBits::eStorageBuffer
+            | vk::BufferUsageFlagBits::eIndirectBuffer
+            | vk::BufferUsageFlagBits::eVertexBuffer
+            | vk::BufferUsageFlagBits::eIndexBuffer
+            | vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal,
+            get_sharing_families(handle)
+        ));
+
+        buffer_sync_states.emplace(handle, BufferSyncState());
     }
 
     for (const auto &[handle, description]: render_graph_info.render_graph->external_tex_resources) {
@@ -564,7 +787,8 @@ void VulkanRenderer::create_render_graph_resources() {
                 .use_usage(vk::ImageUsageFlagBits::eTransferSrc
                            | vk::ImageUsageFlagBits::eTransferDst
                            | vk::ImageUsageFlagBits::eSampled
-                           | utils::img::get_format_attachment_type(description.format));
+                           | utils::img::get_format_attachment_type(description.format))
+                .shared_between(get_sharing_families(handle));
 
         if (description.paths.size() > 1 && !(description.tex_flags & vk::TextureFlagBitsZRX::CUBEMAP))
             builder.as_separate_channels();
@@ -572,12 +796,14 @@ void VulkanRenderer::create_render_graph_resources() {
             builder.with_swizzle(*description.swizzle);
 
         resource_manager->add(handle, builder.create(ctx));
+        image_sync_states.emplace(handle, ImageSyncState(vk::ImageLayout::eShaderReadOnlyOptimal));
     }
 
+    // textures are created only after all of them are described, so that they can share memory
     for (const auto &[handle, description]: render_graph_info.render_graph->empty_tex_resources) {
         auto extent = description.extent;
         if (extent.width == 0 && extent.height == 0) {
-            extent = swap_chain->get_extent();
+            extent = get_swapchain_relative_extent(description.resolution_scale);
         }
 
         auto builder = TextureBuilder()
@@ -587,46 +813,352 @@ void VulkanRenderer::create_render_graph_resources() {
                 .use_usage(vk::ImageUsageFlagBits::eTransferSrc
                            | vk::ImageUsageFlagBits::eTransferDst
                            | vk::ImageUsageFlagBits::eSampled
-                           | utils::img::get_format_attachment_type(description.format));
+                           | get_storage_usage(handle)
+                           | utils::img::get_format_attachment_type(description.format))
+                .shared_between(get_sharing_families(handle));
 
-        resource_manager->add(handle, builder.create(ctx));
+        graph_texture_builders.emplace(handle, builder);
+        graph_texture_layouts.emplace(handle, vk::ImageLayout::eShaderReadOnlyOptimal);
     }
 
     for (const auto &[handle, description]: render_graph_info.render_graph->transient_tex_resources) {
         auto extent = description.extent;
         if (extent.width == 0 && extent.height == 0) {
-            extent = swap_chain->get_extent();
+            extent = get_swapchain_relative_extent(description.resolution_scale);
         }
 
         auto builder = TextureBuilder()
                 .with_flags(description.tex_flags)
                 .as_uninitialized({extent.width, extent.height, 1u})
                 .use_format(description.format)
+                .use_layout(vk::ImageLayout::eGeneral) // transient images can't be in a read-only layout
                 .use_usage(vk::ImageUsageFlagBits::eTransientAttachment
                            | utils::img::get_format_attachment_type(description.format));
 
+        graph_texture_builders.emplace(handle, builder);
+        graph_texture_layouts.emplace(handle, vk::ImageLayout::eGeneral);
+    }
+
+    assign_aliased_memory(graph_texture_builders);
+
+    for (const auto &[handle, builder]: graph_texture_builders) {
         resource_manager->add(handle, builder.create(ctx));
+
+        // aliased textures have undefined contents whenever they take over their memory block
+        image_sync_states.emplace(handle, aliased_texture_blocks.contains(handle)
+                                              ? ImageSyncState()
+                                              : ImageSyncState(graph_texture_layouts.at(handle)));
     }
 
     for (const auto &[handle, description]: render_graph_info.render_graph->pipelines) {
         auto descriptor_sets = create_graph_descriptor_sets(handle);
         auto builder = create_graph_pipeline_builder(handle, descriptor_sets);
+        builder.with_push_constants(get_graph_push_constant_ranges(handle));
         render_graph_pipelines.emplace(handle, builder.create(ctx));
         pipeline_desc_sets.emplace(handle, std::move(descriptor_sets));
     }
+
+    for (const auto &[handle, description]: render_graph_info.render_graph->compute_pipelines) {
+        auto descriptor_sets = create_graph_descriptor_sets(handle);
+
+        vector<vk::DescriptorSetLayout> descriptor_set_layouts;
+        for (const auto &set: descriptor_sets) {
+            descriptor_set_layouts.emplace_back(*set.get_layout());
+        }
+
+        auto pipeline = ComputePipelineBuilder()
+                .with_compute_shader(description.compute_path)
+                .with_descriptor_layouts(descriptor_set_layouts)
+                .with_push_constants(get_graph_push_constant_ranges(handle))
+                .create(ctx);
+
+        render_graph_compute_pipelines.emplace(handle, std::move(pipeline));
+        pipeline_desc_sets.emplace(handle, std::move(descriptor_sets));
+    }
+}
+
+void VulkanRenderer::assign_aliased_memory(std::map<ResourceHandle, TextureBuilder> &builders) {
+    auto &plan = render_graph_info.plan;
+
+    if (!render_graph_info.is_plan_cached) {
+        plan.alias_blocks = plan_aliased_memory_blocks(builders);
+    }
+
+    vk::DeviceSize separate_size = 0;
+    vk::DeviceSize aliased_size = 0;
+
+    for (const auto &block_textures: plan.alias_blocks) {
+        for (const auto handle: block_textures) {
+            separate_size += builders.at(handle).get_memory_requirements(ctx).size;
+        }
+
+        const auto memory = make_shared<ImageMemoryBlock>(ctx, get_alias_block_requirements(block_textures, builders));
+        aliased_size += memory->get_size();
+
+        for (const auto handle: block_textures) {
+            builders.at(handle).with_aliased_memory(memory);
+            aliased_texture_blocks.emplace(handle, alias_block_occupants.size());
+        }
+
+        alias_block_occupants.emplace_back();
+    }
+
+    aliasing_saved_bytes = separate_size - aliased_size;
+
+    Logger::info("render graph memory aliasing: ", aliased_texture_blocks.size(), " textures in ",
+                 alias_block_occupants.size(), " blocks, saved ", aliasing_saved_bytes / (1024.0 * 1024.0), " MiB");
+}
+
+vk::MemoryRequirements VulkanRenderer::get_alias_block_requirements(
+    const vector<ResourceHandle> &block_textures,
+    const std::map<ResourceHandle, TextureBuilder> &builders
+) const {
+    vk::MemoryRequirements block_requirements{
+        .memoryTypeBits = std::numeric_limits<uint32_t>::max(),
+    };
+
+    for (const auto handle: block_textures) {
+        const auto requirements = builders.at(handle).get_memory_requirements(ctx);
+
+        block_requirements.size = std::max(block_requirements.size, requirements.size);
+        block_requirements.alignment = std::max(block_requirements.alignment, requirements.alignment);
+        block_requirements.memoryTypeBits &= requirements.memoryTypeBits;
+    }
+
+    return block_requirements;
+}
+
+vector<vector<ResourceHandle> >
+VulkanRenderer::plan_aliased_memory_blocks(const std::map<ResourceHandle, TextureBuilder> &builders) const {
+    struct AliasedTexture {
+        ResourceHandle handle;
+        RenderGraph::ResourceLifetime lifetime;
+        vk::MemoryRequirements requirements;
+    };
+
+    struct MemoryBlockDescription {
+        vk::MemoryRequirements requirements;
+        size_t last_level;
+        vector<ResourceHandle> textures;
+    };
+
+    vector<AliasedTexture> textures;
+
+    for (const auto &[handle, lifetime]: render_graph_info.render_graph->aliasable_lifetimes) {
+        textures.emplace_back(AliasedTexture{
+            .handle = handle,
+            .lifetime = lifetime,
+            .requirements = builders.at(handle).get_memory_requirements(ctx),
+        });
+    }
+
+    // textures are placed in the order of their first use, and bigger ones go first so that they create
+    // the blocks, instead of growing blocks created for smaller textures
+    std::ranges::sort(textures, [](const AliasedTexture &a, const AliasedTexture &b) {
+        if (a.lifetime.first_level != b.lifetime.first_level) return a.lifetime.first_level < b.lifetime.first_level;
+        return a.requirements.size > b.requirements.size;
+    });
+
+    vector<MemoryBlockDescription> blocks;
+
+    // greedy interval coloring: place each texture in the block which is already free by the time
+    // the texture is first used and which would need to grow the least
+    for (const auto &[handle, lifetime, requirements]: textures) {
+        std::optional<size_t> best_block;
+        vk::DeviceSize best_growth = std::numeric_limits<vk::DeviceSize>::max();
+
+        for (size_t i = 0; i < blocks.size(); i++) {
+            const auto &block = blocks[i];
+            if (block.last_level >= lifetime.first_level) continue;
+            if (!(block.requirements.memoryTypeBits & requirements.memoryTypeBits)) continue;
+
+            const auto growth = requirements.size > block.requirements.size
+                                    ? requirements.size - block.requirements.size
+                                    : 0;
+
+            if (growth < best_growth) {
+                best_block  = i;
+                best_growth = growth;
+            }
+        }
+
+        if (!best_block) {
+            blocks.emplace_back(MemoryBlockDescription{
+                .requirements = requirements,
+                .last_level = lifetime.last_level,
+                .textures = {handle},
+            });
+            continue;
+        }
+
+        auto &block = blocks[*best_block];
+        block.requirements.size = std::max(block.requirements.size, requirements.size);
+        block.requirements.alignment = std::max(block.requirements.alignment, requirements.alignment);
+        block.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        block.last_level = lifetime.last_level;
+        block.textures.push_back(handle);
+    }
+
+    vector<vector<ResourceHandle> > result;
+
+    // textures which didn't end up sharing memory with anything keep their dedicated allocations
+    for (auto &block: blocks) {
+        if (block.textures.size() > 1) result.emplace_back(std::move(block.textures));
+    }
+
+    return result;
+}
+
+vk::Extent2D VulkanRenderer::get_swapchain_relative_extent(const float scale) const {
+    const auto extent = swap_chain->get_extent();
+
+    return {
+        std::max(1u, static_cast<uint32_t>(std::round(static_cast<float>(extent.width) * scale))),
+        std::max(1u, static_cast<uint32_t>(std::round(static_cast<float>(extent.height) * scale))),
+    };
+}
+
+std::map<ResourceHandle, float> VulkanRenderer::get_swapchain_relative_textures() const {
+    const auto &graph = *render_graph_info.render_graph;
+    std::map<ResourceHandle, float> result;
+
+    for (const auto &[handle, description]: graph.empty_tex_resources) {
+        if (description.extent.width == 0 && description.extent.height == 0) {
+            result.emplace(handle, description.resolution_scale);
+        }
+    }
+
+    for (const auto &[handle, description]: graph.transient_tex_resources) {
+        if (description.extent.width == 0 && description.extent.height == 0) {
+            result.emplace(handle, description.resolution_scale);
+        }
+    }
+
+    return result;
+}
+
+void VulkanRenderer::resize_render_graph_textures() {
+    std::set<ResourceHandle> grown_textures;
+
+    for (const auto &[handle, scale]: get_swapchain_relative_textures()) {
+        const auto new_extent = get_swapchain_relative_extent(scale);
+        const auto current_extent = resource_manager->get_texture(handle).get_image().get_extent_2d();
+
+        // textures which are big enough are kept, and only a part of them is rendered to from now on
+        if (new_extent.width > current_extent.width || new_extent.height > current_extent.height) {
+            // growing to the bigger of the two extents in each dimension avoids reallocating
+            // again when the window is later resized along the other dimension
+            graph_texture_builders.at(handle).as_uninitialized({
+                std::max(new_extent.width, current_extent.width),
+                std::max(new_extent.height, current_extent.height),
+                1u
+            });
+
+            grown_textures.insert(handle);
+        }
+
+        resource_manager->set_render_extent(handle, new_extent);
+        render_graph_info.render_graph->mark_resource_changed(handle);
+    }
+
+    if (grown_textures.empty()) return;
+
+    // a grown texture might no longer fit in its memory block, so the whole block is reallocated,
+    // which in turn requires recreating the other textures placed in it
+    std::set<ResourceHandle> recreated_textures = grown_textures;
+
+    for (const auto &block_textures: render_graph_info.plan.alias_blocks) {
+        const bool is_block_grown = std::ranges::any_of(block_textures, [&](const ResourceHandle handle) {
+            return grown_textures.contains(handle);
+        });
+
+        if (!is_block_grown) continue;
+
+        const auto memory = make_shared<ImageMemoryBlock>(
+            ctx, get_alias_block_requirements(block_textures, graph_texture_builders));
+
+        for (const auto handle: block_textures) {
+            graph_texture_builders.at(handle).with_aliased_memory(memory);
+            recreated_textures.insert(handle);
+        }
+    }
+
+    for (const auto handle: recreated_textures) {
+        resource_manager->replace(handle, graph_texture_builders.at(handle).create(ctx));
+
+        image_sync_states.at(handle) = aliased_texture_blocks.contains(handle)
+                                           ? ImageSyncState()
+                                           : ImageSyncState(graph_texture_layouts.at(handle));
+
+        render_graph_info.render_graph->mark_resource_changed(handle);
+    }
+
+    // the new memory blocks have no occupants yet
+    for (auto &occupant: alias_block_occupants) {
+        if (occupant && recreated_textures.contains(*occupant)) occupant.reset();
+    }
+
+    update_graph_descriptor_sets(recreated_textures);
+
+    Logger::info("reallocated ", recreated_textures.size(), " render graph textures after the swapchain grew");
+}
+
+void VulkanRenderer::update_graph_descriptor_sets(const std::set<ResourceHandle> &changed_resources) {
+    const auto &graph = *render_graph_info.render_graph;
+
+    for (auto &[pipeline_handle, descriptor_sets]: pipeline_desc_sets) {
+        const auto &set_descs = graph.compute_pipelines.contains(pipeline_handle)
+                                    ? graph.compute_pipelines.at(pipeline_handle).descriptor_set_descs
+                                    : graph.pipelines.at(pipeline_handle).descriptor_set_descs;
+        const auto &reflected_layout = render_graph_info.plan.pipeline_layouts.at(pipeline_handle);
+
+        for (size_t i = 0; i < set_descs.size(); i++) {
+            auto &descriptor_set = descriptor_sets[i];
+            bool is_set_changed = false;
+
+            for (uint32_t binding = 0; binding < set_descs[i].size(); binding++) {
+                const auto &binding_desc = set_descs[i][binding];
+                const auto type = reflected_layout[i][binding].type;
+
+                if (std::holds_alternative<ResourceHandle>(binding_desc)) {
+                    const auto res_handle = std::get<ResourceHandle>(binding_desc);
+                    if (!changed_resources.contains(res_handle)) continue;
+
+                    queue_set_update_with_handle(descriptor_set, res_handle, binding, type);
+                    is_set_changed = true;
+                } else if (std::holds_alternative<ResourceHandleArray>(binding_desc)) {
+                    const auto &res_handles = std::get<ResourceHandleArray>(binding_desc);
+
+                    for (uint32_t array_element = 0; array_element < res_handles.size(); array_element++) {
+                        if (!changed_resources.contains(res_handles[array_element])) continue;
+
+                        queue_set_update_with_handle(descriptor_set, res_handles[array_element], binding, type,
+                                                     array_element);
+                        is_set_changed = true;
+                    }
+                }
+            }
+
+            if (is_set_changed) descriptor_set.commit_updates(ctx);
+        }
+    }
 }
 
 vector<DescriptorSet>
-VulkanRenderer::create_graph_descriptor_sets(const ResourceHandle pipeline_handle) const {
-    const auto &pipeline_info = render_graph_info.render_graph->pipelines.at(pipeline_handle);
-    const auto &set_descs = pipeline_info.descriptor_set_descs;
+VulkanRenderer::create_graph_descriptor_sets(const ResourceHandle pipeline_handle) {
+    const auto &graph = *render_graph_info.render_graph;
+    auto &plan = render_graph_info.plan;
+    const auto &set_descs = graph.compute_pipelines.contains(pipeline_handle)
+                                ? graph.compute_pipelines.at(pipeline_handle).descriptor_set_descs
+                                : graph.pipelines.at(pipeline_handle).descriptor_set_descs;
     vector<DescriptorSet> descriptor_sets;
 
-    const SpirvReflectModuleWrapper vert_spv_module { pipeline_info.vertex_path };
-    const SpirvReflectModuleWrapper frag_spv_module { pipeline_info.fragment_path };
+    if (!render_graph_info.is_plan_cached) {
+        plan.pipeline_layouts.emplace(pipeline_handle, reflect_pipeline_layout(pipeline_handle));
+    }
 
-    const auto reflected_vert_bindings = vert_spv_module.descriptor_bindings();
-    const auto reflected_frag_bindings = frag_spv_module.descriptor_bindings();
+    const auto &reflected_layout = plan.pipeline_layouts.at(pipeline_handle);
+    auto &dynamic_slice_sizes = pipeline_dynamic_slice_sizes[pipeline_handle];
 
     for (size_t set_idx = 0; set_idx < set_descs.size(); set_idx++) {
         const auto &set_desc = set_descs[set_idx];
@@ -635,48 +1167,23 @@ VulkanRenderer::create_graph_descriptor_sets(const ResourceHandle pipeline_handl
         for (size_t binding_idx = 0; binding_idx < set_desc.size(); binding_idx++) {
             if (std::holds_alternative<std::monostate>(set_desc[binding_idx])) continue;
 
-            bool is_ubo_descriptor = false;
-            bool is_tex_descriptor = false;
-            vk::DescriptorType type{};
-            vk::ShaderStageFlags stages{};
+            const auto &[type, stages] = reflected_layout[set_idx][binding_idx];
             uint32_t descriptor_count = 1;
+            ResourceHandleArray res_handles;
 
             if (std::holds_alternative<ResourceHandle>(set_desc[binding_idx])) {
-                const auto res_handle = std::get<ResourceHandle>(set_desc[binding_idx]);
-                is_ubo_descriptor = resource_manager->contains_buffer(res_handle);
-                is_tex_descriptor = resource_manager->contains_texture(res_handle);
+                res_handles = {std::get<ResourceHandle>(set_desc[binding_idx])};
             } else if (std::holds_alternative<ResourceHandleArray>(set_desc[binding_idx])) {
-                const auto &res_handles = std::get<ResourceHandleArray>(set_desc[binding_idx]);
-                is_ubo_descriptor = std::ranges::any_of(res_handles, [&](auto res_handle) {
-                    return resource_manager->contains_buffer(res_handle);
-                });
-                is_tex_descriptor = std::ranges::any_of(res_handles, [&](auto res_handle) {
-                    return resource_manager->contains_texture(res_handle);
-                });
+                res_handles = std::get<ResourceHandleArray>(set_desc[binding_idx]);
                 descriptor_count = res_handles.size();
             }
 
-            if (is_ubo_descriptor && is_tex_descriptor) {
-                Logger::error("ambiguous resource handle type");
-            }
-            if (is_ubo_descriptor) {
-                type = vk::DescriptorType::eUniformBuffer;
-            } else if (is_tex_descriptor) {
-                type = vk::DescriptorType::eCombinedImageSampler;
-            } else {
-                Logger::error("unknown resource handle");
-            }
-
-            const auto matching_binding_fn = [&](const SpvReflectDescriptorBinding* binding) {
-                return binding->set == set_idx && binding->binding == binding_idx;
-            };
-
-            if (std::ranges::find_if(reflected_vert_bindings, matching_binding_fn) != reflected_vert_bindings.end()) {
-                stages |= vk::ShaderStageFlagBits::eVertex;
-            }
+            for (const auto res_handle: res_handles) {
+                pipeline_resource_stages[pipeline_handle][res_handle] |= stages;
 
-            if (std::ranges::find_if(reflected_frag_bindings, matching_binding_fn) != reflected_frag_bindings.end()) {
-                stages |= vk::ShaderStageFlagBits::eFragment;
+                if (type == vk::DescriptorType::eUniformBufferDynamic) {
+                    dynamic_slice_sizes.push_back(*resource_manager->get_buffer_slice_size(res_handle));
+                }
             }
 
             builder.add_binding(type, stages, descriptor_count);
@@ -692,13 +1199,16 @@ VulkanRenderer::create_graph_descriptor_sets(const ResourceHandle pipeline_handl
         auto &descriptor_set = descriptor_sets[i];
 
         for (uint32_t binding = 0; binding < set_desc.size(); binding++) {
+            const auto type = reflected_layout[i][binding].type;
+
             if (std::holds_alternative<ResourceHandle>(set_desc[binding])) {
                 const auto res_handle = std::get<ResourceHandle>(set_desc[binding]);
-                queue_set_update_with_handle(descriptor_set, res_handle, binding);
+                queue_set_update_with_handle(descriptor_set, res_handle, binding, type);
             } else if (std::holds_alternative<ResourceHandleArray>(set_desc[binding])) {
                 const auto &res_handles = std::get<ResourceHandleArray>(set_desc[binding]);
                 for (uint32_t array_element = 0; array_element < res_handles.size(); array_element++) {
-                    queue_set_update_with_handle(descriptor_set, res_handles[array_element], binding, array_element);
+                    queue_set_update_with_handle(descriptor_set, res_handles[array_element], binding, type,
+                                                 array_element);
                 }
             }
         }
@@ -709,46 +1219,205 @@ VulkanRenderer::create_graph_descriptor_sets(const ResourceHandle pipeline_handl
     return descriptor_sets;
 }
 
-GraphicsPipelineBuilder
-VulkanRenderer::create_graph_pipeline_builder(const ResourceHandle pipeline_handle,
-                                              const vector<DescriptorSet> &descriptor_sets) const {
-    const auto &pipeline_info = render_graph_info.render_graph->pipelines.at(pipeline_handle);
+vector<std::pair<unique_ptr<SpirvReflectModuleWrapper>, vk::ShaderStageFlagBits> >
+VulkanRenderer::load_pipeline_spv_modules(const ResourceHandle pipeline_handle) const {
+    const auto &graph = *render_graph_info.render_graph;
+    vector<std::pair<unique_ptr<SpirvReflectModuleWrapper>, vk::ShaderStageFlagBits> > spv_modules;
 
-    vector<vk::Format> color_formats;
-    for (const auto &format_variant: pipeline_info.color_formats) {
-        const vk::Format format = std::holds_alternative<vk::Format>(format_variant)
-                                    ? std::get<vk::Format>(format_variant)
-                                    : swap_chain->get_image_format();
-        color_formats.push_back(format);
+    if (graph.compute_pipelines.contains(pipeline_handle)) {
+        const auto &pipeline_info = graph.compute_pipelines.at(pipeline_handle);
+        spv_modules.emplace_back(make_unique<SpirvReflectModuleWrapper>(pipeline_info.compute_path),
+                                 vk::ShaderStageFlagBits::eCompute);
+    } else {
+        const auto &pipeline_info = graph.pipelines.at(pipeline_handle);
+
+        if (pipeline_info.uses_mesh_shaders()) {
+            if (!pipeline_info.task_path.empty()) {
+                spv_modules.emplace_back(make_unique<SpirvReflectModuleWrapper>(pipeline_info.task_path),
+                                         vk::ShaderStageFlagBits::eTaskEXT);
+            }
+
+            spv_modules.emplace_back(make_unique<SpirvReflectModuleWrapper>(pipeline_info.mesh_path),
+                                     vk::ShaderStageFlagBits::eMeshEXT);
+        } else {
+            spv_modules.emplace_back(make_unique<SpirvReflectModuleWrapper>(pipeline_info.vertex_path),
+                                     vk::ShaderStageFlagBits::eVertex);
+        }
+
+        spv_modules.emplace_back(make_unique<SpirvReflectModuleWrapper>(pipeline_info.fragment_path),
+                                 vk::ShaderStageFlagBits::eFragment);
     }
 
-    vector<vk::DescriptorSetLayout> descriptor_set_layouts;
-    for (const auto &set: descriptor_sets) {
-        descriptor_set_layouts.emplace_back(*set.get_layout());
+    return spv_modules;
+}
+
+std::optional<vk::PushConstantRange>
+VulkanRenderer::reflect_push_constant_range(const ResourceHandle pipeline_handle) const {
+    std::optional<vk::PushConstantRange> result;
+
+    // a single range spanning the blocks of every stage, so that any part of it can be pushed to all the stages
+    for (const auto &[spv_module, stage]: load_pipeline_spv_modules(pipeline_handle)) {
+        for (const auto *block: spv_module->push_constant_blocks()) {
+            if (!result) {
+                result = vk::PushConstantRange{
+                    .stageFlags = stage,
+                    .offset = block->offset,
+                    .size = block->size,
+                };
+                continue;
+            }
+
+            const auto end = std::max(result->offset + result->size, block->offset + block->size);
+            result->stageFlags |= stage;
+            result->offset = std::min(result->offset, block->offset);
+            result->size = end - result->offset;
+        }
     }
 
-    auto builder = GraphicsPipelineBuilder()
-            .with_vertex_shader(pipeline_info.vertex_path)
-            .with_fragment_shader(pipeline_info.fragment_path)
-            .with_vertices(
-                pipeline_info.binding_descriptions,
-                pipeline_info.attribute_descriptions
-            )
-            .with_rasterizer({
-                .polygonMode = vk::PolygonMode::eFill,
-                .cullMode = pipeline_info.custom_properties.cull_mode,
-                .frontFace = vk::FrontFace::eCounterClockwise,
-                .lineWidth = 1.0f,
-            })
-            .with_multisampling({
-                .rasterizationSamples = pipeline_info.custom_properties.use_msaa
-                                        ? get_msaa_sample_count()
+    return result;
+}
+
+vector<vk::PushConstantRange> VulkanRenderer::get_graph_push_constant_ranges(const ResourceHandle pipeline_handle) {
+    auto &plan = render_graph_info.plan;
+
+    if (!render_graph_info.is_plan_cached) {
+        if (const auto range = reflect_push_constant_range(pipeline_handle)) {
+            plan.push_constant_ranges.emplace(pipeline_handle, *range);
+        }
+    }
+
+    const auto it = plan.push_constant_ranges.find(pipeline_handle);
+    return it != plan.push_constant_ranges.end() ? vector{it->second} : vector<vk::PushConstantRange>{};
+}
+
+RenderGraphPlan::ReflectedLayout VulkanRenderer::reflect_pipeline_layout(const ResourceHandle pipeline_handle) const {
+    const auto &graph = *render_graph_info.render_graph;
+    const auto &set_descs = graph.compute_pipelines.contains(pipeline_handle)
+                                ? graph.compute_pipelines.at(pipeline_handle).descriptor_set_descs
+                                : graph.pipelines.at(pipeline_handle).descriptor_set_descs;
+
+    const auto spv_modules = load_pipeline_spv_modules(pipeline_handle);
+
+    vector<std::pair<vector<SpvReflectDescriptorBinding *>, vk::ShaderStageFlagBits> > reflected_bindings;
+    for (const auto &[spv_module, stage]: spv_modules) {
+        reflected_bindings.emplace_back(spv_module->descriptor_bindings(), stage);
+    }
+
+    RenderGraphPlan::ReflectedLayout layout(set_descs.size());
+
+    for (size_t set_idx = 0; set_idx < set_descs.size(); set_idx++) {
+        const auto &set_desc = set_descs[set_idx];
+
+        layout[set_idx].resize(set_desc.size());
+
+        for (size_t binding_idx = 0; binding_idx < set_desc.size(); binding_idx++) {
+            if (std::holds_alternative<std::monostate>(set_desc[binding_idx])) continue;
+
+            bool is_buffer_descriptor = false;
+            bool is_tex_descriptor = false;
+            auto &[type, stages] = layout[set_idx][binding_idx];
+
+            if (std::holds_alternative<ResourceHandle>(set_desc[binding_idx])) {
+                const auto res_handle = std::get<ResourceHandle>(set_desc[binding_idx]);
+                is_buffer_descriptor = resource_manager->contains_buffer(res_handle);
+                is_tex_descriptor = resource_manager->contains_texture(res_handle);
+            } else if (std::holds_alternative<ResourceHandleArray>(set_desc[binding_idx])) {
+                const auto &res_handles = std::get<ResourceHandleArray>(set_desc[binding_idx]);
+                is_buffer_descriptor = std::ranges::any_of(res_handles, [&](auto res_handle) {
+                    return resource_manager->contains_buffer(res_handle);
+                });
+                is_tex_descriptor = std::ranges::any_of(res_handles, [&](auto res_handle) {
+                    return resource_manager->contains_texture(res_handle);
+                });
+            }
+
+            const auto matching_binding_fn = [&](const SpvReflectDescriptorBinding* binding) {
+                return binding->set == set_idx && binding->binding == binding_idx;
+            };
+
+            bool is_storage_descriptor = false;
+
+            for (const auto &[bindings, stage]: reflected_bindings) {
+                const auto binding_it = std::ranges::find_if(bindings, matching_binding_fn);
+                if (binding_it == bindings.end()) continue;
+
+                const auto descriptor_type = (*binding_it)->descriptor_type;
+
+                stages |= stage;
+                is_storage_descriptor |= descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                                         || descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            }
+
+            if (is_buffer_descriptor && is_tex_descriptor) {
+                Logger::error("ambiguous resource handle type");
+            }
+            if (is_buffer_descriptor) {
+                type = is_storage_descriptor
+                           ? vk::DescriptorType::eStorageBuffer
+                           : vk::DescriptorType::eUniformBufferDynamic;
+            } else if (is_tex_descriptor) {
+                type = is_storage_descriptor
+                           ? vk::DescriptorType::eStorageImage
+                           : vk::DescriptorType::eCombinedImageSampler;
+            } else {
+                Logger::error("unknown resource handle");
+            }
+        }
+    }
+
+    return layout;
+}
+
+GraphicsPipelineBuilder
+VulkanRenderer::create_graph_pipeline_builder(const ResourceHandle pipeline_handle,
+                                              const vector<DescriptorSet> &descriptor_sets) const {
+    const auto &pipeline_info = render_graph_info.render_graph->pipelines.at(pipeline_handle);
+
+    vector<vk::Format> color_formats;
+    for (const auto &format_variant: pipeline_info.color_formats) {
+        const vk::Format format = std::holds_alternative<vk::Format>(format_variant)
+                                    ? std::get<vk::Format>(format_variant)
+                                    : swap_chain->get_image_format();
+        color_formats.push_back(format);
+    }
+
+    vector<vk::DescriptorSetLayout> descriptor_set_layouts;
+    for (const auto &set: descriptor_sets) {
+        descriptor_set_layouts.emplace_back(*set.get_layout());
+    }
+
+    auto builder = GraphicsPipelineBuilder()
+            .with_fragment_shader(pipeline_info.fragment_path)
+            .with_rasterizer({
+                .polygonMode = vk::PolygonMode::eFill,
+                .cullMode = pipeline_info.custom_properties.cull_mode,
+                .frontFace = vk::FrontFace::eCounterClockwise,
+                .lineWidth = 1.0f,
+            })
+            .with_multisampling({
+                .rasterizationSamples = pipeline_info.custom_properties.use_msaa
+                                        ? get_msaa_sample_count()
                                         : vk::SampleCountFlagBits::e1,
                 .minSampleShading = 1.0f,
             })
             .with_descriptor_layouts(descriptor_set_layouts)
             .with_color_formats(color_formats);
 
+    if (pipeline_info.uses_mesh_shaders()) {
+        if (!supports_mesh_shaders()) {
+            Logger::error("pipelines with mesh shaders need a device supporting VK_EXT_mesh_shader!");
+        }
+
+        builder.with_mesh_shader(pipeline_info.mesh_path);
+
+        if (!pipeline_info.task_path.empty()) {
+            builder.with_task_shader(pipeline_info.task_path);
+        }
+    } else {
+        builder.with_vertex_shader(pipeline_info.vertex_path)
+                .with_vertices(pipeline_info.binding_descriptions, pipeline_info.attribute_descriptions);
+    }
+
     if (pipeline_info.depth_format) {
         const vk::Format format = std::holds_alternative<vk::Format>(*pipeline_info.depth_format)
                                     ? std::get<vk::Format>(*pipeline_info.depth_format)
@@ -769,17 +1438,21 @@ VulkanRenderer::create_graph_pipeline_builder(const ResourceHandle pipeline_hand
 }
 
 void VulkanRenderer::queue_set_update_with_handle(DescriptorSet &descriptor_set, const ResourceHandle res_handle,
-                                                  const uint32_t binding, const uint32_t array_element) const {
+                                                  const uint32_t binding, const vk::DescriptorType type,
+                                                  const uint32_t array_element) const {
     if (resource_manager->contains_buffer(res_handle)) {
         const auto &buffer = resource_manager->get_buffer(res_handle);
         descriptor_set.queue_update(
             binding,
             buffer,
-            vk::DescriptorType::eUniformBuffer,
-            buffer.get_size(),
+            type,
+            resource_manager->get_buffer_slice_size(res_handle).value_or(buffer.get_size()),
             0,
             array_element
         );
+    } else if (resource_manager->contains_texture(res_handle) && type == vk::DescriptorType::eStorageImage) {
+        const auto view = resource_manager->get_texture(res_handle).get_image().get_mip_view(ctx, 0);
+        descriptor_set.queue_update(binding, *view, array_element);
     } else if (resource_manager->contains_texture(res_handle)) {
         const auto &texture = resource_manager->get_texture(res_handle);
         descriptor_set.queue_update(
@@ -796,18 +1469,21 @@ vector<RenderInfo> VulkanRenderer::create_node_render_infos(const RenderNodeHand
     const auto &node_info = render_graph_info.render_graph->nodes.at(node_handle);
     vector<RenderInfo> render_infos;
 
-    if (has_swapchain_target(node_handle)) {
-        bool is_first_with_final_target = is_first_node_targetting_final_image(node_handle);
+    // compute nodes don't begin a rendering scope, so they don't need any attachments
+    if (render_graph_info.render_graph->is_compute_node(node_handle)) {
+        return render_infos;
+    }
 
+    const auto &attachment_ops = render_graph_info.render_graph->get_attachment_ops(node_handle);
+
+    const auto apply_ops = [](RenderTarget &target, const RenderGraph::AttachmentOps &ops) {
+        target.override_attachment_config(ops.load_op, ops.store_op);
+    };
+
+    if (has_swapchain_target(node_handle)) {
         for (auto &swap_chain_targets: swap_chain->get_render_targets(ctx)) {
             vector<RenderTarget> color_targets;
 
-            if (!is_first_with_final_target) {
-                // has to be overridden, otherwise this render pass will clear the swapchain image
-                // todo - maybe also add this functionality to targets other than swapchain? like postprocessing
-                swap_chain_targets.color_target.override_attachment_config(vk::AttachmentLoadOp::eLoad);
-            }
-
             for (auto color_target_handle: node_info.color_targets) {
                 if (color_target_handle == FINAL_IMAGE_RESOURCE_HANDLE) {
                     color_targets.emplace_back(std::move(swap_chain_targets.color_target));
@@ -815,9 +1491,12 @@ vector<RenderInfo> VulkanRenderer::create_node_render_infos(const RenderNodeHand
                     const auto &target_texture = resource_manager->get_texture(color_target_handle);
                     color_targets.emplace_back(target_texture.get_image().get_view(ctx), target_texture.get_format());
                 }
+
+                apply_ops(color_targets.back(), attachment_ops.color_ops[color_targets.size() - 1]);
             }
 
             if (node_info.depth_target) {
+                apply_ops(swap_chain_targets.depth_target, attachment_ops.depth_ops);
                 render_infos.emplace_back(std::move(color_targets), std::move(swap_chain_targets.depth_target));
             } else {
                 render_infos.emplace_back(std::move(color_targets));
@@ -831,12 +1510,14 @@ vector<RenderInfo> VulkanRenderer::create_node_render_infos(const RenderNodeHand
             const auto &target_texture = resource_manager->get_texture(color_target_handle);
             color_targets.emplace_back(target_texture.get_image().get_mip_view(ctx, 0),
                                        target_texture.get_format());
+            apply_ops(color_targets.back(), attachment_ops.color_ops[color_targets.size() - 1]);
         }
 
         if (node_info.depth_target) {
             const auto &target_texture = resource_manager->get_texture(*node_info.depth_target);
             depth_target = RenderTarget(target_texture.get_image().get_layer_mip_view(ctx, 0, 0),
                                         target_texture.get_format());
+            apply_ops(*depth_target, attachment_ops.depth_ops);
         }
 
         if (depth_target) {
@@ -849,6 +1530,142 @@ vector<RenderInfo> VulkanRenderer::create_node_render_infos(const RenderNodeHand
     return render_infos;
 }
 
+vector<std::pair<ResourceHandle, ImageAccess> >
+VulkanRenderer::create_node_image_accesses(const RenderNodeHandle node_handle) const {
+    const auto &node = render_graph_info.render_graph->nodes.at(node_handle);
+    const auto &usage = render_graph_info.render_graph->node_usages.at(node_handle);
+    const auto &attachment_ops = render_graph_info.render_graph->get_attachment_ops(node_handle);
+    vector<std::pair<ResourceHandle, ImageAccess> > accesses;
+
+    // attachments which are loaded keep their contents across the layout transition
+    const auto is_discarded = [](const RenderGraph::AttachmentOps &ops) {
+        return ops.load_op != vk::AttachmentLoadOp::eLoad;
+    };
+
+    for (size_t i = 0; i < node.color_targets.size(); i++) {
+        const auto color_target = node.color_targets[i];
+
+        // the swapchain image is acquired anew each frame and is synchronized separately
+        if (color_target == FINAL_IMAGE_RESOURCE_HANDLE) continue;
+
+        accesses.emplace_back(color_target, ImageAccess{
+            .layout = vk::ImageLayout::eColorAttachmentOptimal,
+            .stages = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            .access = vk::AccessFlagBits2::eColorAttachmentWrite,
+            .discard_contents = is_discarded(attachment_ops.color_ops[i]),
+        });
+    }
+
+    if (node.depth_target) {
+        accesses.emplace_back(*node.depth_target, ImageAccess{
+            .layout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+            .stages = vk::PipelineStageFlagBits2::eEarlyFragmentTests
+                      | vk::PipelineStageFlagBits2::eLateFragmentTests,
+            .access = vk::AccessFlagBits2::eDepthStencilAttachmentRead
+                      | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+            .discard_contents = is_discarded(attachment_ops.depth_ops),
+        });
+    }
+
+    for (const auto storage_target: node.storage_targets) {
+        if (!resource_manager->contains_texture(storage_target)) continue;
+
+        accesses.emplace_back(storage_target, ImageAccess{
+            .layout = vk::ImageLayout::eGeneral,
+            .stages = vk::PipelineStageFlagBits2::eComputeShader,
+            .access = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+        });
+    }
+
+    const std::set<ResourceHandle> storage_inputs(node.storage_inputs.begin(), node.storage_inputs.end());
+
+    for (const auto resource: usage.shader_resources) {
+        if (!resource_manager->contains_texture(resource)) continue;
+
+        const auto stages = utils::sync::to_pipeline_stages(get_node_resource_stages(node_handle, resource));
+
+        if (storage_inputs.contains(resource)) {
+            accesses.emplace_back(resource, ImageAccess{
+                .layout = vk::ImageLayout::eGeneral,
+                .stages = stages,
+                .access = vk::AccessFlagBits2::eShaderStorageRead,
+            });
+        } else {
+            accesses.emplace_back(resource, ImageAccess{
+                .layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .stages = stages,
+                .access = vk::AccessFlagBits2::eShaderSampledRead,
+            });
+        }
+    }
+
+    return accesses;
+}
+
+vector<std::pair<ResourceHandle, BufferAccess> >
+VulkanRenderer::create_node_buffer_accesses(const RenderNodeHandle node_handle) const {
+    const auto &graph = *render_graph_info.render_graph;
+    const auto &node = graph.nodes.at(node_handle);
+    const auto &usage = graph.node_usages.at(node_handle);
+
+    // a single buffer can be both bound and used for indirect arguments, so the accesses are merged
+    std::map<ResourceHandle, BufferAccess> accesses;
+
+    for (const auto storage_target: node.storage_targets) {
+        if (!graph.storage_buffers.contains(storage_target)) continue;
+
+        accesses[storage_target] = BufferAccess{
+            .stages = vk::PipelineStageFlagBits2::eComputeShader,
+            .access = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+        };
+    }
+
+    for (const auto resource: usage.shader_resources) {
+        if (!graph.storage_buffers.contains(resource)) continue;
+
+        auto &access = accesses[resource];
+        access.stages |= utils::sync::to_pipeline_stages(get_node_resource_stages(node_handle, resource));
+        access.access |= vk::AccessFlagBits2::eShaderStorageRead;
+    }
+
+    for (const auto buffer: usage.indirect_buffers) {
+        auto &access = accesses[buffer];
+        access.stages |= vk::PipelineStageFlagBits2::eDrawIndirect;
+        access.access |= vk::AccessFlagBits2::eIndirectCommandRead;
+
+        // culled draws also hold the attributes of the instances or the indices of the meshlets which survived culling
+        if (!graph.is_compute_node(node_handle)) {
+            access.stages |= vk::PipelineStageFlagBits2::eVertexAttributeInput
+                    | vk::PipelineStageFlagBits2::eIndexInput;
+            access.access |= vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead;
+        }
+    }
+
+    return {accesses.begin(), accesses.end()};
+}
+
+vk::ShaderStageFlags VulkanRenderer::get_node_resource_stages(const RenderNodeHandle node_handle,
+                                                              const ResourceHandle resource) const {
+    const auto &graph = *render_graph_info.render_graph;
+    vk::ShaderStageFlags shader_stages{};
+
+    for (const auto pipeline: graph.node_usages.at(node_handle).pipelines) {
+        const auto &resource_stages = pipeline_resource_stages.at(pipeline);
+        if (const auto it = resource_stages.find(resource); it != resource_stages.end()) {
+            shader_stages |= it->second;
+        }
+    }
+
+    // the resource is bound but never statically used, so it only needs the right layout
+    if (!shader_stages) {
+        shader_stages = graph.is_compute_node(node_handle)
+                            ? vk::ShaderStageFlagBits::eCompute
+                            : vk::ShaderStageFlagBits::eFragment;
+    }
+
+    return shader_stages;
+}
+
 void VulkanRenderer::run_render_graph() {
     if (start_frame()) {
         record_graph_commands();
@@ -856,109 +1673,408 @@ void VulkanRenderer::run_render_graph() {
     }
 }
 
-void VulkanRenderer::record_graph_commands() const {
-    const auto &command_buffer = *frame_resources[current_frame_idx].graphics_cmd_buffer;
+void VulkanRenderer::record_graph_commands() {
+    auto &frame = frame_resources[current_frame_idx];
 
-    command_buffer.begin({});
+    frame.submissions.clear();
+    submission_state = {};
 
-    swap_chain->transition_to_attachment_layout(command_buffer);
+    swap_chain->transition_to_attachment_layout(open_submission(false));
 
-    for (const auto &node_resources: render_graph_info.topo_sorted_nodes) {
-        if (should_run_node_pass(node_resources.handle)) {
-            record_node_commands(node_resources);
+    const auto nodes_to_run = get_nodes_to_run();
+    vector<const RenderNodeResources *> scheduled_nodes;
+
+    for (const auto &level: render_graph_info.node_levels) {
+        for (const auto &node_resources: level) {
+            if (nodes_to_run.contains(node_resources.handle)) {
+                scheduled_nodes.push_back(&node_resources);
+            }
         }
     }
 
-    swap_chain->transition_to_present_layout(command_buffer);
+    record_nodes(scheduled_nodes);
+
+    if (!submission_state.open_graphics_submission) open_submission(false);
 
-    command_buffer.end();
+    const auto &present_submission = frame.submissions[*submission_state.open_graphics_submission];
+    swap_chain->transition_to_present_layout(*present_submission.command_buffer);
+
+    close_submission(false);
+    close_submission(true);
 }
 
-void VulkanRenderer::record_node_commands(const RenderNodeResources &node_resources) const {
-    const auto &command_buffer = *frame_resources[current_frame_idx].graphics_cmd_buffer;
-    const auto &node = render_graph_info.render_graph->nodes.at(node_resources.handle);
+void VulkanRenderer::record_nodes(const vector<const RenderNodeResources *> &nodes) {
+    auto &frame = frame_resources[current_frame_idx];
+    const auto &graph = *render_graph_info.render_graph;
 
-    Logger::debug("recording node: ", node.name);
+    vector<const vk::raii::CommandBuffer *> recorded_buffers(nodes.size());
+    vector<RenderPassStats> recorded_stats(nodes.size());
+    vector<std::future<void> > futures(nodes.size());
 
-    // if size > 1, then this means that this pass (node) draws to the swapchain image
-    // and thus benefits from double or triple buffering
-    const size_t subresource_index = node_resources.render_infos.size() == 1 ? 0 : current_frame_idx;
-    const auto &node_render_info = node_resources.render_infos[subresource_index];
+    node_stats.clear();
 
-    command_buffer.beginRendering(node_render_info.get(
-        get_node_target_extent(node_resources),
-        node.custom_properties.multiview_count)
-    );
-    record_node_rendering_commands(node_resources);
-    command_buffer.endRendering();
+    if (use_parallel_recording) {
+        // the frame's previous submission has already finished, so its secondary buffers can be reused
+        for (auto &worker: frame.recording_workers) {
+            worker.command_pool->reset();
+
+            for (auto &buffer: worker.secondary_cmd_buffers) {
+                buffer.was_recorded_this_frame = false;
+            }
+        }
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const auto handle = nodes[i]->handle;
+
+            // cached commands are validated on this thread, as they outlive the workers' per-frame pools.
+            // async compute nodes are recorded inline, as the workers' pools belong to the graphics queue family
+            if (graph.nodes.at(handle).custom_properties.cache_commands) continue;
+            if (graph.is_async_compute_node(handle)) continue;
+
+            futures[i] = recording_thread_pool->submit(ThreadPool::Task(
+                [this, &frame, &recorded_buffers, &recorded_stats, node_resources = nodes[i], i]
+                (const size_t worker_index) {
+                    const auto &command_buffer =
+                            acquire_secondary_command_buffer(frame.recording_workers[worker_index]);
+
+                    const vk::CommandBufferInheritanceInfo inheritance_info{};
+
+                    command_buffer.begin(vk::CommandBufferBeginInfo{
+                        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+                        .pInheritanceInfo = &inheritance_info,
+                    });
+                    recorded_stats[i] = record_node_rendering_commands(command_buffer, *node_resources);
+                    command_buffer.end();
+
+                    recorded_buffers[i] = &command_buffer;
+                }
+            ));
+        }
+    }
+
+    try {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const auto handle = nodes[i]->handle;
+            const auto &node = graph.nodes.at(handle);
+
+            Logger::debug("recording node: ", node.name);
+
+            const auto &command_buffer = begin_node_submission(handle);
+
+            // barriers only need the tracked image state, so they're recorded while the workers are busy
+            record_node_barriers(command_buffer, *nodes[i]);
+
+            if (futures[i].valid()) {
+                futures[i].get();
+                command_buffer.executeCommands(**recorded_buffers[i]);
+            } else if (node.custom_properties.cache_commands) {
+                const auto &cached_commands = get_cached_node_commands(*nodes[i]);
+                command_buffer.executeCommands(**cached_commands.buffer);
+                recorded_stats[i] = cached_commands.stats;
+            } else {
+                recorded_stats[i] = record_node_rendering_commands(command_buffer, *nodes[i]);
+            }
+
+            const auto &stats = recorded_stats[i];
+            node_stats.emplace(handle, stats);
+
+            Logger::debug("node ", node.name, ": ", stats.draw_count, " draws, ", stats.dispatch_count,
+                          " dispatches, ", stats.triangle_count, " triangles, ", stats.skipped_binds,
+                          " redundant binds skipped");
+
+            // regenerate mipmaps for each target that had them
+            if (!graph.is_compute_node(handle)) {
+                record_regenerate_mipmaps_commands(command_buffer, *nodes[i]);
+            }
+
+            end_node_submission(handle);
+        }
+    } catch (...) {
+        // the tasks still reference this frame's state, so they have to finish before unwinding
+        for (auto &future: futures) {
+            if (future.valid()) future.wait();
+        }
 
-    // regenerate mipmaps for each target that had them
-    record_regenerate_mipmaps_commands(node_resources);
+        throw;
+    }
+}
+
+const vk::raii::CommandBuffer &VulkanRenderer::begin_node_submission(const RenderNodeHandle handle) {
+    auto &submissions = frame_resources[current_frame_idx].submissions;
+    const bool is_async_compute = runs_on_async_compute_queue(handle);
+    const auto &open_index = is_async_compute
+                                 ? submission_state.open_async_compute_submission
+                                 : submission_state.open_graphics_submission;
+
+    TimelineSemValueType wait_value = 0;
+
+    if (async_compute_queue) {
+        for (const auto dependency: render_graph_info.render_graph->get_cross_queue_dependencies(handle)) {
+            // the dependency might not have run this frame
+            if (const auto it = submission_state.node_signal_values.find(dependency);
+                it != submission_state.node_signal_values.end()) {
+                wait_value = std::max(wait_value, it->second);
+            }
+        }
+    }
+
+    // nodes already in the open submission shouldn't be held back by the new wait
+    if (open_index && submissions[*open_index].has_nodes && submissions[*open_index].wait_value < wait_value) {
+        close_submission(is_async_compute);
+    }
+
+    if (!open_index) open_submission(is_async_compute);
+
+    auto &submission = submissions[*open_index];
+    submission.wait_value = std::max(submission.wait_value, wait_value);
+    submission.has_nodes = true;
+
+    submission_state.node_signal_values[handle] = submission.signal_value;
 
-    // todo - this should have more refined logic
-    // add barrier to the target image if it will be sampled
-    // record_pre_sample_commands(node_resources);
+    return *submission.command_buffer;
 }
 
-void VulkanRenderer::record_node_rendering_commands(const RenderNodeResources &node_resources) const {
-    const auto &command_buffer = *frame_resources[current_frame_idx].graphics_cmd_buffer;
-    const auto &node_info = render_graph_info.render_graph->nodes.at(node_resources.handle);
+void VulkanRenderer::end_node_submission(const RenderNodeHandle handle) {
+    // the dependents on the other queue can start as soon as this submission finishes
+    if (async_compute_queue && render_graph_info.render_graph->has_cross_queue_dependents(handle)) {
+        close_submission(runs_on_async_compute_queue(handle));
+    }
+}
 
-    utils::cmd::set_dynamic_states(command_buffer, get_node_target_extent(node_resources));
+const vk::raii::CommandBuffer &VulkanRenderer::open_submission(const bool is_async_compute) {
+    auto &submissions = frame_resources[current_frame_idx].submissions;
+    auto &timeline = is_async_compute ? async_compute_queue_timeline : graphics_queue_timeline;
+    auto &open_index = is_async_compute
+                           ? submission_state.open_async_compute_submission
+                           : submission_state.open_graphics_submission;
 
-    RenderPassContext ctx{ command_buffer, *resource_manager, render_graph_pipelines, pipeline_desc_sets };
-    node_info.body(ctx);
+    const auto &command_buffer = acquire_primary_command_buffer(is_async_compute);
+    command_buffer.begin({});
+
+    submissions.emplace_back(QueueSubmission{
+        .is_async_compute = is_async_compute,
+        .command_buffer = &command_buffer,
+        // compute work might overwrite resources which the previous frame's graphics work still reads
+        .wait_value = is_async_compute ? previous_frame_graphics_value : 0,
+        .signal_value = ++timeline.value,
+    });
+
+    open_index = submissions.size() - 1;
+
+    return command_buffer;
 }
 
-void VulkanRenderer::record_regenerate_mipmaps_commands(const RenderNodeResources &node_resources) const {
-    const auto &command_buffer = *frame_resources[current_frame_idx].graphics_cmd_buffer;
-    const auto &node = render_graph_info.render_graph->nodes.at(node_resources.handle);
+void VulkanRenderer::close_submission(const bool is_async_compute) {
+    auto &open_index = is_async_compute
+                           ? submission_state.open_async_compute_submission
+                           : submission_state.open_graphics_submission;
 
-    for (const auto color_target: node.color_targets) {
-        if (color_target == FINAL_IMAGE_RESOURCE_HANDLE) continue;
+    if (!open_index) return;
 
-        const auto &target_texture = resource_manager->get_texture(color_target);
-        if (target_texture.get_mip_levels() == 1) continue;
+    frame_resources[current_frame_idx].submissions[*open_index].command_buffer->end();
+    open_index.reset();
+}
 
-        target_texture.get_image().transition_layout(
-            vk::ImageLayout::eShaderReadOnlyOptimal,
-            vk::ImageLayout::eTransferDstOptimal,
-            command_buffer
-        );
+bool VulkanRenderer::runs_on_async_compute_queue(const RenderNodeHandle handle) const {
+    return async_compute_queue && render_graph_info.render_graph->is_async_compute_node(handle);
+}
+
+uint32_t VulkanRenderer::get_node_queue_family(const RenderNodeHandle handle) const {
+    return runs_on_async_compute_queue(handle)
+               ? *queue_family_indices.async_compute_family
+               : queue_family_indices.graphics_compute_family.value();
+}
+
+vector<uint32_t> VulkanRenderer::get_async_compute_sharing_families() const {
+    if (!queue_family_indices.async_compute_family) return {};
+
+    return {
+        queue_family_indices.graphics_compute_family.value(),
+        *queue_family_indices.async_compute_family
+    };
+}
+
+const vk::raii::CommandBuffer &
+VulkanRenderer::acquire_secondary_command_buffer(FrameResources::RecordingWorkerResources &worker) const {
+    auto it = std::ranges::find_if(worker.secondary_cmd_buffers, [](const SecondaryCommandBuffer &buffer) {
+        return !buffer.was_recorded_this_frame;
+    });
+
+    if (it == worker.secondary_cmd_buffers.end()) {
+        auto buffers = utils::cmd::create_command_buffers(ctx, *worker.command_pool,
+                                                          vk::CommandBufferLevel::eSecondary, 1);
+
+        worker.secondary_cmd_buffers.emplace_back(SecondaryCommandBuffer{
+            .buffer = make_unique<vk::raii::CommandBuffer>(std::move(buffers[0])),
+        });
+
+        it = std::prev(worker.secondary_cmd_buffers.end());
+    }
+
+    it->was_recorded_this_frame = true;
+    return **it;
+}
+
+const VulkanRenderer::CachedNodeCommands &
+VulkanRenderer::get_cached_node_commands(const RenderNodeResources &node_resources) {
+    const auto key = std::make_pair(node_resources.handle, static_cast<size_t>(current_frame_idx));
+    const auto node_version = render_graph_info.render_graph->get_node_version(node_resources.handle);
+    const auto extent = get_node_target_extent(node_resources);
 
-        target_texture.generate_mipmaps(ctx, vk::ImageLayout::eShaderReadOnlyOptimal);
+    if (const auto it = cached_node_commands.find(key); it != cached_node_commands.end()) {
+        if (it->second.node_version == node_version && it->second.extent == extent) {
+            return it->second;
+        }
+
+        // earlier frames in flight might still be executing the old buffer
+        frame_resources[current_frame_idx].retired_cmd_buffers.emplace_back(std::move(it->second.buffer));
+        cached_node_commands.erase(it);
     }
+
+    auto command_buffer = make_unique<vk::raii::CommandBuffer>(
+        utils::cmd::create_command_buffer(ctx, vk::CommandBufferLevel::eSecondary));
+
+    const vk::CommandBufferInheritanceInfo inheritance_info{};
+
+    // the buffer is replayed while earlier submissions of it are still pending
+    command_buffer->begin(vk::CommandBufferBeginInfo{
+        .flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse,
+        .pInheritanceInfo = &inheritance_info,
+    });
+    const auto stats = record_node_rendering_commands(*command_buffer, node_resources);
+    command_buffer->end();
+
+    Logger::debug("recorded cached commands of node: ",
+                  render_graph_info.render_graph->nodes.at(node_resources.handle).name);
+
+    const auto &[it, _] = cached_node_commands.emplace(key, CachedNodeCommands{
+        .buffer = std::move(command_buffer),
+        .node_version = node_version,
+        .extent = extent,
+        .stats = stats,
+    });
+
+    return it->second;
 }
 
-void VulkanRenderer::record_pre_sample_commands(const RenderNodeResources &node_resources) const {
-    const auto &command_buffer = *frame_resources[current_frame_idx].graphics_cmd_buffer;
+void VulkanRenderer::record_node_barriers(const vk::raii::CommandBuffer &command_buffer,
+                                          const RenderNodeResources &node_resources) {
+    const auto queue_family = get_node_queue_family(node_resources.handle);
+    vector<vk::ImageMemoryBarrier2> barriers;
+    vector<vk::BufferMemoryBarrier2> buffer_barriers;
+
+    for (const auto &[handle, access]: node_resources.image_accesses) {
+        // the texture takes over the memory from the previous one placed in the same block
+        if (const auto it = aliased_texture_blocks.find(handle); it != aliased_texture_blocks.end()) {
+            auto &occupant = alias_block_occupants[it->second];
+
+            if (occupant != handle) {
+                if (occupant) image_sync_states.at(handle) = image_sync_states.at(*occupant).get_aliasing_state();
+                occupant = handle;
+            }
+        }
+
+        const Image &image = handle == FINAL_IMAGE_RESOURCE_HANDLE
+                                 ? swap_chain->get_depth_image()
+                                 : resource_manager->get_texture(handle).get_image();
+
+        if (auto barrier = image_sync_states[handle].access(access, image, queue_family)) {
+            barriers.emplace_back(*barrier);
+        }
+    }
+
+    for (const auto &[handle, access]: node_resources.buffer_accesses) {
+        const auto &buffer = resource_manager->get_buffer(handle);
+
+        if (auto barrier = buffer_sync_states.at(handle).access(access, buffer, queue_family)) {
+            buffer_barriers.emplace_back(*barrier);
+        }
+    }
+
+    if (barriers.empty() && buffer_barriers.empty()) return;
+
+    command_buffer.pipelineBarrier2(vk::DependencyInfo{
+        .bufferMemoryBarrierCount = static_cast<uint32_t>(buffer_barriers.size()),
+        .pBufferMemoryBarriers = buffer_barriers.data(),
+        .imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+        .pImageMemoryBarriers = barriers.data(),
+    });
+}
+
+RenderPassStats VulkanRenderer::record_node_rendering_commands(const vk::raii::CommandBuffer &command_buffer,
+                                                               const RenderNodeResources &node_resources) const {
+    const auto &node_info = render_graph_info.render_graph->nodes.at(node_resources.handle);
+
+    RenderPassContext ctx{
+        command_buffer, *resource_manager, render_graph_pipelines, render_graph_compute_pipelines, pipeline_desc_sets,
+        pipeline_dynamic_slice_sizes, current_frame_idx
+    };
+
+    if (render_graph_info.render_graph->is_compute_node(node_resources.handle)) {
+        node_info.body(ctx);
+        return ctx.get_stats();
+    }
+
+    const auto extent = get_node_target_extent(node_resources);
+
+    const auto &node_render_info = node_resources.render_infos[get_node_render_info_index(node_resources)];
+
+    command_buffer.beginRendering(node_render_info.get(extent, node_info.custom_properties.multiview_count));
+
+    utils::cmd::set_dynamic_states(command_buffer, extent);
+
+    node_info.body(ctx);
+
+    command_buffer.endRendering();
+
+    return ctx.get_stats();
+}
+
+void VulkanRenderer::record_regenerate_mipmaps_commands(const vk::raii::CommandBuffer &command_buffer,
+                                                        const RenderNodeResources &node_resources) {
     const auto &node = render_graph_info.render_graph->nodes.at(node_resources.handle);
 
+    constexpr ImageAccess blit_access{
+        .layout = vk::ImageLayout::eTransferDstOptimal,
+        .stages = vk::PipelineStageFlagBits2::eBlit,
+        .access = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite,
+    };
+
+    vector<ResourceHandle> mipmapped_targets;
+    vector<vk::ImageMemoryBarrier2> barriers;
+
     for (const auto color_target: node.color_targets) {
         if (color_target == FINAL_IMAGE_RESOURCE_HANDLE) continue;
 
         const auto &target_texture = resource_manager->get_texture(color_target);
+        if (target_texture.get_mip_levels() == 1) continue;
 
-        const vk::ImageMemoryBarrier2 image_memory_barrier{
-            .srcStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
-            .srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
-            .dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
-            .dstAccessMask = vk::AccessFlagBits2::eShaderRead,
-            .oldLayout = vk::ImageLayout::eColorAttachmentOptimal,
-            .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-            .image = **target_texture.get_image(),
-            .subresourceRange = {
-                .aspectMask = vk::ImageAspectFlagBits::eColor,
-                .levelCount = 1,
-                .layerCount = 1,
-            }
-        };
+        mipmapped_targets.push_back(color_target);
+
+        if (auto barrier = image_sync_states.at(color_target).access(blit_access, target_texture.get_image())) {
+            barriers.emplace_back(*barrier);
+        }
+    }
 
+    if (!barriers.empty()) {
         command_buffer.pipelineBarrier2(vk::DependencyInfo{
-            .imageMemoryBarrierCount = 1,
-            .pImageMemoryBarriers = &image_memory_barrier,
+            .imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size()),
+            .pImageMemoryBarriers = barriers.data(),
         });
     }
+
+    for (const auto target: mipmapped_targets) {
+        resource_manager->get_texture(target).generate_mipmaps(ctx, command_buffer,
+                                                               vk::ImageLayout::eShaderReadOnlyOptimal);
+
+        // mipmap generation ends with its own barriers, making the result visible to fragment shaders
+        image_sync_states.at(target).assume_written(
+            vk::ImageLayout::eShaderReadOnlyOptimal,
+            vk::PipelineStageFlagBits2::eBlit,
+            vk::AccessFlagBits2::eTransferWrite,
+            vk::PipelineStageFlagBits2::eFragmentShader
+        );
+    }
 }
 
 bool VulkanRenderer::has_swapchain_target(const RenderNodeHandle handle) const {
@@ -967,29 +2083,55 @@ bool VulkanRenderer::has_swapchain_target(const RenderNodeHandle handle) const {
             .contains(FINAL_IMAGE_RESOURCE_HANDLE);
 }
 
-bool VulkanRenderer::is_first_node_targetting_final_image(const RenderNodeHandle handle) const {
-    if (!has_swapchain_target(handle)) return false;
-
-    auto first_it = std::ranges::find_if(render_graph_info.topo_sorted_nodes, [&](const RenderNodeResources &res) {
-        return has_swapchain_target(res.handle);
-    });
-
-    return first_it == render_graph_info.topo_sorted_nodes.end() || first_it->handle == handle;
-}
-
 bool VulkanRenderer::should_run_node_pass(const RenderNodeHandle handle) const {
     const auto &node = render_graph_info.render_graph->nodes.at(handle);
     return node.should_run_predicate ? (*node.should_run_predicate)() : true;
 }
 
+std::set<RenderNodeHandle> VulkanRenderer::get_nodes_to_run() const {
+    const auto &graph = *render_graph_info.render_graph;
+    std::set<RenderNodeHandle> result;
+
+    // consumers always sit in later levels than their producers, so they're decided first
+    for (auto level_it = render_graph_info.node_levels.rbegin(); level_it != render_graph_info.node_levels.rend();
+         ++level_it) {
+        for (const auto &node_resources: *level_it) {
+            const auto handle = node_resources.handle;
+            if (!should_run_node_pass(handle)) continue;
+
+            const bool is_consumed = graph.is_output_node(handle)
+                                     || std::ranges::any_of(graph.get_dependents(handle),
+                                                            [&](const RenderNodeHandle h) { return result.contains(h); });
+
+            if (is_consumed) result.insert(handle);
+        }
+    }
+
+    return result;
+}
+
 vk::Extent2D VulkanRenderer::get_node_target_extent(const RenderNodeResources &node_resources) const {
     const auto &node_info = render_graph_info.render_graph->nodes.at(node_resources.handle);
 
-    return has_swapchain_target(node_resources.handle)
-                        ? swap_chain->get_extent()
-                        : resource_manager->get_texture(node_info.color_targets[0])
-                            .get_image()
-                            .get_extent_2d();
+    // compute nodes don't render to anything, their dispatch sizes are chosen by their bodies
+    if (render_graph_info.render_graph->is_compute_node(node_resources.handle)) {
+        return {};
+    }
+
+    if (has_swapchain_target(node_resources.handle)) {
+        return swap_chain->get_extent();
+    }
+
+    // textures relative to the swapchain might be bigger than the part which is currently rendered to
+    return resource_manager->get_render_extent(node_info.color_targets.empty()
+                                                   ? *node_info.depth_target
+                                                   : node_info.color_targets[0]);
+}
+
+size_t VulkanRenderer::get_node_render_info_index(const RenderNodeResources &node_resources) const {
+    // if size > 1, then this means that this pass (node) draws to the swapchain image
+    // and thus benefits from double or triple buffering
+    return node_resources.render_infos.size() == 1 ? 0 : current_frame_idx;
 }
 
 vk::Format VulkanRenderer::get_target_color_format(const ResourceHandle handle) const {
@@ -1014,7 +2156,7 @@ void VulkanRenderer::tick(const float delta_time) {
 }
 
 void VulkanRenderer::do_frame_begin_actions() {
-    const FrameBeginActionContext fba_ctx{*resource_manager};
+    const FrameBeginActionContext fba_ctx{*resource_manager, current_frame_idx};
 
     for (const auto &action: repeated_frame_begin_actions) {
         action(fba_ctx);
@@ -1047,6 +2189,8 @@ bool VulkanRenderer::start_frame() {
         Logger::error("waitSemaphores on renderFinishedTimeline failed");
     }
 
+    frame_resources[current_frame_idx].retired_cmd_buffers.clear();
+
     do_frame_begin_actions();
 
     const auto &[result, image_index] = swap_chain->acquire_next_image(*sync.image_available_semaphore);
@@ -1065,54 +2209,7 @@ bool VulkanRenderer::start_frame() {
 void VulkanRenderer::end_frame() {
     auto &sync = frame_resources[current_frame_idx].sync;
 
-    const vector wait_semaphores = {
-        **sync.image_available_semaphore
-    };
-
-    const vector<TimelineSemValueType> wait_semaphore_values = {
-        0
-    };
-
-    static constexpr vk::PipelineStageFlags wait_stages[] = {
-        vk::PipelineStageFlagBits::eEarlyFragmentTests,
-        vk::PipelineStageFlagBits::eVertexInput,
-    };
-
-    const std::array signal_semaphores = {
-        **sync.render_finished_timeline.semaphore,
-        **sync.ready_to_present_semaphore
-    };
-
-    sync.render_finished_timeline.timeline++;
-    const vector<TimelineSemValueType> signal_semaphore_values{
-        sync.render_finished_timeline.timeline,
-        0
-    };
-
-    const vk::StructureChain<vk::SubmitInfo, vk::TimelineSemaphoreSubmitInfo> submit_info{
-        {
-            .waitSemaphoreCount = static_cast<uint32_t>(wait_semaphores.size()),
-            .pWaitSemaphores = wait_semaphores.data(),
-            .pWaitDstStageMask = wait_stages,
-            .commandBufferCount = 1,
-            .pCommandBuffers = &**frame_resources[current_frame_idx].graphics_cmd_buffer,
-            .signalSemaphoreCount = signal_semaphores.size(),
-            .pSignalSemaphores = signal_semaphores.data(),
-        },
-        {
-            .waitSemaphoreValueCount = static_cast<uint32_t>(wait_semaphore_values.size()),
-            .pWaitSemaphoreValues = wait_semaphore_values.data(),
-            .signalSemaphoreValueCount = static_cast<uint32_t>(signal_semaphore_values.size()),
-            .pSignalSemaphoreValues = signal_semaphore_values.data(),
-        }
-    };
-
-    try {
-        ctx.graphics_queue->submit(submit_info.get<vk::SubmitInfo>());
-    } catch (std::exception &e) {
-        std::cerr << e.what() << std::endl;
-        throw;
-    }
+    submit_frame();
 
     const std::array present_wait_semaphores = {**sync.ready_to_present_semaphore};
 
@@ -1145,4 +2242,104 @@ void VulkanRenderer::end_frame() {
 
     current_frame_idx = (current_frame_idx + 1) % MAX_FRAMES_IN_FLIGHT;
 }
+
+void VulkanRenderer::submit_frame() {
+    auto &frame = frame_resources[current_frame_idx];
+    auto &sync = frame.sync;
+    const auto &submissions = frame.submissions;
+
+    sync.render_finished_timeline.timeline++;
+
+    std::optional<size_t> first_graphics_index;
+    std::optional<size_t> last_graphics_index;
+
+    for (size_t i = 0; i < submissions.size(); i++) {
+        if (submissions[i].is_async_compute) continue;
+
+        if (!first_graphics_index) first_graphics_index = i;
+        last_graphics_index = i;
+    }
+
+    // the submit infos point into these, so they have to be fully built beforehand
+    vector<vector<vk::SemaphoreSubmitInfo> > wait_infos(submissions.size());
+    vector<vector<vk::SemaphoreSubmitInfo> > signal_infos(submissions.size());
+    vector<vk::CommandBufferSubmitInfo> command_buffer_infos(submissions.size());
+
+    vector<vk::SubmitInfo2> graphics_submit_infos;
+    vector<vk::SubmitInfo2> async_compute_submit_infos;
+
+    for (size_t i = 0; i < submissions.size(); i++) {
+        const auto &submission = submissions[i];
+        const auto &own_timeline = submission.is_async_compute
+                                       ? async_compute_queue_timeline
+                                       : graphics_queue_timeline;
+        const auto &other_timeline = submission.is_async_compute
+                                         ? graphics_queue_timeline
+                                         : async_compute_queue_timeline;
+
+        if (submission.wait_value > 0) {
+            wait_infos[i].push_back(vk::SemaphoreSubmitInfo{
+                .semaphore = **other_timeline.semaphore,
+                .value = submission.wait_value,
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+            });
+        }
+
+        signal_infos[i].push_back(vk::SemaphoreSubmitInfo{
+            .semaphore = **own_timeline.semaphore,
+            .value = submission.signal_value,
+            .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        });
+
+        if (i == first_graphics_index) {
+            // the acquired image is first touched when transitioned before being rendered to
+            wait_infos[i].push_back(vk::SemaphoreSubmitInfo{
+                .semaphore = **sync.image_available_semaphore,
+                .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            });
+        }
+
+        if (i == last_graphics_index) {
+            // compute work of this frame is waited for transitively, as all of it is consumed by graphics work
+            signal_infos[i].push_back(vk::SemaphoreSubmitInfo{
+                .semaphore = **sync.render_finished_timeline.semaphore,
+                .value = sync.render_finished_timeline.timeline,
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+            });
+
+            signal_infos[i].push_back(vk::SemaphoreSubmitInfo{
+                .semaphore = **sync.ready_to_present_semaphore,
+                .stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+            });
+        }
+
+        command_buffer_infos[i] = vk::CommandBufferSubmitInfo{
+            .commandBuffer = **submission.command_buffer,
+        };
+
+        auto &submit_infos = submission.is_async_compute ? async_compute_submit_infos : graphics_submit_infos;
+
+        submit_infos.emplace_back(vk::SubmitInfo2{
+            .waitSemaphoreInfoCount = static_cast<uint32_t>(wait_infos[i].size()),
+            .pWaitSemaphoreInfos = wait_infos[i].data(),
+            .commandBufferInfoCount = 1,
+            .pCommandBufferInfos = &command_buffer_infos[i],
+            .signalSemaphoreInfoCount = static_cast<uint32_t>(signal_infos[i].size()),
+            .pSignalSemaphoreInfos = signal_infos[i].data(),
+        });
+    }
+
+    try {
+        if (!async_compute_submit_infos.empty()) {
+            async_compute_queue->submit2(async_compute_submit_infos);
+        }
+
+        ctx.graphics_queue->submit2(graphics_submit_infos);
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        throw;
+    }
+
+    previous_frame_graphics_value = graphics_queue_timeline.value;
+}
 } // zrx
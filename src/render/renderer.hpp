@@ -9,12 +9,15 @@
 #include "libs.hpp"
 #include "globals.hpp"
 #include "graph.hpp"
+#include "graph-plan.hpp"
 #include "mesh/model.hpp"
 #include "vk/cmd.hpp"
 #include "vk/image.hpp"
 #include "vk/pipeline.hpp"
 #include "vk/ctx.hpp"
 #include "vk/descriptor.hpp"
+#include "vk/sync.hpp"
+#include "src/utils/thread-pool.hpp"
 
 #include <vk-bootstrap/VkBootstrap.h>
 
@@ -49,20 +52,18 @@ class GuiRenderer;
 class AccelerationStructure;
 class Camera;
 class ResourceManager;
+class SpirvReflectModuleWrapper;
 
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphics_compute_family;
     std::optional<uint32_t> present_family;
+    std::optional<uint32_t> async_compute_family;
 
     [[nodiscard]] bool isComplete() const {
         return graphics_compute_family.has_value() && present_family.has_value();
     }
 };
 
-struct ScenePushConstants {
-    uint32_t material_id;
-};
-
 class RenderInfo {
     vector<RenderTarget> color_targets;
     std::optional<RenderTarget> depth_target;
@@ -95,6 +96,11 @@ class VulkanRenderer {
     unique_ptr<vk::raii::Queue> present_queue;
     QueueFamilyIndices queue_family_indices;
 
+    // only present if the device has a compute queue family separate from the graphics one.
+    // otherwise async compute nodes run on the graphics queue.
+    unique_ptr<vk::raii::Queue> async_compute_queue;
+    unique_ptr<vk::raii::CommandPool> async_compute_command_pool;
+
     unique_ptr<SwapChain> swap_chain;
 
     unique_ptr<vk::raii::DescriptorPool> descriptor_pool;
@@ -104,21 +110,82 @@ class VulkanRenderer {
     struct RenderNodeResources {
         RenderNodeHandle handle;
         vector<RenderInfo> render_infos;
+        vector<std::pair<ResourceHandle, ImageAccess> > image_accesses;
+        vector<std::pair<ResourceHandle, BufferAccess> > buffer_accesses;
     };
 
     struct {
         unique_ptr<RenderGraph> render_graph;
-        vector<RenderNodeResources> topo_sorted_nodes;
+        vector<vector<RenderNodeResources> > node_levels;
+
+        // either loaded from disk, or filled in while registering the graph and saved afterwards
+        RenderGraphPlan plan;
+        bool is_plan_cached = false;
     } render_graph_info;
 
+    static constexpr auto RENDER_GRAPH_PLAN_PATH = "render-graph-plan.bin";
+
     unique_ptr<ResourceManager> resource_manager = make_unique<ResourceManager>();
     std::map<ResourceHandle, GraphicsPipeline> render_graph_pipelines;
+    std::map<ResourceHandle, ComputePipeline> render_graph_compute_pipelines;
     std::map<ResourceHandle, vector<DescriptorSet>> pipeline_desc_sets;
 
+    // slice sizes of the uniform buffers bound to each pipeline's dynamic descriptors,
+    // in the order in which their dynamic offsets are passed when binding the pipeline's sets
+    std::map<ResourceHandle, vector<vk::DeviceSize> > pipeline_dynamic_slice_sizes;
+
+    // shader stages in which each pipeline accesses each of its bound resources
+    std::map<ResourceHandle, std::map<ResourceHandle, vk::ShaderStageFlags> > pipeline_resource_stages;
+
+    // current synchronization state of each graph image. the swapchain's depth image
+    // is tracked under the final image handle.
+    std::map<ResourceHandle, ImageSyncState> image_sync_states;
+
+    // current synchronization state of each graph storage buffer
+    std::map<ResourceHandle, BufferSyncState> buffer_sync_states;
+
+    // textures sharing memory with other textures, mapped to the index of the memory block they're placed in
+    std::map<ResourceHandle, size_t> aliased_texture_blocks;
+
+    // texture which currently occupies each aliased memory block
+    vector<std::optional<ResourceHandle> > alias_block_occupants;
+
+    vk::DeviceSize aliasing_saved_bytes = 0;
+
+    // builders of the graph's own textures, kept to recreate the textures when the swapchain grows
+    std::map<ResourceHandle, TextureBuilder> graph_texture_builders;
+
+    // layout in which each of the graph's own textures is created
+    std::map<ResourceHandle, vk::ImageLayout> graph_texture_layouts;
+
     // other resources
 
     using TimelineSemValueType = std::uint64_t;
 
+    /**
+     * Timeline semaphore signalled by every submission to one queue, which the other queue waits on.
+     */
+    struct QueueTimeline {
+        unique_ptr<vk::raii::Semaphore> semaphore;
+        TimelineSemValueType value = 0;
+    };
+
+    QueueTimeline graphics_queue_timeline;
+    QueueTimeline async_compute_queue_timeline;
+
+    /**
+     * A batch of consecutive nodes submitted together to one of the queues. It waits on the other queue
+     * only if some of its nodes depend on nodes from there.
+     */
+    struct QueueSubmission {
+        bool is_async_compute;
+        const vk::raii::CommandBuffer *command_buffer;
+        // value of the other queue's timeline to wait for, or 0 if there's nothing to wait for
+        TimelineSemValueType wait_value = 0;
+        TimelineSemValueType signal_value;
+        bool has_nodes = false;
+    };
+
     struct FrameResources {
         struct {
             struct Timeline {
@@ -131,12 +198,66 @@ class VulkanRenderer {
             Timeline render_finished_timeline;
         } sync;
 
-        unique_ptr<vk::raii::CommandBuffer> graphics_cmd_buffer;
+        // primary command buffers for the frame's submissions to each queue, allocated as needed
+        vector<unique_ptr<vk::raii::CommandBuffer> > graphics_cmd_buffers;
+        vector<unique_ptr<vk::raii::CommandBuffer> > async_compute_cmd_buffers;
+
+        vector<QueueSubmission> submissions;
+
+        /**
+         * Command pool owned by a single recording worker, along with the secondary buffers allocated from it.
+         */
+        struct RecordingWorkerResources {
+            unique_ptr<vk::raii::CommandPool> command_pool;
+            vector<SecondaryCommandBuffer> secondary_cmd_buffers;
+        };
+
+        // indexed by the worker's index in the recording thread pool
+        vector<RecordingWorkerResources> recording_workers;
+
+        // invalidated cached command buffers, freed once this frame's previous submission has finished
+        vector<unique_ptr<vk::raii::CommandBuffer> > retired_cmd_buffers;
     };
 
     static constexpr size_t MAX_FRAMES_IN_FLIGHT = 3;
     std::array<FrameResources, MAX_FRAMES_IN_FLIGHT> frame_resources;
 
+    unique_ptr<ThreadPool> recording_thread_pool;
+
+    /**
+     * Secondary command buffer holding a node's rendering commands, replayed for as long as
+     * the node's version and target extent stay the same.
+     */
+    struct CachedNodeCommands {
+        unique_ptr<vk::raii::CommandBuffer> buffer;
+        uint64_t node_version;
+        vk::Extent2D extent;
+        RenderPassStats stats;
+    };
+
+    // keyed by the node and the frame in flight, as both the bound uniform buffer slices
+    // and the swapchain images rendered to differ between frames
+    std::map<std::pair<RenderNodeHandle, size_t>, CachedNodeCommands> cached_node_commands;
+
+    // commands recorded by each node in the last frame, shown in the gui
+    std::map<RenderNodeHandle, RenderPassStats> node_stats;
+
+    /**
+     * State of splitting the currently recorded frame into queue submissions.
+     */
+    struct {
+        std::optional<size_t> open_graphics_submission;
+        std::optional<size_t> open_async_compute_submission;
+        size_t used_graphics_cmd_buffers = 0;
+        size_t used_async_compute_cmd_buffers = 0;
+
+        // value signalled by the submission which contains each node recorded so far
+        std::map<RenderNodeHandle, TimelineSemValueType> node_signal_values;
+    } submission_state;
+
+    // value signalled by the last graphics submission of the previous frame
+    TimelineSemValueType previous_frame_graphics_value = 0;
+
     // gui stuff
 
     unique_ptr<vk::raii::DescriptorPool> imgui_descriptor_pool;
@@ -154,6 +275,11 @@ class VulkanRenderer {
     vk::SampleCountFlagBits msaa_sample_count = vk::SampleCountFlagBits::e1;
     bool use_msaa = false;
 
+    // set if the device has `VK_EXT_mesh_shader`, which is enabled only where it's present
+    bool mesh_shader_support = false;
+
+    bool use_parallel_recording = true;
+
     friend RenderPassContext;
     friend ShaderGatherRenderPassContext;
 
@@ -178,6 +304,8 @@ public:
         return use_msaa ? msaa_sample_count : vk::SampleCountFlagBits::e1;
     }
 
+    [[nodiscard]] bool supports_mesh_shaders() const { return mesh_shader_support; }
+
     void tick(float delta_time);
 
     void wait_idle() const { ctx.device->waitIdle(); }
@@ -222,6 +350,10 @@ private:
 
     void create_command_buffers();
 
+    void create_recording_workers();
+
+    [[nodiscard]] const vk::raii::CommandBuffer &acquire_primary_command_buffer(bool is_async_compute);
+
     // ==================== sync ====================
 
     void create_sync_objects();
@@ -238,34 +370,151 @@ public:
 private:
     void create_render_graph_resources();
 
-    [[nodiscard]] vector<DescriptorSet> create_graph_descriptor_sets(ResourceHandle pipeline_handle) const;
+    /**
+     * Groups the graph's aliasable textures into shared memory blocks, such that textures within a block
+     * are never in use at the same time, and assigns the blocks to their texture builders.
+     */
+    void assign_aliased_memory(std::map<ResourceHandle, TextureBuilder> &builders);
+
+    [[nodiscard]] vector<vector<ResourceHandle> >
+    plan_aliased_memory_blocks(const std::map<ResourceHandle, TextureBuilder> &builders) const;
+
+    [[nodiscard]] vk::MemoryRequirements
+    get_alias_block_requirements(const vector<ResourceHandle> &block_textures,
+                                 const std::map<ResourceHandle, TextureBuilder> &builders) const;
+
+    [[nodiscard]] vk::Extent2D get_swapchain_relative_extent(float scale) const;
+
+    /**
+     * Returns the graph's textures whose extent is derived from the swapchain, along with their scales.
+     */
+    [[nodiscard]] std::map<ResourceHandle, float> get_swapchain_relative_textures() const;
+
+    /**
+     * Adapts the textures relative to the swapchain to its new extent. Textures are only reallocated if they
+     * have to grow; otherwise they're kept, and only the top-left part of them is rendered to afterwards.
+     */
+    void resize_render_graph_textures();
+
+    /**
+     * Rewrites the descriptors which refer to any of the given resources, after they've been recreated.
+     */
+    void update_graph_descriptor_sets(const std::set<ResourceHandle> &changed_resources);
+
+    /**
+     * Returns the key under which the render graph's plan is cached. Besides the graph itself,
+     * the plan depends on the device, as memory aliasing is derived from its memory requirements.
+     */
+    [[nodiscard]] std::uint64_t get_render_graph_plan_key() const;
+
+    [[nodiscard]] vector<DescriptorSet> create_graph_descriptor_sets(ResourceHandle pipeline_handle);
+
+    /**
+     * Determines the descriptor type of each of the pipeline's bindings, and the stages accessing it,
+     * by reflecting the pipeline's shaders.
+     */
+    [[nodiscard]] RenderGraphPlan::ReflectedLayout reflect_pipeline_layout(ResourceHandle pipeline_handle) const;
+
+    /**
+     * Loads the pipeline's shader modules for reflection, along with the stages they're used in.
+     */
+    [[nodiscard]] vector<std::pair<unique_ptr<SpirvReflectModuleWrapper>, vk::ShaderStageFlagBits> >
+    load_pipeline_spv_modules(ResourceHandle pipeline_handle) const;
+
+    [[nodiscard]] std::optional<vk::PushConstantRange>
+    reflect_push_constant_range(ResourceHandle pipeline_handle) const;
+
+    /**
+     * Returns the push constant ranges of the pipeline's layout, reflecting them unless the plan is cached.
+     */
+    [[nodiscard]] vector<vk::PushConstantRange> get_graph_push_constant_ranges(ResourceHandle pipeline_handle);
 
     [[nodiscard]] GraphicsPipelineBuilder create_graph_pipeline_builder(
         ResourceHandle pipeline_handle, const vector<DescriptorSet> &descriptor_sets) const;
 
-    void queue_set_update_with_handle(DescriptorSet &descriptor_set, ResourceHandle res_handle,
-                                      uint32_t binding, uint32_t array_element = 0) const;
+    void queue_set_update_with_handle(DescriptorSet &descriptor_set, ResourceHandle res_handle, uint32_t binding,
+                                      vk::DescriptorType type, uint32_t array_element = 0) const;
 
     [[nodiscard]] vector<RenderInfo> create_node_render_infos(RenderNodeHandle node_handle) const;
 
-    void record_graph_commands() const;
+    [[nodiscard]] vector<std::pair<ResourceHandle, ImageAccess> >
+    create_node_image_accesses(RenderNodeHandle node_handle) const;
 
-    void record_node_commands(const RenderNodeResources &node_resources) const;
+    [[nodiscard]] vector<std::pair<ResourceHandle, BufferAccess> >
+    create_node_buffer_accesses(RenderNodeHandle node_handle) const;
 
-    void record_node_rendering_commands(const RenderNodeResources &node_resources) const;
+    /**
+     * Returns the shader stages in which any of the node's pipelines accesses the given bound resource.
+     */
+    [[nodiscard]] vk::ShaderStageFlags get_node_resource_stages(RenderNodeHandle node_handle,
+                                                                ResourceHandle resource) const;
 
-    void record_regenerate_mipmaps_commands(const RenderNodeResources &node_resources) const;
+    void record_graph_commands();
 
-    void record_pre_sample_commands(const RenderNodeResources &node_resources) const;
+    /**
+     * Records the given nodes in order. If parallel recording is enabled, the rendering commands of
+     * the nodes are recorded into secondary command buffers, spread over the recording workers.
+     * Barriers and mipmap generation are always recorded on the calling thread, as they depend on
+     * the tracked image state.
+     */
+    void record_nodes(const vector<const RenderNodeResources *> &nodes);
 
-    [[nodiscard]] bool has_swapchain_target(RenderNodeHandle handle) const;
+    /**
+     * Returns the primary command buffer into which the node should be recorded. A new submission is started
+     * if the node has to wait for work from the other queue which the current submission doesn't wait for.
+     */
+    [[nodiscard]] const vk::raii::CommandBuffer &begin_node_submission(RenderNodeHandle handle);
+
+    /**
+     * Ends the node's submission early if nodes on the other queue are waiting for the node's results.
+     */
+    void end_node_submission(RenderNodeHandle handle);
+
+    const vk::raii::CommandBuffer &open_submission(bool is_async_compute);
+
+    void close_submission(bool is_async_compute);
 
-    [[nodiscard]] bool is_first_node_targetting_final_image(RenderNodeHandle handle) const;
+    [[nodiscard]] bool runs_on_async_compute_queue(RenderNodeHandle handle) const;
+
+    [[nodiscard]] uint32_t get_node_queue_family(RenderNodeHandle handle) const;
+
+    [[nodiscard]] vector<uint32_t> get_async_compute_sharing_families() const;
+
+    [[nodiscard]] const vk::raii::CommandBuffer &
+    acquire_secondary_command_buffer(FrameResources::RecordingWorkerResources &worker) const;
+
+    /**
+     * Returns the node's cached rendering commands, re-recording them first if they were invalidated.
+     */
+    [[nodiscard]] const CachedNodeCommands &get_cached_node_commands(const RenderNodeResources &node_resources);
+
+    void record_node_barriers(const vk::raii::CommandBuffer &command_buffer,
+                              const RenderNodeResources &node_resources);
+
+    /**
+     * Records the node's body, within a rendering scope for its attachments unless it's a compute node.
+     * Returns statistics of the commands the body recorded.
+     */
+    RenderPassStats record_node_rendering_commands(const vk::raii::CommandBuffer &command_buffer,
+                                        const RenderNodeResources &node_resources) const;
+
+    void record_regenerate_mipmaps_commands(const vk::raii::CommandBuffer &command_buffer,
+                                            const RenderNodeResources &node_resources);
+
+    [[nodiscard]] bool has_swapchain_target(RenderNodeHandle handle) const;
 
     [[nodiscard]] bool should_run_node_pass(RenderNodeHandle handle) const;
 
+    /**
+     * Decides which nodes run this frame. A node runs only if its own predicate allows it and either
+     * it renders to the final image, or at least one of the nodes consuming its outputs runs as well.
+     */
+    [[nodiscard]] std::set<RenderNodeHandle> get_nodes_to_run() const;
+
     [[nodiscard]] vk::Extent2D get_node_target_extent(const RenderNodeResources &node_resources) const;
 
+    [[nodiscard]] size_t get_node_render_info_index(const RenderNodeResources &node_resources) const;
+
     [[nodiscard]] vk::Format get_target_color_format(ResourceHandle handle) const;
 
     [[nodiscard]] vk::Format get_target_depth_format(ResourceHandle handle) const;
@@ -280,5 +529,8 @@ public:
     bool start_frame();
 
     void end_frame();
+
+private:
+    void submit_frame();
 };
 } // zrx
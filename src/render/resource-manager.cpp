@@ -3,3 +3,23 @@
 #include "vk/buffer.hpp"
 #include "mesh/model.hpp"
 #include "vk/image.hpp"
+
+namespace zrx {
+vk::Extent2D ResourceManager::get_render_extent(const ResourceHandle handle) const {
+    if (const auto it = texture_render_extents.find(handle); it != texture_render_extents.end()) {
+        return it->second;
+    }
+
+    return get_texture(handle).get_image().get_extent_2d();
+}
+
+glm::vec2 ResourceManager::get_render_uv_scale(const ResourceHandle handle) const {
+    const auto render_extent = get_render_extent(handle);
+    const auto texture_extent = get_texture(handle).get_image().get_extent_2d();
+
+    return {
+        static_cast<float>(render_extent.width) / static_cast<float>(texture_extent.width),
+        static_cast<float>(render_extent.height) / static_cast<float>(texture_extent.height),
+    };
+}
+} // zrx
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <map>
+#include <optional>
 
 #include "globals.hpp"
+#include "libs.hpp"
 
 namespace zrx {
 class Buffer;
@@ -14,6 +16,12 @@ class ResourceManager {
     std::map<ResourceHandle, unique_ptr<Texture> > textures;
     std::map<ResourceHandle, unique_ptr<Model> > models;
 
+    // parts of textures which are rendered to, for textures which are bigger than what they currently hold
+    std::map<ResourceHandle, vk::Extent2D> texture_render_extents;
+
+    // size of a single frame's slice of each buffer which holds separate contents for every frame in flight
+    std::map<ResourceHandle, vk::DeviceSize> buffer_slice_sizes;
+
 public:
     void add(const ResourceHandle handle, unique_ptr<Buffer>&& buffer) { buffers.emplace(handle, std::move(buffer)); }
     void add(const ResourceHandle handle, unique_ptr<Texture>&& texture) { textures.emplace(handle, std::move(texture)); }
@@ -27,6 +35,38 @@ public:
     [[nodiscard]] Texture& get_texture(const ResourceHandle handle) { return *textures.at(handle); }
     [[nodiscard]] Model& get_model(const ResourceHandle handle) { return *models.at(handle); }
 
+    void replace(const ResourceHandle handle, unique_ptr<Texture>&& texture) {
+        textures.at(handle) = std::move(texture);
+    }
+
+    void set_render_extent(const ResourceHandle handle, const vk::Extent2D extent) {
+        texture_render_extents[handle] = extent;
+    }
+
+    /**
+     * Returns the part of a texture, anchored at its top-left corner, which is rendered to and holds valid contents.
+     * This is smaller than the texture itself if the texture is reused after the swapchain it's relative to shrinks.
+     */
+    [[nodiscard]] vk::Extent2D get_render_extent(ResourceHandle handle) const;
+
+    /**
+     * Returns the factor by which normalized coordinates within the rendered part of a texture have to be scaled
+     * to sample that part of the whole texture.
+     */
+    [[nodiscard]] glm::vec2 get_render_uv_scale(ResourceHandle handle) const;
+
+    void set_buffer_slice_size(const ResourceHandle handle, const vk::DeviceSize size) {
+        buffer_slice_sizes[handle] = size;
+    }
+
+    /**
+     * Returns the size of a single frame's slice of a buffer, or nothing if the buffer isn't split into slices.
+     */
+    [[nodiscard]] std::optional<vk::DeviceSize> get_buffer_slice_size(const ResourceHandle handle) const {
+        const auto it = buffer_slice_sizes.find(handle);
+        return it != buffer_slice_sizes.end() ? std::optional(it->second) : std::nullopt;
+    }
+
     [[nodiscard]] bool contains_buffer(const ResourceHandle handle) const { return buffers.contains(handle); }
     [[nodiscard]] bool contains_texture(const ResourceHandle handle) const { return textures.contains(handle); }
     [[nodiscard]] bool contains_model(const ResourceHandle handle) const { return models.contains(handle); }
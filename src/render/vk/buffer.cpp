@@ -5,12 +5,16 @@
 
 namespace zrx {
 Buffer::Buffer(const VmaAllocator _allocator, const vk::DeviceSize size, const vk::BufferUsageFlags usage,
-               const vk::MemoryPropertyFlags properties)
+               const vk::MemoryPropertyFlags properties, const vector<uint32_t> &sharing_queue_families)
     : allocator(_allocator), size(size) {
+    const bool is_concurrent = sharing_queue_families.size() > 1;
+
     const vk::BufferCreateInfo buffer_info{
         .size = size,
         .usage = usage,
-        .sharingMode = vk::SharingMode::eExclusive,
+        .sharingMode = is_concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+        .queueFamilyIndexCount = is_concurrent ? static_cast<uint32_t>(sharing_queue_families.size()) : 0u,
+        .pQueueFamilyIndices = is_concurrent ? sharing_queue_families.data() : nullptr,
     };
 
     VmaAllocationCreateFlags flags{};
@@ -80,13 +84,20 @@ void Buffer::copy_from_buffer(const RendererContext &ctx, const Buffer &other_bu
 }
 
 namespace utils::buf {
-    unique_ptr<Buffer> create_uniform_buffer(const RendererContext &ctx, const vk::DeviceSize size) {
+    unique_ptr<Buffer> create_uniform_buffer(const RendererContext &ctx, const vk::DeviceSize size,
+                                             const vector<uint32_t> &sharing_queue_families) {
         return make_unique<Buffer>(
             **ctx.allocator,
             size,
             vk::BufferUsageFlagBits::eUniformBuffer,
-            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            sharing_queue_families
         );
     }
+
+    vk::DeviceSize get_uniform_slice_size(const RendererContext &ctx, const vk::DeviceSize size) {
+        const auto alignment = ctx.physical_device->getProperties().limits.minUniformBufferOffsetAlignment;
+        return (size + alignment - 1) / alignment * alignment;
+    }
 }
 } // zrx
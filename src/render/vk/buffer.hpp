@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <vma/vk_mem_alloc.h>
 
 #include "src/render/libs.hpp"
@@ -22,8 +23,12 @@ class Buffer {
     void *mapped = nullptr;
 
 public:
+    /**
+     * @param sharing_queue_families Queue families which access the buffer concurrently. Passing less than
+     * two families creates the buffer with exclusive sharing.
+     */
     explicit Buffer(VmaAllocator _allocator, vk::DeviceSize size, vk::BufferUsageFlags usage,
-                    vk::MemoryPropertyFlags properties);
+                    vk::MemoryPropertyFlags properties, const vector<uint32_t> &sharing_queue_families = {});
 
     ~Buffer();
 
@@ -117,6 +122,54 @@ namespace utils::buf {
         return result_buffer;
     }
 
-    [[nodiscard]] unique_ptr<Buffer> create_uniform_buffer(const RendererContext &ctx, vk::DeviceSize size);
+    /**
+     * Like the above, but records the copy into a given command buffer instead of submitting it. The staging buffer
+     * is appended to `staging_buffers`, which have to be kept alive until the commands finish executing.
+     */
+    template<typename ElemType>
+    [[nodiscard]] unique_ptr<Buffer>
+    create_local_buffer(const RendererContext &ctx, const std::span<const ElemType> contents,
+                        const vk::BufferUsageFlags usage, const vk::raii::CommandBuffer &command_buffer,
+                        vector<unique_ptr<Buffer> > &staging_buffers) {
+        const vk::DeviceSize buffer_size = contents.size_bytes();
+
+        const auto &staging_buffer = staging_buffers.emplace_back(make_unique<Buffer>(
+            **ctx.allocator,
+            buffer_size,
+            vk::BufferUsageFlagBits::eTransferSrc,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+        ));
+
+        memcpy(staging_buffer->map(), contents.data(), static_cast<size_t>(buffer_size));
+        staging_buffer->unmap();
+
+        auto result_buffer = make_unique<Buffer>(
+            **ctx.allocator,
+            buffer_size,
+            vk::BufferUsageFlagBits::eTransferDst | usage,
+            vk::MemoryPropertyFlagBits::eDeviceLocal
+        );
+
+        command_buffer.copyBuffer(**staging_buffer, **result_buffer, vk::BufferCopy{.size = buffer_size});
+
+        return result_buffer;
+    }
+
+    template<typename ElemType>
+    [[nodiscard]] unique_ptr<Buffer>
+    create_local_buffer(const RendererContext &ctx, const vector<ElemType> &contents,
+                        const vk::BufferUsageFlags usage, const vk::raii::CommandBuffer &command_buffer,
+                        vector<unique_ptr<Buffer> > &staging_buffers) {
+        return create_local_buffer(ctx, std::span<const ElemType>(contents), usage, command_buffer, staging_buffers);
+    }
+
+    [[nodiscard]] unique_ptr<Buffer> create_uniform_buffer(const RendererContext &ctx, vk::DeviceSize size,
+                                                           const vector<uint32_t> &sharing_queue_families = {});
+
+    /**
+     * Returns the size of a slice of a uniform buffer holding `size` bytes, such that consecutive slices
+     * can be bound using dynamic offsets.
+     */
+    [[nodiscard]] vk::DeviceSize get_uniform_slice_size(const RendererContext &ctx, vk::DeviceSize size);
 } // utils::buf
 } // zrx
@@ -55,8 +55,13 @@ namespace utils::cmd {
 
     vk::raii::CommandBuffers create_command_buffers(const RendererContext &ctx, const vk::CommandBufferLevel level,
                                                     const uint32_t count) {
+        return create_command_buffers(ctx, *ctx.command_pool, level, count);
+    }
+
+    vk::raii::CommandBuffers create_command_buffers(const RendererContext &ctx, const vk::raii::CommandPool &pool,
+                                                    const vk::CommandBufferLevel level, const uint32_t count) {
         const vk::CommandBufferAllocateInfo alloc_info{
-            .commandPool = **ctx.command_pool,
+            .commandPool = *pool,
             .level = level,
             .commandBufferCount = count,
         };
@@ -51,6 +51,15 @@ namespace utils::cmd {
     [[nodiscard]] vk::raii::CommandBuffers
     create_command_buffers(const RendererContext& ctx, vk::CommandBufferLevel level, uint32_t count);
 
+    /**
+     * Allocates command buffers from a given pool instead of the context's shared one.
+     * Used by threads which record commands concurrently, as command pools can't be used by
+     * more than one thread at a time.
+     */
+    [[nodiscard]] vk::raii::CommandBuffers
+    create_command_buffers(const RendererContext& ctx, const vk::raii::CommandPool &pool,
+                           vk::CommandBufferLevel level, uint32_t count);
+
     [[nodiscard]] vk::raii::CommandBuffer
     create_command_buffer(const RendererContext &ctx, vk::CommandBufferLevel level);
 }
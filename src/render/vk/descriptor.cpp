@@ -78,7 +78,7 @@ DescriptorSet &DescriptorSet::queue_update(const uint32_t binding, const vk::rai
                                            const uint32_t array_element) {
     const vk::DescriptorImageInfo image_info{
         .imageView = *view,
-        .imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        .imageLayout = vk::ImageLayout::eGeneral,
     };
 
     queued_updates.emplace_back(DescriptorUpdate{
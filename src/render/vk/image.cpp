@@ -2,6 +2,7 @@
 
 #include <filesystem>
 #include <map>
+#include <set>
 
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
@@ -107,6 +108,31 @@ static const std::map<std::pair<vk::ImageLayout, vk::ImageLayout>, ImageBarrierI
 };
 
 namespace zrx {
+ImageMemoryBlock::ImageMemoryBlock(const RendererContext &ctx, const vk::MemoryRequirements &requirements)
+    : allocator(**ctx.allocator), size(requirements.size) {
+    const VmaAllocationCreateInfo alloc_info{
+        .requiredFlags = static_cast<VkMemoryPropertyFlags>(vk::MemoryPropertyFlagBits::eDeviceLocal),
+    };
+
+    const auto result = vmaAllocateMemory(
+        allocator,
+        reinterpret_cast<const VkMemoryRequirements *>(&requirements),
+        &alloc_info,
+        &allocation,
+        nullptr
+    );
+
+    if (result != VK_SUCCESS) {
+        Logger::error("failed to allocate image memory block!");
+    }
+}
+
+ImageMemoryBlock::~ImageMemoryBlock() {
+    vmaFreeMemory(allocator, allocation);
+}
+
+// ==================== Image ====================
+
 Image::Image(const RendererContext &ctx, const vk::ImageCreateInfo &image_info,
              const vk::MemoryPropertyFlags properties, const vk::ImageAspectFlags aspect)
     : allocator(**ctx.allocator),
@@ -147,8 +173,32 @@ Image::Image(const RendererContext &ctx, const vk::ImageCreateInfo &image_info,
     allocation = make_unique<VmaAllocation>(new_allocation);
 }
 
+Image::Image(const RendererContext &ctx, const vk::ImageCreateInfo &image_info,
+             shared_ptr<ImageMemoryBlock> memory, const vk::ImageAspectFlags aspect)
+    : allocator(**ctx.allocator),
+      aliased_memory(std::move(memory)),
+      extent(image_info.extent),
+      format(image_info.format),
+      mip_levels(image_info.mipLevels),
+      aspect_mask(aspect) {
+    VkImage new_image;
+
+    const auto result = vmaCreateAliasingImage(
+        allocator,
+        **aliased_memory,
+        reinterpret_cast<const VkImageCreateInfo *>(&image_info),
+        &new_image
+    );
+
+    if (result != VK_SUCCESS) {
+        Logger::error("failed to create aliasing image!");
+    }
+
+    image = make_unique<vk::raii::Image>(*ctx.device, new_image);
+}
+
 Image::~Image() {
-    vmaFreeMemory(allocator, *allocation);
+    if (allocation) vmaFreeMemory(allocator, *allocation);
 }
 
 shared_ptr<vk::raii::ImageView> Image::get_view(const RendererContext &ctx) {
@@ -168,6 +218,16 @@ shared_ptr<vk::raii::ImageView> Image::get_layer_mip_view(const RendererContext
     return get_cached_view(ctx, {mip_level, 1, layer, 1});
 }
 
+vk::ImageSubresourceRange Image::get_subresource_range() const {
+    return {
+        .aspectMask = aspect_mask,
+        .baseMipLevel = 0,
+        .levelCount = mip_levels,
+        .baseArrayLayer = 0,
+        .layerCount = get_layer_count(),
+    };
+}
+
 shared_ptr<vk::raii::ImageView> Image::get_cached_view(const RendererContext &ctx, ViewParams params) {
     if (cached_views.contains(params)) {
         return cached_views.at(params);
@@ -451,14 +511,19 @@ void CubeImage::transition_layout(const vk::ImageLayout old_layout, const vk::Im
 // ==================== Texture ====================
 
 void Texture::generate_mipmaps(const RendererContext &ctx, const vk::ImageLayout final_layout) const {
+    const vk::raii::CommandBuffer command_buffer = utils::cmd::begin_single_time_commands(ctx);
+    generate_mipmaps(ctx, command_buffer, final_layout);
+    utils::cmd::end_single_time_commands(command_buffer, *ctx.graphics_queue);
+}
+
+void Texture::generate_mipmaps(const RendererContext &ctx, const vk::raii::CommandBuffer &command_buffer,
+                               const vk::ImageLayout final_layout) const {
     const vk::FormatProperties format_properties = ctx.physical_device->getFormatProperties(get_format());
 
     if (!(format_properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear)) {
         Logger::error("texture image format does not support linear blitting!");
     }
 
-    const vk::raii::CommandBuffer command_buffer = utils::cmd::begin_single_time_commands(ctx);
-
     const bool is_cube_map     = dynamic_cast<CubeImage *>(&*image) != nullptr;
     const uint32_t layer_count = is_cube_map ? 6 : 1;
 
@@ -563,8 +628,6 @@ void Texture::generate_mipmaps(const RendererContext &ctx, const vk::ImageLayout
         nullptr,
         trans_barrier
     );
-
-    utils::cmd::end_single_time_commands(command_buffer, *ctx.graphics_queue);
 }
 
 void Texture::create_sampler(const RendererContext &ctx, const vk::SamplerAddressMode address_mode) {
@@ -655,50 +718,78 @@ TextureBuilder &TextureBuilder::from_swizzle_fill(vk::Extent3D extent) {
     return *this;
 }
 
+TextureBuilder &TextureBuilder::with_aliased_memory(shared_ptr<ImageMemoryBlock> memory) {
+    aliased_memory = std::move(memory);
+    return *this;
+}
+
+TextureBuilder &TextureBuilder::shared_between(const vector<uint32_t> &queue_families) {
+    const std::set unique_families(queue_families.begin(), queue_families.end());
+    sharing_queue_families.assign(unique_families.begin(), unique_families.end());
+    if (sharing_queue_families.size() < 2) sharing_queue_families.clear();
+    return *this;
+}
+
+vk::MemoryRequirements TextureBuilder::get_memory_requirements(const RendererContext &ctx) const {
+    if (!is_uninitialized) {
+        Logger::error("memory requirements can only be queried for uninitialized textures!");
+    }
+
+    // the image is only needed for the query, it's never bound to any memory
+    const vk::raii::Image image{*ctx.device, get_image_info(*desired_extent, get_layer_count())};
+    return image.getMemoryRequirements();
+}
+
 unique_ptr<Texture> TextureBuilder::create(const RendererContext &ctx) const {
+    const auto loaded_tex_data = load();
+
+    vector<unique_ptr<Buffer> > staging_buffers;
+    unique_ptr<Texture> texture;
+
+    utils::cmd::do_single_time_commands(ctx, [&](const auto &cmd_buffer) {
+        texture = create(ctx, loaded_tex_data, cmd_buffer, staging_buffers);
+    });
+
+    return texture;
+}
+
+TextureBuilder::LoadedTextureData TextureBuilder::load() const {
     check_params();
 
+    if (is_uninitialized) return {{}, *desired_extent, get_layer_count()};
+    if (!paths.empty()) return load_from_paths();
+    if (memory_source) return load_from_memory();
+    return load_from_swizzle_fill();
+}
+
+unique_ptr<Texture> TextureBuilder::create(const RendererContext &ctx, const LoadedTextureData &data,
+                                           const vk::raii::CommandBuffer &command_buffer,
+                                           vector<unique_ptr<Buffer> > &staging_buffers) const {
     // stupid workaround because std::unique_ptr doesn't have access to the Texture ctor
     unique_ptr<Texture> texture; {
         Texture t;
         texture = make_unique<Texture>(std::move(t));
     }
 
-    LoadedTextureData loaded_tex_data;
-
-    if (is_uninitialized) loaded_tex_data = {{}, *desired_extent, get_layer_count()};
-    else if (!paths.empty()) loaded_tex_data = load_from_paths();
-    else if (memory_source) loaded_tex_data = load_from_memory();
-    else if (is_from_swizzle_fill) loaded_tex_data = load_from_swizzle_fill();
+    const auto extent = data.extent;
 
-    const auto extent         = loaded_tex_data.extent;
-    const auto staging_buffer = is_uninitialized ? nullptr : make_staging_buffer(ctx, loaded_tex_data);
-
-    uint32_t mip_levels = 1;
-    if (tex_flags & vk::TextureFlagBitsZRX::MIPMAPS) {
-        mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+    if (!is_uninitialized) {
+        staging_buffers.push_back(make_staging_buffer(ctx, data));
     }
 
-    const vk::ImageCreateInfo image_info{
-        .flags = tex_flags & vk::TextureFlagBitsZRX::CUBEMAP
-                     ? vk::ImageCreateFlagBits::eCubeCompatible
-                     : static_cast<vk::ImageCreateFlags>(0),
-        .imageType = vk::ImageType::e2D,
-        .format = format,
-        .extent = extent,
-        .mipLevels = mip_levels,
-        .arrayLayers = loaded_tex_data.layer_count,
-        .samples = vk::SampleCountFlagBits::e1,
-        .tiling = vk::ImageTiling::eOptimal,
-        .usage = usage,
-        .sharingMode = vk::SharingMode::eExclusive,
-        .initialLayout = vk::ImageLayout::eUndefined,
-    };
+    const vk::ImageCreateInfo image_info = get_image_info(extent, data.layer_count);
 
     const bool is_depth     = !!(usage & vk::ImageUsageFlagBits::eDepthStencilAttachment);
     const auto aspect_flags = is_depth ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
 
-    if (tex_flags & vk::TextureFlagBitsZRX::CUBEMAP) {
+    if (aliased_memory) {
+        texture->image = make_unique<Image>(
+            ctx,
+            image_info,
+            aliased_memory,
+            aspect_flags
+        );
+    } else if (tex_flags & vk::TextureFlagBitsZRX::CUBEMAP) {
         texture->image = make_unique<CubeImage>(
             ctx,
             image_info,
@@ -716,42 +807,61 @@ unique_ptr<Texture> TextureBuilder::create(const RendererContext &ctx) const {
     texture->create_sampler(ctx, address_mode);
 
     if (is_uninitialized && !(tex_flags & vk::TextureFlagBitsZRX::MIPMAPS)) {
-        utils::cmd::do_single_time_commands(ctx, [&](const auto &cmd_buffer) {
-            texture->image->transition_layout(
-                vk::ImageLayout::eUndefined,
-                layout,
-                cmd_buffer
-            );
-        });
+        texture->image->transition_layout(
+            vk::ImageLayout::eUndefined,
+            layout,
+            command_buffer
+        );
     } else {
-        utils::cmd::do_single_time_commands(ctx, [&](const auto &cmd_buffer) {
-            texture->image->transition_layout(
-                vk::ImageLayout::eUndefined,
-                vk::ImageLayout::eTransferDstOptimal,
-                cmd_buffer
-            );
-
-            if (!is_uninitialized) {
-                texture->image->copy_from_buffer(**staging_buffer, cmd_buffer);
-            }
+        texture->image->transition_layout(
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eTransferDstOptimal,
+            command_buffer
+        );
 
-            if (!(tex_flags & vk::TextureFlagBitsZRX::MIPMAPS)) {
-                texture->image->transition_layout(
-                    vk::ImageLayout::eTransferDstOptimal,
-                    layout,
-                    cmd_buffer
-                );
-            }
-        });
+        if (!is_uninitialized) {
+            texture->image->copy_from_buffer(**staging_buffers.back(), command_buffer);
+        }
 
         if (tex_flags & vk::TextureFlagBitsZRX::MIPMAPS) {
-            texture->generate_mipmaps(ctx, layout);
+            texture->generate_mipmaps(ctx, command_buffer, layout);
+        } else {
+            texture->image->transition_layout(
+                vk::ImageLayout::eTransferDstOptimal,
+                layout,
+                command_buffer
+            );
         }
     }
 
     return texture;
 }
 
+vk::ImageCreateInfo TextureBuilder::get_image_info(const vk::Extent3D extent, const uint32_t layer_count) const {
+    uint32_t mip_levels = 1;
+    if (tex_flags & vk::TextureFlagBitsZRX::MIPMAPS) {
+        mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1;
+    }
+
+    return {
+        .flags = tex_flags & vk::TextureFlagBitsZRX::CUBEMAP
+                     ? vk::ImageCreateFlagBits::eCubeCompatible
+                     : static_cast<vk::ImageCreateFlags>(0),
+        .imageType = vk::ImageType::e2D,
+        .format = format,
+        .extent = extent,
+        .mipLevels = mip_levels,
+        .arrayLayers = layer_count,
+        .samples = vk::SampleCountFlagBits::e1,
+        .tiling = vk::ImageTiling::eOptimal,
+        .usage = usage,
+        .sharingMode = sharing_queue_families.empty() ? vk::SharingMode::eExclusive : vk::SharingMode::eConcurrent,
+        .queueFamilyIndexCount = static_cast<uint32_t>(sharing_queue_families.size()),
+        .pQueueFamilyIndices = sharing_queue_families.empty() ? nullptr : sharing_queue_families.data(),
+        .initialLayout = vk::ImageLayout::eUndefined,
+    };
+}
+
 void TextureBuilder::check_params() const {
     if (paths.empty() && !memory_source && !is_from_swizzle_fill && !is_uninitialized) {
         Logger::error("no specified data source for texture!");
@@ -770,6 +880,16 @@ void TextureBuilder::check_params() const {
         Logger::error("cannot simultaneously set texture as uninitialized and specify sources!");
     }
 
+    if (aliased_memory) {
+        if (!is_uninitialized) {
+            Logger::error("only uninitialized textures can be placed in aliased memory!");
+        }
+
+        if (tex_flags & vk::TextureFlagBitsZRX::CUBEMAP) {
+            Logger::error("cubemaps in aliased memory are currently not supported!");
+        }
+    }
+
     if (tex_flags & vk::TextureFlagBitsZRX::CUBEMAP) {
         if (memory_source) {
             Logger::error("cubemaps from a memory source are currently not supported!");
@@ -866,7 +986,8 @@ TextureBuilder::LoadedTextureData TextureBuilder::load_from_paths() const {
             continue;
         }
 
-        stbi_set_flip_vertically_on_load(tex_flags & vk::TextureFlagBitsZRX::HDR ? 1 : 0);
+        // textures can be decoded by multiple threads at once, so the flag mustn't be global
+        stbi_set_flip_vertically_on_load_thread(tex_flags & vk::TextureFlagBitsZRX::HDR ? 1 : 0);
         const int desired_channels = is_separate_channels ? STBI_grey : STBI_rgb_alpha;
         void *src;
 
@@ -63,6 +63,33 @@ namespace zrx {
 class Buffer;
 struct RendererContext;
 
+/**
+ * Block of device-local memory which isn't owned by any single image. Images with non-overlapping
+ * lifetimes can be placed in the same block, so that they share (alias) the same memory.
+ */
+class ImageMemoryBlock {
+    VmaAllocator allocator{};
+    VmaAllocation allocation{};
+    vk::DeviceSize size;
+
+public:
+    explicit ImageMemoryBlock(const RendererContext &ctx, const vk::MemoryRequirements &requirements);
+
+    ~ImageMemoryBlock();
+
+    ImageMemoryBlock(const ImageMemoryBlock &other) = delete;
+
+    ImageMemoryBlock(ImageMemoryBlock &&other) = delete;
+
+    ImageMemoryBlock &operator=(const ImageMemoryBlock &other) = delete;
+
+    ImageMemoryBlock &operator=(ImageMemoryBlock &&other) = delete;
+
+    [[nodiscard]] VmaAllocation operator*() const { return allocation; }
+
+    [[nodiscard]] vk::DeviceSize get_size() const { return size; }
+};
+
 /**
  * Abstraction over a Vulkan image, making it easier to manage by hiding all the Vulkan API calls.
  * These images are allocated using VMA and as such are not suited for swap chain images.
@@ -71,6 +98,7 @@ class Image {
 protected:
     VmaAllocator allocator{};
     unique_ptr<VmaAllocation> allocation{};
+    shared_ptr<ImageMemoryBlock> aliased_memory; // set instead of `allocation` for images placed in a shared block
     unique_ptr<vk::raii::Image> image;
     vk::Extent3D extent;
     vk::Format format{};
@@ -82,6 +110,12 @@ public:
     explicit Image(const RendererContext &ctx, const vk::ImageCreateInfo &image_info,
                    vk::MemoryPropertyFlags properties, vk::ImageAspectFlags aspect);
 
+    /**
+     * Creates an image which doesn't own its memory, but is instead bound to the beginning of a given block.
+     */
+    explicit Image(const RendererContext &ctx, const vk::ImageCreateInfo &image_info,
+                   shared_ptr<ImageMemoryBlock> memory, vk::ImageAspectFlags aspect);
+
     virtual ~Image();
 
     Image(const Image &other) = delete;
@@ -130,6 +164,13 @@ public:
 
     [[nodiscard]] uint32_t get_mip_levels() const { return mip_levels; }
 
+    [[nodiscard]] virtual uint32_t get_layer_count() const { return 1; }
+
+    /**
+     * Returns a subresource range covering all mip levels and all layers of this image.
+     */
+    [[nodiscard]] vk::ImageSubresourceRange get_subresource_range() const;
+
     /**
      * Records commands that copy the contents of a given buffer to this image.
      */
@@ -178,6 +219,8 @@ public:
     [[nodiscard]] shared_ptr<vk::raii::ImageView>
     get_mip_view(const RendererContext &ctx, uint32_t mip_level) override;
 
+    [[nodiscard]] uint32_t get_layer_count() const override { return 6; }
+
     void copy_from_buffer(vk::Buffer buffer, const vk::raii::CommandBuffer &command_buffer) override;
 
     void transition_layout(vk::ImageLayout old_layout, vk::ImageLayout new_layout,
@@ -203,6 +246,14 @@ public:
 
     void generate_mipmaps(const RendererContext &ctx, vk::ImageLayout final_layout) const;
 
+    /**
+     * Records commands regenerating all mip levels from the first one into a given command buffer.
+     * All mip levels are expected to be in the `eTransferDstOptimal` layout. After these commands execute,
+     * the whole image is in `final_layout` and visible to reads in the fragment shader.
+     */
+    void generate_mipmaps(const RendererContext &ctx, const vk::raii::CommandBuffer &command_buffer,
+                          vk::ImageLayout final_layout) const;
+
 private:
     void create_sampler(const RendererContext &ctx, vk::SamplerAddressMode address_mode);
 };
@@ -252,13 +303,20 @@ class TextureBuilder {
     void *memory_source = nullptr;
     bool is_from_swizzle_fill = false;
 
+    shared_ptr<ImageMemoryBlock> aliased_memory;
+
+    vector<uint32_t> sharing_queue_families;
+
+public:
+    /**
+     * Contents of a texture decoded on the host, which are released once they're uploaded by `create`.
+     */
     struct LoadedTextureData {
         vector<void *> sources;
         vk::Extent3D extent;
         uint32_t layer_count;
     };
 
-public:
     TextureBuilder &use_format(vk::Format f);
 
     TextureBuilder &use_layout(vk::ImageLayout l);
@@ -291,12 +349,46 @@ public:
      */
     TextureBuilder &from_swizzle_fill(vk::Extent3D extent);
 
+    /**
+     * Designates the texture's image to be placed in a given memory block instead of getting its own allocation.
+     * This is only supported for uninitialized, non-cubemap textures.
+     */
+    TextureBuilder &with_aliased_memory(shared_ptr<ImageMemoryBlock> memory);
+
+    /**
+     * Returns the memory requirements of the image which would be created by this builder.
+     * This is only supported for uninitialized textures.
+     */
+    [[nodiscard]] vk::MemoryRequirements get_memory_requirements(const RendererContext &ctx) const;
+
+    /**
+     * Makes the texture's image accessible from multiple queue families at once, without the need
+     * for queue family ownership transfers. Passing less than two distinct families keeps exclusive sharing.
+     */
+    TextureBuilder &shared_between(const vector<uint32_t> &queue_families);
+
     [[nodiscard]] unique_ptr<Texture>
     create(const RendererContext &ctx) const;
 
+    /**
+     * Decodes the texture's contents without touching the device, so that it can run on any thread.
+     */
+    [[nodiscard]] LoadedTextureData load() const;
+
+    /**
+     * Creates the texture from contents returned by `load`, recording the upload into a given command buffer
+     * instead of submitting it. The staging buffer is appended to `staging_buffers`, which have to be kept alive
+     * until the commands finish executing.
+     */
+    [[nodiscard]] unique_ptr<Texture>
+    create(const RendererContext &ctx, const LoadedTextureData &data, const vk::raii::CommandBuffer &command_buffer,
+           vector<unique_ptr<Buffer> > &staging_buffers) const;
+
 private:
     void check_params() const;
 
+    [[nodiscard]] vk::ImageCreateInfo get_image_info(vk::Extent3D extent, uint32_t layer_count) const;
+
     [[nodiscard]] uint32_t get_layer_count() const;
 
     [[nodiscard]] LoadedTextureData load_from_paths() const;
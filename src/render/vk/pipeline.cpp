@@ -32,6 +32,16 @@ GraphicsPipelineBuilder &GraphicsPipelineBuilder::with_vertex_shader(const std::
     return *this;
 }
 
+GraphicsPipelineBuilder &GraphicsPipelineBuilder::with_task_shader(const std::filesystem::path &path) {
+    task_shader_path = path;
+    return *this;
+}
+
+GraphicsPipelineBuilder &GraphicsPipelineBuilder::with_mesh_shader(const std::filesystem::path &path) {
+    mesh_shader_path = path;
+    return *this;
+}
+
 GraphicsPipelineBuilder &GraphicsPipelineBuilder::with_fragment_shader(const std::filesystem::path &path) {
     fragment_shader_path = path;
     return *this;
@@ -93,26 +103,34 @@ GraphicsPipelineBuilder &GraphicsPipelineBuilder::with_depth_format(const vk::Fo
 GraphicsPipeline GraphicsPipelineBuilder::create(const RendererContext &ctx) const {
     GraphicsPipeline result;
 
-    vk::raii::ShaderModule vert_shader_module = create_shader_module(ctx, vertex_shader_path);
-    vk::raii::ShaderModule frag_shader_module = create_shader_module(ctx, fragment_shader_path);
+    const bool uses_mesh_shaders = !mesh_shader_path.empty();
+    result.mesh_shading = uses_mesh_shaders;
 
-    const vk::PipelineShaderStageCreateInfo vert_shader_stage_info{
-        .stage = vk::ShaderStageFlagBits::eVertex,
-        .module = *vert_shader_module,
-        .pName = "main",
-    };
+    vector<vk::raii::ShaderModule> shader_modules;
+    vector<vk::PipelineShaderStageCreateInfo> shader_stages;
 
-    const vk::PipelineShaderStageCreateInfo frag_shader_stage_info{
-        .stage = vk::ShaderStageFlagBits::eFragment,
-        .module = *frag_shader_module,
-        .pName = "main",
-    };
+    const auto add_stage = [&](const vk::ShaderStageFlagBits stage, const std::filesystem::path &path) {
+        const auto &shader_module = shader_modules.emplace_back(create_shader_module(ctx, path));
 
-    const vector shader_stages{
-        vert_shader_stage_info,
-        frag_shader_stage_info
+        shader_stages.push_back({
+            .stage = stage,
+            .module = *shader_module,
+            .pName = "main",
+        });
     };
 
+    if (uses_mesh_shaders) {
+        if (!task_shader_path.empty()) {
+            add_stage(vk::ShaderStageFlagBits::eTaskEXT, task_shader_path);
+        }
+
+        add_stage(vk::ShaderStageFlagBits::eMeshEXT, mesh_shader_path);
+    } else {
+        add_stage(vk::ShaderStageFlagBits::eVertex, vertex_shader_path);
+    }
+
+    add_stage(vk::ShaderStageFlagBits::eFragment, fragment_shader_path);
+
     const vk::PipelineVertexInputStateCreateInfo vertex_input_info{
         .vertexBindingDescriptionCount = static_cast<uint32_t>(vertex_bindings.size()),
         .pVertexBindingDescriptions = vertex_bindings.data(),
@@ -190,6 +208,7 @@ GraphicsPipeline GraphicsPipelineBuilder::create(const RendererContext &ctx) con
     };
 
     result.layout = make_unique<vk::raii::PipelineLayout>(*ctx.device, pipeline_layout_info);
+    result.push_constant_ranges = push_constant_ranges;
 
     const vk::StructureChain<
         vk::GraphicsPipelineCreateInfo,
@@ -198,8 +217,9 @@ GraphicsPipeline GraphicsPipelineBuilder::create(const RendererContext &ctx) con
         {
             .stageCount = static_cast<uint32_t>(shader_stages.size()),
             .pStages = shader_stages.data(),
-            .pVertexInputState = &vertex_input_info,
-            .pInputAssemblyState = &input_assembly,
+            // mesh shaders assemble their primitives themselves
+            .pVertexInputState = uses_mesh_shaders ? nullptr : &vertex_input_info,
+            .pInputAssemblyState = uses_mesh_shaders ? nullptr : &input_assembly,
             .pViewportState = &viewport_state,
             .pRasterizationState = &rasterizer,
             .pMultisampleState = &multisampling,
@@ -226,19 +246,80 @@ GraphicsPipeline GraphicsPipelineBuilder::create(const RendererContext &ctx) con
 }
 
 void GraphicsPipelineBuilder::check_params() const {
-    if (vertex_shader_path.empty()) {
-        Logger::error("vertex shader must be specified during pipeline creation!");
+    if (vertex_shader_path.empty() && mesh_shader_path.empty()) {
+        Logger::error("vertex or mesh shader must be specified during pipeline creation!");
+    }
+
+    if (!vertex_shader_path.empty() && !mesh_shader_path.empty()) {
+        Logger::error("vertex and mesh shaders can't be specified together during pipeline creation!");
+    }
+
+    if (!task_shader_path.empty() && mesh_shader_path.empty()) {
+        Logger::error("task shader can't be specified without a mesh shader during pipeline creation!");
     }
 
     if (fragment_shader_path.empty()) {
         Logger::error("fragment shader must be specified during pipeline creation!");
     }
 
-    if (vertex_bindings.empty() && vertex_attributes.empty()) {
+    if (mesh_shader_path.empty() && vertex_bindings.empty() && vertex_attributes.empty()) {
         Logger::error("vertex descriptions must be specified during pipeline creation!");
     }
 }
 
+ComputePipelineBuilder &ComputePipelineBuilder::with_compute_shader(const std::filesystem::path &path) {
+    compute_shader_path = path;
+    return *this;
+}
+
+ComputePipelineBuilder &
+ComputePipelineBuilder::with_descriptor_layouts(const vector<vk::DescriptorSetLayout> &layouts) {
+    descriptor_set_layouts = layouts;
+    return *this;
+}
+
+ComputePipelineBuilder &ComputePipelineBuilder::with_push_constants(const vector<vk::PushConstantRange> &ranges) {
+    push_constant_ranges = ranges;
+    return *this;
+}
+
+ComputePipeline ComputePipelineBuilder::create(const RendererContext &ctx) const {
+    check_params();
+
+    ComputePipeline result;
+
+    const vk::raii::ShaderModule compute_shader_module = create_shader_module(ctx, compute_shader_path);
+
+    const vk::PipelineLayoutCreateInfo pipeline_layout_info{
+        .setLayoutCount = static_cast<uint32_t>(descriptor_set_layouts.size()),
+        .pSetLayouts = descriptor_set_layouts.empty() ? nullptr : descriptor_set_layouts.data(),
+        .pushConstantRangeCount = static_cast<uint32_t>(push_constant_ranges.size()),
+        .pPushConstantRanges = push_constant_ranges.empty() ? nullptr : push_constant_ranges.data()
+    };
+
+    result.layout = make_unique<vk::raii::PipelineLayout>(*ctx.device, pipeline_layout_info);
+    result.push_constant_ranges = push_constant_ranges;
+
+    const vk::ComputePipelineCreateInfo pipeline_create_info{
+        .stage = {
+            .stage = vk::ShaderStageFlagBits::eCompute,
+            .module = *compute_shader_module,
+            .pName = "main",
+        },
+        .layout = **result.layout,
+    };
+
+    result.pipeline = make_unique<vk::raii::Pipeline>(*ctx.device, nullptr, pipeline_create_info);
+
+    return result;
+}
+
+void ComputePipelineBuilder::check_params() const {
+    if (compute_shader_path.empty()) {
+        Logger::error("compute shader must be specified during compute pipeline creation!");
+    }
+}
+
 RtPipelineBuilder &RtPipelineBuilder::with_ray_gen_shader(const std::filesystem::path &path) {
     raygen_shader_path = path;
     return *this;
@@ -270,6 +351,7 @@ RtPipeline RtPipelineBuilder::create(const RendererContext &ctx) const {
     auto [pipeline, layout] = build_pipeline(ctx);
     result.pipeline         = make_unique<decltype(pipeline)>(std::move(pipeline));
     result.layout           = make_unique<decltype(layout)>(std::move(layout));
+    result.push_constant_ranges = push_constant_ranges;
 
     result.sbt = build_sbt(ctx, *result.pipeline);
 
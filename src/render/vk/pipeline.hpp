@@ -17,8 +17,10 @@ class Buffer;
 class Pipeline {
     unique_ptr<vk::raii::Pipeline> pipeline;
     unique_ptr<vk::raii::PipelineLayout> layout;
+    vector<vk::PushConstantRange> push_constant_ranges;
 
     friend class GraphicsPipelineBuilder;
+    friend class ComputePipelineBuilder;
     friend class RtPipelineBuilder;
 
 protected:
@@ -28,10 +30,15 @@ public:
     [[nodiscard]] const vk::raii::Pipeline &operator*() const { return *pipeline; }
 
     [[nodiscard]] const vk::raii::PipelineLayout &get_layout() const { return *layout; }
+
+    [[nodiscard]] const vector<vk::PushConstantRange> &get_push_constant_ranges() const {
+        return push_constant_ranges;
+    }
 };
 
 class GraphicsPipeline : public Pipeline {
     vk::SampleCountFlagBits rasterization_samples{};
+    bool mesh_shading = false;
 
     friend class GraphicsPipelineBuilder;
 
@@ -39,6 +46,17 @@ class GraphicsPipeline : public Pipeline {
 
 public:
     [[nodiscard]] vk::SampleCountFlagBits get_sample_count() const { return rasterization_samples; }
+
+    /**
+     * Whether the pipeline's geometry comes from mesh shaders rather than from vertex buffers.
+     */
+    [[nodiscard]] bool uses_mesh_shaders() const { return mesh_shading; }
+};
+
+class ComputePipeline : public Pipeline {
+    friend class ComputePipelineBuilder;
+
+    ComputePipeline() = default;
 };
 
 class RtPipeline : public Pipeline {
@@ -67,6 +85,8 @@ public:
  */
 class GraphicsPipelineBuilder {
     std::filesystem::path vertex_shader_path;
+    std::filesystem::path task_shader_path;
+    std::filesystem::path mesh_shader_path;
     std::filesystem::path fragment_shader_path;
 
     vector<vk::VertexInputBindingDescription> vertex_bindings;
@@ -86,6 +106,16 @@ class GraphicsPipelineBuilder {
 public:
     GraphicsPipelineBuilder &with_vertex_shader(const std::filesystem::path &path);
 
+    /**
+     * Sets the optional task shader of a mesh shading pipeline, which needs `VK_EXT_mesh_shader`.
+     */
+    GraphicsPipelineBuilder &with_task_shader(const std::filesystem::path &path);
+
+    /**
+     * Sets the mesh shader, which replaces the vertex shader along with the vertex input and input assembly states.
+     */
+    GraphicsPipelineBuilder &with_mesh_shader(const std::filesystem::path &path);
+
     GraphicsPipelineBuilder &with_fragment_shader(const std::filesystem::path &path);
 
     template<typename T>
@@ -124,6 +154,28 @@ private:
     void check_params() const;
 };
 
+/**
+ * Builder class streamlining compute pipeline creation.
+ */
+class ComputePipelineBuilder {
+    std::filesystem::path compute_shader_path;
+
+    vector<vk::DescriptorSetLayout> descriptor_set_layouts;
+    vector<vk::PushConstantRange> push_constant_ranges;
+
+public:
+    ComputePipelineBuilder &with_compute_shader(const std::filesystem::path &path);
+
+    ComputePipelineBuilder &with_descriptor_layouts(const vector<vk::DescriptorSetLayout> &layouts);
+
+    ComputePipelineBuilder &with_push_constants(const vector<vk::PushConstantRange> &ranges);
+
+    [[nodiscard]] ComputePipeline create(const RendererContext &ctx) const;
+
+private:
+    void check_params() const;
+};
+
 class RtPipelineBuilder {
     std::filesystem::path raygen_shader_path;
     std::filesystem::path closest_hit_shader_path;
@@ -61,6 +61,8 @@ public:
 
     [[nodiscard]] vk::Extent2D get_extent() const { return extent; }
 
+    [[nodiscard]] const Image &get_depth_image() const { return *depth_image; }
+
     /**
      * Returns the index of the image that was most recently acquired and will be presented next.
      * @return Index of the current image.
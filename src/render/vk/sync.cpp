@@ -0,0 +1,196 @@
+#include "sync.hpp"
+
+#include "image.hpp"
+#include "buffer.hpp"
+
+namespace zrx {
+static constexpr vk::AccessFlags2 write_access_mask = vk::AccessFlagBits2::eShaderWrite
+                                                      | vk::AccessFlagBits2::eShaderStorageWrite
+                                                      | vk::AccessFlagBits2::eColorAttachmentWrite
+                                                      | vk::AccessFlagBits2::eDepthStencilAttachmentWrite
+                                                      | vk::AccessFlagBits2::eTransferWrite
+                                                      | vk::AccessFlagBits2::eHostWrite
+                                                      | vk::AccessFlagBits2::eMemoryWrite;
+
+bool ImageAccess::is_write() const {
+    return static_cast<bool>(access & write_access_mask);
+}
+
+std::optional<vk::ImageMemoryBarrier2> ImageSyncState::access(const ImageAccess &next, const Image &image,
+                                                              const uint32_t next_queue_family) {
+    const bool is_queue_change = queue_family != vk::QueueFamilyIgnored
+                                 && next_queue_family != vk::QueueFamilyIgnored
+                                 && queue_family != next_queue_family;
+
+    if (is_queue_change) {
+        // the semaphore between the queues already waits for all previous accesses and makes them visible
+        write_stages   = {};
+        write_access   = {};
+        visible_stages = {};
+        read_stages    = {};
+    }
+
+    if (next_queue_family != vk::QueueFamilyIgnored) {
+        queue_family = next_queue_family;
+    }
+
+    const bool is_layout_change = next.layout != layout;
+
+    vk::PipelineStageFlags2 src_stages{};
+    vk::AccessFlags2 src_access{};
+    bool needs_barrier = false;
+
+    if (next.is_write() || is_layout_change) {
+        // layout transitions are writes too, so both cases have to wait for all previous reads and writes
+        src_stages    = write_stages | read_stages;
+        src_access    = write_access;
+        needs_barrier = is_layout_change || static_cast<bool>(src_stages);
+    } else if (write_stages && (next.stages & ~visible_stages)) {
+        // read after write, where the write wasn't made visible to these stages yet
+        src_stages    = write_stages;
+        src_access    = write_access;
+        needs_barrier = true;
+    }
+
+    std::optional<vk::ImageMemoryBarrier2> barrier;
+
+    if (needs_barrier) {
+        // after a queue change, the transition has to chain with the semaphore wait, which covers all commands
+        const auto no_src_stages = is_queue_change
+                                       ? vk::PipelineStageFlagBits2::eAllCommands
+                                       : vk::PipelineStageFlagBits2::eNone;
+
+        barrier = vk::ImageMemoryBarrier2{
+            .srcStageMask = src_stages ? src_stages : no_src_stages,
+            .srcAccessMask = src_access,
+            .dstStageMask = next.stages,
+            .dstAccessMask = next.access,
+            .oldLayout = is_layout_change && next.discard_contents ? vk::ImageLayout::eUndefined : layout,
+            .newLayout = next.layout,
+            .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .image = **image,
+            .subresourceRange = image.get_subresource_range(),
+        };
+    }
+
+    if (next.is_write()) {
+        write_stages   = next.stages;
+        write_access   = next.access & write_access_mask;
+        visible_stages = {};
+        read_stages    = {};
+    } else if (is_layout_change) {
+        visible_stages = next.stages;
+        read_stages    = next.stages;
+    } else {
+        if (needs_barrier) visible_stages |= next.stages;
+        read_stages |= next.stages;
+    }
+
+    layout = next.layout;
+
+    return barrier;
+}
+
+void ImageSyncState::assume_written(const vk::ImageLayout new_layout, const vk::PipelineStageFlags2 stages,
+                                    const vk::AccessFlags2 access_mask, const vk::PipelineStageFlags2 visible_to) {
+    layout         = new_layout;
+    write_stages   = stages;
+    write_access   = access_mask & write_access_mask;
+    visible_stages = visible_to;
+    read_stages    = {};
+}
+
+ImageSyncState ImageSyncState::get_aliasing_state() const {
+    ImageSyncState result = *this;
+    result.layout         = vk::ImageLayout::eUndefined;
+    result.visible_stages = {};
+    return result;
+}
+
+bool BufferAccess::is_write() const {
+    return static_cast<bool>(access & write_access_mask);
+}
+
+std::optional<vk::BufferMemoryBarrier2> BufferSyncState::access(const BufferAccess &next, const Buffer &buffer,
+                                                                const uint32_t next_queue_family) {
+    const bool is_queue_change = queue_family != vk::QueueFamilyIgnored
+                                 && next_queue_family != vk::QueueFamilyIgnored
+                                 && queue_family != next_queue_family;
+
+    if (is_queue_change) {
+        // the semaphore between the queues already waits for all previous accesses and makes them visible
+        write_stages   = {};
+        write_access   = {};
+        visible_stages = {};
+        read_stages    = {};
+    }
+
+    if (next_queue_family != vk::QueueFamilyIgnored) {
+        queue_family = next_queue_family;
+    }
+
+    vk::PipelineStageFlags2 src_stages{};
+    vk::AccessFlags2 src_access{};
+
+    if (next.is_write()) {
+        src_stages = write_stages | read_stages;
+        src_access = write_access;
+    } else if (write_stages && (next.stages & ~visible_stages)) {
+        src_stages = write_stages;
+        src_access = write_access;
+    }
+
+    std::optional<vk::BufferMemoryBarrier2> barrier;
+
+    if (src_stages) {
+        barrier = vk::BufferMemoryBarrier2{
+            .srcStageMask = src_stages,
+            .srcAccessMask = src_access,
+            .dstStageMask = next.stages,
+            .dstAccessMask = next.access,
+            .srcQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .dstQueueFamilyIndex = vk::QueueFamilyIgnored,
+            .buffer = *buffer,
+            .offset = 0,
+            .size = vk::WholeSize,
+        };
+    }
+
+    if (next.is_write()) {
+        write_stages   = next.stages;
+        write_access   = next.access & write_access_mask;
+        visible_stages = {};
+        read_stages    = {};
+    } else {
+        if (barrier) visible_stages |= next.stages;
+        read_stages |= next.stages;
+    }
+
+    return barrier;
+}
+
+namespace utils::sync {
+    vk::PipelineStageFlags2 to_pipeline_stages(const vk::ShaderStageFlags shader_stages) {
+        vk::PipelineStageFlags2 result{};
+
+        if (shader_stages & vk::ShaderStageFlagBits::eVertex) {
+            result |= vk::PipelineStageFlagBits2::eVertexShader;
+        }
+        if (shader_stages & vk::ShaderStageFlagBits::eTaskEXT) {
+            result |= vk::PipelineStageFlagBits2::eTaskShaderEXT;
+        }
+        if (shader_stages & vk::ShaderStageFlagBits::eMeshEXT) {
+            result |= vk::PipelineStageFlagBits2::eMeshShaderEXT;
+        }
+        if (shader_stages & vk::ShaderStageFlagBits::eFragment) {
+            result |= vk::PipelineStageFlagBits2::eFragmentShader;
+        }
+        if (shader_stages & vk::ShaderStageFlagBits::eCompute) {
+            result |= vk::PipelineStageFlagBits2::eComputeShader;
+        }
+
+        return result;
+    }
+} // utils::sync
+} // zrx
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <optional>
+
+#include "src/render/libs.hpp"
+#include "src/render/globals.hpp"
+
+namespace zrx {
+class Image;
+class Buffer;
+
+/**
+ * Describes a single use of an image: the layout it has to be in, and the pipeline stages
+ * and access types with which it's going to be touched.
+ */
+struct ImageAccess {
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+    vk::PipelineStageFlags2 stages{};
+    vk::AccessFlags2 access{};
+
+    /**
+     * Whether the previous contents of the image can be thrown away, which allows transitioning
+     * the image from an undefined layout instead of preserving it.
+     */
+    bool discard_contents = false;
+
+    [[nodiscard]] bool is_write() const;
+};
+
+/**
+ * Tracks the synchronization state of a single image across consecutive accesses,
+ * so that only the barriers which are actually required are recorded.
+ */
+class ImageSyncState {
+    vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+
+    // stages and accesses of the last write, which have to be waited for by any following access
+    vk::PipelineStageFlags2 write_stages{};
+    vk::AccessFlags2 write_access{};
+
+    // stages to which the last write has already been made visible
+    vk::PipelineStageFlags2 visible_stages{};
+
+    // stages which read the image since the last write, which have to be waited for by the next write
+    vk::PipelineStageFlags2 read_stages{};
+
+    // queue family of the last access, for images shared concurrently between queues
+    uint32_t queue_family = vk::QueueFamilyIgnored;
+
+public:
+    ImageSyncState() = default;
+
+    explicit ImageSyncState(const vk::ImageLayout initial_layout) : layout(initial_layout) {
+    }
+
+    [[nodiscard]] vk::ImageLayout get_layout() const { return layout; }
+
+    /**
+     * Registers a new access to the image and returns a barrier which has to precede it,
+     * or nothing if the access is already correctly synchronized with previous ones.
+     *
+     * Accesses from another queue family are assumed to be ordered after the previous ones by a semaphore,
+     * so in that case a barrier is only needed to change the image's layout.
+     */
+    [[nodiscard]] std::optional<vk::ImageMemoryBarrier2>
+    access(const ImageAccess &next, const Image &image, uint32_t next_queue_family = vk::QueueFamilyIgnored);
+
+    /**
+     * Registers a write which happened outside of the tracked accesses, together with the barriers
+     * which already made it visible to `visible_to` stages in layout `new_layout`.
+     */
+    void assume_written(vk::ImageLayout new_layout, vk::PipelineStageFlags2 stages, vk::AccessFlags2 access_mask,
+                        vk::PipelineStageFlags2 visible_to);
+
+    /**
+     * Returns the state of another image which takes over this image's memory. Its contents are undefined,
+     * but its first access still has to wait for all previous accesses to this image.
+     */
+    [[nodiscard]] ImageSyncState get_aliasing_state() const;
+};
+
+/**
+ * Describes a single use of a buffer: the pipeline stages and access types with which it's going to be touched.
+ */
+struct BufferAccess {
+    vk::PipelineStageFlags2 stages{};
+    vk::AccessFlags2 access{};
+
+    [[nodiscard]] bool is_write() const;
+};
+
+/**
+ * Buffer counterpart of `ImageSyncState`. Buffers have no layouts, so barriers are only needed
+ * to order accesses which conflict with a previous write, or writes following any previous access.
+ */
+class BufferSyncState {
+    vk::PipelineStageFlags2 write_stages{};
+    vk::AccessFlags2 write_access{};
+    vk::PipelineStageFlags2 visible_stages{};
+    vk::PipelineStageFlags2 read_stages{};
+    uint32_t queue_family = vk::QueueFamilyIgnored;
+
+public:
+    /**
+     * Registers a new access to the buffer and returns a barrier which has to precede it,
+     * or nothing if the access is already correctly synchronized with previous ones.
+     */
+    [[nodiscard]] std::optional<vk::BufferMemoryBarrier2>
+    access(const BufferAccess &next, const Buffer &buffer, uint32_t next_queue_family = vk::QueueFamilyIgnored);
+};
+
+namespace utils::sync {
+    /**
+     * Converts a set of shader stages to the pipeline stages in which these shaders execute.
+     */
+    [[nodiscard]] vk::PipelineStageFlags2 to_pipeline_stages(vk::ShaderStageFlags shader_stages);
+}
+} // zrx
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <type_traits>
+
+#include "src/render/globals.hpp"
+#include "src/utils/logger.hpp"
+
+namespace zrx {
+/**
+ * Incremental 64-bit FNV-1a hash, used to detect whether data persisted between launches went stale.
+ * Trivially copyable values are hashed by their bytes, so they mustn't contain any padding.
+ */
+class Hasher {
+    std::uint64_t value = 14695981039346656037ULL;
+
+public:
+    Hasher &add_bytes(const void *data, const size_t size) {
+        const auto bytes = static_cast<const unsigned char *>(data);
+
+        for (size_t i = 0; i < size; i++) {
+            value ^= bytes[i];
+            value *= 1099511628211ULL;
+        }
+
+        return *this;
+    }
+
+    template<typename T>
+        requires std::is_trivially_copyable_v<T>
+    Hasher &add(const T &object) {
+        return add_bytes(&object, sizeof(T));
+    }
+
+    Hasher &add(const std::string_view str) {
+        add(str.size());
+        return add_bytes(str.data(), str.size());
+    }
+
+    Hasher &add(const std::string &str) {
+        return add(std::string_view(str));
+    }
+
+    Hasher &add(const std::filesystem::path &path) {
+        return add(std::string_view(path.generic_string()));
+    }
+
+    template<typename T>
+    Hasher &add(const vector<T> &elements) {
+        add(elements.size());
+        for (const auto &element: elements) add(element);
+        return *this;
+    }
+
+    Hasher &add_file_contents(const std::filesystem::path &path) {
+        std::ifstream file(path, std::ios::binary);
+
+        if (!file.is_open()) {
+            Logger::error("failed to open file: ", path.string());
+        }
+
+        // read in chunks rather than as a whole, so that large files aren't copied into memory first
+        constexpr size_t CHUNK_SIZE = 64 * 1024;
+        vector<char> chunk(CHUNK_SIZE);
+
+        file.seekg(0, std::ios::end);
+        add(static_cast<size_t>(file.tellg()));
+        file.seekg(0, std::ios::beg);
+
+        while (file) {
+            file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            add_bytes(chunk.data(), static_cast<size_t>(file.gcount()));
+        }
+
+        return *this;
+    }
+
+    [[nodiscard]] std::uint64_t get() const { return value; }
+};
+} // zrx
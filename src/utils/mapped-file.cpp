@@ -0,0 +1,118 @@
+#include "mapped-file.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zrx {
+#ifdef _WIN32
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path &path) {
+    MappedFile result;
+
+    result.file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (result.file_handle == INVALID_HANDLE_VALUE) {
+        result.file_handle = nullptr;
+        return {};
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(result.file_handle, &file_size) || file_size.QuadPart == 0) {
+        return {};
+    }
+
+    result.mapping_handle = CreateFileMappingW(result.file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!result.mapping_handle) {
+        return {};
+    }
+
+    const void *view = MapViewOfFile(result.mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        return {};
+    }
+
+    result.data = static_cast<const std::byte *>(view);
+    result.size = static_cast<size_t>(file_size.QuadPart);
+
+    return result;
+}
+
+void MappedFile::close() {
+    if (data) UnmapViewOfFile(data);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) CloseHandle(file_handle);
+
+    data           = nullptr;
+    mapping_handle = nullptr;
+    file_handle    = nullptr;
+}
+#else
+std::optional<MappedFile> MappedFile::open(const std::filesystem::path &path) {
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return {};
+    }
+
+    struct stat file_stat{};
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(file);
+        return {};
+    }
+
+    void *view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(file);
+
+    if (view == MAP_FAILED) {
+        return {};
+    }
+
+    MappedFile result;
+    result.data = static_cast<const std::byte *>(view);
+    result.size = static_cast<size_t>(file_stat.st_size);
+
+    return result;
+}
+
+void MappedFile::close() {
+    if (data) munmap(const_cast<std::byte *>(data), size);
+
+    data = nullptr;
+}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+
+#ifdef _WIN32
+        file_handle    = std::exchange(other.file_handle, nullptr);
+        mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+    }
+
+    return *this;
+}
+} // zrx
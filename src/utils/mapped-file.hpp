@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+
+namespace zrx {
+/**
+ * Read-only view of a whole file mapped into memory. Its pages are only read from the disk once they're accessed,
+ * and can be shared with the OS page cache, so that large files don't have to be copied into the process first.
+ */
+class MappedFile {
+    const std::byte *data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+    MappedFile() = default;
+
+public:
+    /**
+     * Maps the file at `path`, or returns nothing if it doesn't exist or can't be mapped.
+     */
+    [[nodiscard]] static std::optional<MappedFile> open(const std::filesystem::path &path);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &other) = delete;
+
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    [[nodiscard]] const std::byte *get_data() const { return data; }
+
+    [[nodiscard]] size_t get_size() const { return size; }
+
+private:
+    void close();
+};
+} // zrx
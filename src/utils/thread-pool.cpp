@@ -0,0 +1,52 @@
+#include "thread-pool.hpp"
+
+namespace zrx {
+ThreadPool::ThreadPool(const size_t thread_count) {
+    for (size_t i = 0; i < thread_count; i++) {
+        workers.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(tasks_mutex);
+        is_stopping = true;
+    }
+
+    tasks_cv.notify_all();
+
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+std::future<void> ThreadPool::submit(Task &&task) {
+    auto future = task.get_future();
+
+    {
+        std::lock_guard lock(tasks_mutex);
+        tasks.emplace(std::move(task));
+    }
+
+    tasks_cv.notify_one();
+    return future;
+}
+
+void ThreadPool::worker_loop(const size_t worker_index) {
+    while (true) {
+        Task task;
+
+        {
+            std::unique_lock lock(tasks_mutex);
+            tasks_cv.wait(lock, [this] { return is_stopping || !tasks.empty(); });
+
+            if (is_stopping && tasks.empty()) return;
+
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+
+        task(worker_index);
+    }
+}
+} // zrx
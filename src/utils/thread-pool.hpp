@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include "src/render/globals.hpp"
+
+namespace zrx {
+/**
+ * Fixed-size pool of worker threads executing submitted tasks in submission order.
+ * Each task is given the index of the worker running it, so that it can use per-worker resources
+ * (e.g. command pools) without any further synchronization.
+ */
+class ThreadPool {
+public:
+    using Task = std::packaged_task<void(size_t)>;
+
+private:
+    vector<std::thread> workers;
+    std::queue<Task> tasks;
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_cv;
+    bool is_stopping = false;
+
+public:
+    explicit ThreadPool(size_t thread_count);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &other) = delete;
+
+    ThreadPool(ThreadPool &&other) = delete;
+
+    ThreadPool &operator=(const ThreadPool &other) = delete;
+
+    ThreadPool &operator=(ThreadPool &&other) = delete;
+
+    [[nodiscard]] size_t size() const { return workers.size(); }
+
+    /**
+     * Queues a task for execution on one of the workers.
+     *
+     * @param task The task, receiving the index of the worker it runs on.
+     * @return Future which becomes ready once the task finishes, rethrowing anything the task threw.
+     */
+    [[nodiscard]] std::future<void> submit(Task &&task);
+
+private:
+    void worker_loop(size_t worker_index);
+};
+} // zrx